@@ -0,0 +1,615 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Source for xmlbench - parser and generator benchmarks
+//
+// Usage: xmlbench [--size bytes[K|M]] [--iterations n] [--seed n] [--shape name]
+//                 [--bench name] [--json file]
+//
+// Each benchmark runs once to warm up and then the requested number of times on every corpus
+// shape. A summary table goes to stderr and results go to stdout (or --json file) as JSON so
+// they can be compared between builds. Throughput is for the XML input when parsing - all of
+// it for a batch - or loading a snapshot of it, and for the XML output when generating.
+// Allocation counts come from the global operator new and only cover the last iteration.
+//
+// The libxml2 backends are only benchmarked when built with XMLLIB_BENCH_LIBXML2.
+
+#include "XMLBenchCorpus.h"
+
+#include "XMLBatchParser.h"
+#include "XMLDocument.h"
+#include "XMLFlatParser.h"
+#include "XMLNode.h"
+#include "XMLSAXSimple.h"
+#include "XMLSnapshot.h"
+
+#ifdef XMLLIB_BENCH_LIBXML2
+#include "XMLDOMlibxml2.h"
+#include "XMLGeneratorlibxml2.h"
+#include "XMLSAXlibxml2.h"
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <streambuf>
+#include <vector>
+
+using namespace xmllib;
+
+// Allocation counting
+
+uint64_t sAllocations = 0;
+uint64_t sAllocatedBytes = 0;
+
+#if __cplusplus >= 201103L
+#define XMLBENCH_THROW_BAD_ALLOC
+#define XMLBENCH_NOTHROW noexcept
+#else
+#define XMLBENCH_THROW_BAD_ALLOC throw(std::bad_alloc)
+#define XMLBENCH_NOTHROW throw()
+#endif
+
+void* operator new(size_t size) XMLBENCH_THROW_BAD_ALLOC
+{
+	// Batches allocate from several threads at once
+	__sync_fetch_and_add(&sAllocations, 1);
+	__sync_fetch_and_add(&sAllocatedBytes, size);
+	void* p = ::malloc(size != 0 ? size : 1);
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size) XMLBENCH_THROW_BAD_ALLOC
+{
+	return operator new(size);
+}
+
+void operator delete(void* p) XMLBENCH_NOTHROW
+{
+	::free(p);
+}
+
+void operator delete[](void* p) XMLBENCH_NOTHROW
+{
+	::free(p);
+}
+
+// Output stream that throws away everything written to it
+class CNullBuffer : public std::streambuf
+{
+public:
+	CNullBuffer()
+		{ mCount = 0; }
+
+	uint64_t Count() const
+		{ return mCount; }
+
+protected:
+	virtual int_type overflow(int_type c)
+	{
+		mCount++;
+		return traits_type::not_eof(c);
+	}
+	virtual std::streamsize xsputn(const char* s, std::streamsize n)
+	{
+		mCount += n;
+		return n;
+	}
+
+private:
+	uint64_t	mCount;
+};
+
+// Times one iteration of a benchmark and counts the allocations made inside it
+class CBenchRun
+{
+public:
+	CBenchRun()
+		{ mStart = mElapsed = 0.0; mAllocations = mAllocatedBytes = mBytes = 0; }
+
+	void Start()
+	{
+		mAllocations = sAllocations;
+		mAllocatedBytes = sAllocatedBytes;
+		mStart = Now();
+	}
+	void Stop()
+	{
+		mElapsed = Now() - mStart;
+		mAllocations = sAllocations - mAllocations;
+		mAllocatedBytes = sAllocatedBytes - mAllocatedBytes;
+	}
+
+	double		mElapsed;			// Seconds
+	uint64_t	mAllocations;
+	uint64_t	mAllocatedBytes;
+	uint64_t	mBytes;				// Bytes handled when not the input size
+
+private:
+	double		mStart;
+
+	static double Now()
+	{
+		struct timespec ts;
+		::clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ts.tv_sec + ts.tv_nsec / 1e9;
+	}
+};
+
+// Input shared by all benchmarks for one corpus shape
+struct SBenchInput
+{
+	const cdstring*	mData;
+	const char*		mFile;
+	XMLDocument*	mDocument;		// Parsed once for the generate benchmarks, NULL on error
+};
+
+typedef bool (*BenchProc)(const SBenchInput& input, CBenchRun& run);
+
+struct SBenchmark
+{
+	const char*	mName;
+	BenchProc	mProc;
+};
+
+struct SResult
+{
+	const char*	mBenchmark;
+	const char*	mShape;
+	uint64_t	mBytes;
+	uint32_t	mIterations;
+	double		mBest;
+	double		mMedian;
+	uint64_t	mAllocations;
+	uint64_t	mAllocatedBytes;
+	bool		mOK;
+};
+
+// Benchmarks
+
+const size_t cFeedChunk = 64 * 1024;
+const uint32_t cBatchCount = 16;
+
+bool SAXSimpleData(const SBenchInput& input, CBenchRun& run)
+{
+	run.Start();
+	XMLSAXSimple parser;
+	parser.ParseData(input.mData->c_str());
+	run.Stop();
+	return !parser.Failed() && (parser.Document() != NULL);
+}
+
+bool SAXSimpleFile(const SBenchInput& input, CBenchRun& run)
+{
+	run.Start();
+	XMLSAXSimple parser;
+	parser.ParseFile(input.mFile);
+	run.Stop();
+	return !parser.Failed() && (parser.Document() != NULL);
+}
+
+bool SAXSimpleStream(const SBenchInput& input, CBenchRun& run)
+{
+	std::ifstream is(input.mFile, std::ios::in | std::ios::binary);
+	run.Start();
+	XMLSAXSimple parser;
+	parser.ParseStream(is);
+	run.Stop();
+	return !parser.Failed() && (parser.Document() != NULL);
+}
+
+bool SAXSimpleFeed(const SBenchInput& input, CBenchRun& run)
+{
+	const char* p = input.mData->c_str();
+	size_t remaining = input.mData->length();
+	run.Start();
+	XMLSAXSimple parser;
+	bool result = true;
+	while(result && (remaining != 0))
+	{
+		size_t len = std::min(remaining, cFeedChunk);
+		result = parser.Feed(p, len);
+		p += len;
+		remaining -= len;
+	}
+	result = result && parser.Finish();
+	run.Stop();
+	return result && !parser.Failed();
+}
+
+bool SAXSimpleParallel(const SBenchInput& input, CBenchRun& run)
+{
+	run.Start();
+	XMLSAXSimple parser;
+	parser.ParseDataParallel(input.mData->c_str());
+	run.Stop();
+	return !parser.Failed() && (parser.Document() != NULL);
+}
+
+bool FlatParserData(const SBenchInput& input, CBenchRun& run)
+{
+	run.Start();
+	XMLFlatParser parser;
+	parser.ParseData(input.mData->c_str());
+	run.Stop();
+	return !parser.Failed() && (parser.FlatDocument() != NULL);
+}
+
+bool BatchData(const SBenchInput& input, CBenchRun& run)
+{
+	std::vector<const char*> data(cBatchCount, input.mData->c_str());
+	XMLDocumentList results;
+	run.Start();
+	XMLBatchParser parser;
+	parser.ParseData(data, results);
+	run.Stop();
+	run.mBytes = (uint64_t)input.mData->length() * cBatchCount;
+
+	bool result = true;
+	for(XMLDocumentList::iterator iter = results.begin(); iter != results.end(); iter++)
+	{
+		result = result && (*iter != NULL);
+		delete *iter;
+	}
+	return result;
+}
+
+bool DocumentGenerate(const SBenchInput& input, CBenchRun& run)
+{
+	if (input.mDocument == NULL)
+		return false;
+
+	CNullBuffer buffer;
+	std::ostream os(&buffer);
+	run.Start();
+	input.mDocument->Generate(os);
+	run.Stop();
+	run.mBytes = buffer.Count();
+	return os.good();
+}
+
+// Snapshots are read from memory so only the loading is timed
+static bool SnapshotData(const SBenchInput& input, std::vector<char>& data)
+{
+	if (input.mDocument == NULL)
+		return false;
+
+	std::ostringstream os;
+	if (!XMLSnapshot::Write(*input.mDocument, os))
+		return false;
+	std::string snapshot = os.str();
+	data.assign(snapshot.begin(), snapshot.end());
+	return !data.empty();
+}
+
+bool SnapshotOpen(const SBenchInput& input, CBenchRun& run)
+{
+	std::vector<char> data;
+	if (!SnapshotData(input, data))
+		return false;
+
+	run.Start();
+	XMLSnapshot snapshot;
+	bool result = snapshot.Open(&data[0], data.size());
+	run.Stop();
+	return result;
+}
+
+bool SnapshotMaterialize(const SBenchInput& input, CBenchRun& run)
+{
+	std::vector<char> data;
+	if (!SnapshotData(input, data))
+		return false;
+
+	run.Start();
+	XMLSnapshot snapshot;
+	XMLDocument* doc = snapshot.Open(&data[0], data.size()) ? snapshot.Materialize() : NULL;
+	run.Stop();
+	delete doc;
+	return doc != NULL;
+}
+
+#ifdef XMLLIB_BENCH_LIBXML2
+bool SAXlibxml2Data(const SBenchInput& input, CBenchRun& run)
+{
+	run.Start();
+	XMLSAXlibxml2 parser;
+	parser.ParseData(input.mData->c_str(), input.mData->length());
+	run.Stop();
+	return !parser.Failed() && (parser.Document() != NULL);
+}
+
+bool SAXlibxml2Feed(const SBenchInput& input, CBenchRun& run)
+{
+	const char* p = input.mData->c_str();
+	size_t remaining = input.mData->length();
+	run.Start();
+	XMLSAXlibxml2 parser;
+	bool result = true;
+	while(result && (remaining != 0))
+	{
+		size_t len = std::min(remaining, cFeedChunk);
+		result = parser.Feed(p, len);
+		p += len;
+		remaining -= len;
+	}
+	result = result && parser.Finish();
+	run.Stop();
+	return result && (parser.Document() != NULL);
+}
+
+bool SAXlibxml2File(const SBenchInput& input, CBenchRun& run)
+{
+	run.Start();
+	XMLSAXlibxml2 parser;
+	parser.ParseFile(input.mFile);
+	run.Stop();
+	return !parser.Failed() && (parser.Document() != NULL);
+}
+
+bool DOMlibxml2Data(const SBenchInput& input, CBenchRun& run)
+{
+	run.Start();
+	XMLDOMlibxml2 parser;
+	parser.ParseData(input.mData->c_str(), input.mData->length());
+	run.Stop();
+	return parser.Root() != NULL;
+}
+
+bool Generatorlibxml2(const SBenchInput& input, CBenchRun& run)
+{
+	if (input.mDocument == NULL)
+		return false;
+
+	CNullBuffer buffer;
+	std::ostream os(&buffer);
+	XMLGeneratorlibxml2 generator;
+	run.Start();
+	generator.Generate(input.mDocument->GetRoot(), os);
+	run.Stop();
+
+	// Nothing reaches the stream while the generator writes its own file - fall back to the input size
+	run.mBytes = buffer.Count();
+	return os.good();
+}
+#endif
+
+const SBenchmark cBenchmarks[] =
+{
+	{ "XMLSAXSimple::ParseData", SAXSimpleData },
+	{ "XMLSAXSimple::ParseFile", SAXSimpleFile },
+	{ "XMLSAXSimple::ParseStream", SAXSimpleStream },
+	{ "XMLSAXSimple::Feed", SAXSimpleFeed },
+	{ "XMLSAXSimple::ParseDataParallel", SAXSimpleParallel },
+	{ "XMLFlatParser::ParseData", FlatParserData },
+	{ "XMLBatchParser::ParseData", BatchData },
+	{ "XMLDocument::Generate", DocumentGenerate },
+	{ "XMLSnapshot::Open", SnapshotOpen },
+	{ "XMLSnapshot::Materialize", SnapshotMaterialize },
+#ifdef XMLLIB_BENCH_LIBXML2
+	{ "XMLSAXlibxml2::ParseData", SAXlibxml2Data },
+	{ "XMLSAXlibxml2::ParseFile", SAXlibxml2File },
+	{ "XMLSAXlibxml2::Feed", SAXlibxml2Feed },
+	{ "XMLDOMlibxml2::ParseData", DOMlibxml2Data },
+	{ "XMLGeneratorlibxml2::Generate", Generatorlibxml2 },
+#endif
+};
+const uint32_t cBenchmarkCount = sizeof(cBenchmarks) / sizeof(cBenchmarks[0]);
+
+SResult RunBenchmark(const SBenchmark& bench, const char* shape, const SBenchInput& input, uint32_t iterations)
+{
+	SResult result;
+	result.mBenchmark = bench.mName;
+	result.mShape = shape;
+	result.mBytes = input.mData->length();
+	result.mIterations = iterations;
+	result.mBest = result.mMedian = 0.0;
+	result.mAllocations = result.mAllocatedBytes = 0;
+
+	// Warm up caches and the file system before timing
+	CBenchRun run;
+	result.mOK = bench.mProc(input, run);
+
+	std::vector<double> times;
+	for(uint32_t i = 0; result.mOK && (i < iterations); i++)
+	{
+		run = CBenchRun();
+		result.mOK = bench.mProc(input, run);
+		times.push_back(run.mElapsed);
+	}
+	if (!result.mOK || times.empty())
+		return result;
+
+	std::sort(times.begin(), times.end());
+	result.mBest = times.front();
+	result.mMedian = times[times.size() / 2];
+	result.mAllocations = run.mAllocations;
+	result.mAllocatedBytes = run.mAllocatedBytes;
+	if (run.mBytes != 0)
+		result.mBytes = run.mBytes;
+
+	return result;
+}
+
+double Throughput(uint64_t bytes, double seconds)
+{
+	return (seconds > 0.0) ? (bytes / (1024.0 * 1024.0)) / seconds : 0.0;
+}
+
+void WriteJSON(FILE* out, const std::vector<SResult>& results, uint32_t size, uint32_t seed)
+{
+	::fprintf(out, "{\n\t\"size\": %u,\n\t\"seed\": %u,\n\t\"results\": [", size, seed);
+	for(std::vector<SResult>::const_iterator iter = results.begin(); iter != results.end(); iter++)
+	{
+		::fprintf(out, "%s\n\t\t{\"benchmark\": \"%s\", \"shape\": \"%s\", \"ok\": %s, \"bytes\": %llu, "
+						"\"iterations\": %u, \"best_ns\": %.0f, \"median_ns\": %.0f, "
+						"\"best_mb_per_s\": %.2f, \"median_mb_per_s\": %.2f, "
+						"\"allocations\": %llu, \"allocated_bytes\": %llu}",
+					(iter == results.begin()) ? "" : ",",
+					(*iter).mBenchmark, (*iter).mShape, (*iter).mOK ? "true" : "false",
+					(unsigned long long)(*iter).mBytes, (*iter).mIterations,
+					(*iter).mBest * 1e9, (*iter).mMedian * 1e9,
+					Throughput((*iter).mBytes, (*iter).mBest), Throughput((*iter).mBytes, (*iter).mMedian),
+					(unsigned long long)(*iter).mAllocations, (unsigned long long)(*iter).mAllocatedBytes);
+	}
+	::fprintf(out, "\n\t]\n}\n");
+}
+
+void WriteSummary(FILE* out, const SResult& result)
+{
+	if (result.mOK)
+		::fprintf(out, "%-32s %-11s %9.2f MB/s %9.2f MB/s %10llu allocs\n",
+					result.mBenchmark, result.mShape,
+					Throughput(result.mBytes, result.mBest), Throughput(result.mBytes, result.mMedian),
+					(unsigned long long)result.mAllocations);
+	else
+		::fprintf(out, "%-32s %-11s FAILED\n", result.mBenchmark, result.mShape);
+}
+
+uint32_t ParseSize(const char* arg)
+{
+	char* end = NULL;
+	unsigned long value = ::strtoul(arg, &end, 10);
+	if ((*end == 'k') || (*end == 'K'))
+		value *= 1024;
+	else if ((*end == 'm') || (*end == 'M'))
+		value *= 1024 * 1024;
+	return value;
+}
+
+void Usage()
+{
+	::fprintf(stderr, "Usage: xmlbench [--size bytes[K|M]] [--iterations n] [--seed n] [--shape name] [--bench name] [--json file]\n");
+	::fprintf(stderr, "Shapes:");
+	for(uint32_t i = 0; i < XMLBenchCorpus::eShapeCount; i++)
+		::fprintf(stderr, " %s", XMLBenchCorpus::ShapeName(static_cast<XMLBenchCorpus::EShape>(i)));
+	::fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t size = 4 * 1024 * 1024;
+	uint32_t iterations = 5;
+	uint32_t seed = 1;
+	const char* shape_filter = NULL;
+	const char* bench_filter = NULL;
+	const char* json = NULL;
+
+	for(int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+		if (value == NULL)
+		{
+			Usage();
+			return 1;
+		}
+
+		if (::strcmp(arg, "--size") == 0)
+			size = ParseSize(value);
+		else if (::strcmp(arg, "--iterations") == 0)
+			iterations = ::strtoul(value, NULL, 10);
+		else if (::strcmp(arg, "--seed") == 0)
+			seed = ::strtoul(value, NULL, 10);
+		else if (::strcmp(arg, "--shape") == 0)
+			shape_filter = value;
+		else if (::strcmp(arg, "--bench") == 0)
+			bench_filter = value;
+		else if (::strcmp(arg, "--json") == 0)
+			json = value;
+		else
+		{
+			Usage();
+			return 1;
+		}
+		i++;
+	}
+
+	XMLBenchCorpus::EShape only = XMLBenchCorpus::eShallow;
+	if ((shape_filter != NULL) && !XMLBenchCorpus::ShapeFromName(shape_filter, only))
+	{
+		Usage();
+		return 1;
+	}
+
+	// File based benchmarks read the corpus back from a temporary file
+	char path[] = "/tmp/xmlbenchXXXXXX";
+	int fd = ::mkstemp(path);
+	if (fd < 0)
+	{
+		::perror("mkstemp");
+		return 1;
+	}
+	::close(fd);
+
+	XMLBenchCorpus corpus(seed);
+	cdstring data;
+	std::vector<SResult> results;
+	bool failed = false;
+	for(uint32_t i = 0; i < XMLBenchCorpus::eShapeCount; i++)
+	{
+		XMLBenchCorpus::EShape shape = static_cast<XMLBenchCorpus::EShape>(i);
+		if ((shape_filter != NULL) && (shape != only))
+			continue;
+
+		corpus.Generate(shape, size, data);
+		{
+			std::ofstream os(path, std::ios::out | std::ios::binary | std::ios::trunc);
+			os.write(data.c_str(), data.length());
+		}
+
+		SBenchInput input;
+		input.mData = &data;
+		input.mFile = path;
+
+		XMLSAXSimple parser;
+		parser.ParseData(data.c_str());
+		input.mDocument = parser.Failed() ? NULL : parser.Document();
+
+		for(uint32_t j = 0; j < cBenchmarkCount; j++)
+		{
+			if ((bench_filter != NULL) && (::strstr(cBenchmarks[j].mName, bench_filter) == NULL))
+				continue;
+
+			results.push_back(RunBenchmark(cBenchmarks[j], XMLBenchCorpus::ShapeName(shape), input, iterations));
+			WriteSummary(stderr, results.back());
+			failed |= !results.back().mOK;
+		}
+	}
+	::unlink(path);
+
+	FILE* out = (json != NULL) ? ::fopen(json, "w") : stdout;
+	if (out == NULL)
+	{
+		::perror(json);
+		return 1;
+	}
+	WriteJSON(out, results, size, seed);
+	if (out != stdout)
+		::fclose(out);
+
+	return failed ? 2 : 0;
+}
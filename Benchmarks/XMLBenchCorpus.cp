@@ -0,0 +1,279 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Source for XMLBenchCorpus class
+
+#include "XMLBenchCorpus.h"
+
+#include <string.h>
+
+using namespace xmllib;
+
+const char* cShapeNames[] =
+{
+	"shallow",
+	"deep",
+	"attributes",
+	"text",
+	"entities",
+	"namespaces"
+};
+
+const char* cWords[] =
+{
+	"mailbox", "message", "folder", "header", "subject", "sender", "address", "calendar",
+	"event", "alarm", "contact", "server", "account", "quota", "flag", "seen",
+	"draft", "answered", "deleted", "recent", "body", "part", "envelope", "date",
+	"a", "an", "the", "of", "to", "in", "and", "with"
+};
+const uint32_t cWordCount = sizeof(cWords) / sizeof(cWords[0]);
+
+const char* cEntities[] =
+{
+	"&amp;", "&lt;", "&gt;", "&quot;", "&apos;", "&#65;", "&#x42;", "&#233;"
+};
+const uint32_t cEntityCount = sizeof(cEntities) / sizeof(cEntities[0]);
+
+XMLBenchCorpus::XMLBenchCorpus(uint32_t seed)
+{
+	mSeed = (seed != 0) ? seed : 1;
+	mState = mSeed;
+}
+
+const char* XMLBenchCorpus::ShapeName(EShape shape)
+{
+	return (shape < eShapeCount) ? cShapeNames[shape] : "";
+}
+
+bool XMLBenchCorpus::ShapeFromName(const char* name, EShape& shape)
+{
+	for(uint32_t i = 0; i < eShapeCount; i++)
+	{
+		if (::strcmp(name, cShapeNames[i]) == 0)
+		{
+			shape = static_cast<EShape>(i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void XMLBenchCorpus::Generate(EShape shape, uint32_t size, cdstring& out)
+{
+	// Every document starts from the seed so output does not depend on what came before
+	mState = mSeed;
+
+	out.clear();
+	out += "<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n";
+
+	switch(shape)
+	{
+	case eShallow:
+	default:
+		GenerateShallow(size, out);
+		break;
+	case eDeep:
+		GenerateDeep(size, out);
+		break;
+	case eAttributes:
+		GenerateAttributes(size, out);
+		break;
+	case eText:
+		GenerateText(size, out);
+		break;
+	case eEntities:
+		GenerateEntities(size, out);
+		break;
+	case eNamespaces:
+		GenerateNamespaces(size, out);
+		break;
+	}
+}
+
+// xorshift32 - fixed so the corpus is the same on every platform
+uint32_t XMLBenchCorpus::Random()
+{
+	mState ^= mState << 13;
+	mState ^= mState >> 17;
+	mState ^= mState << 5;
+	return mState;
+}
+
+void XMLBenchCorpus::Word(cdstring& out)
+{
+	out += cWords[Random(cWordCount)];
+}
+
+void XMLBenchCorpus::Words(uint32_t count, cdstring& out)
+{
+	for(uint32_t i = 0; i < count; i++)
+	{
+		if (i != 0)
+			out += " ";
+		Word(out);
+	}
+}
+
+void XMLBenchCorpus::Number(uint32_t value, cdstring& out)
+{
+	char buf[16];
+	char* p = buf + sizeof(buf);
+	*--p = 0;
+	do
+	{
+		*--p = '0' + (value % 10);
+		value /= 10;
+	} while(value != 0);
+	out += p;
+}
+
+void XMLBenchCorpus::GenerateShallow(uint32_t size, cdstring& out)
+{
+	out += "<items>\n";
+	for(uint32_t i = 0; out.length() < size; i++)
+	{
+		out += "\t<item id=\"";
+		Number(i, out);
+		out += "\">";
+		Words(1 + Random(4), out);
+		out += "</item>\n";
+	}
+	out += "</items>\n";
+}
+
+void XMLBenchCorpus::GenerateDeep(uint32_t size, cdstring& out)
+{
+	out += "<tree>\n";
+	while(out.length() < size)
+	{
+		// Chains of varying depth with a little text at each level
+		uint32_t depth = 32 + Random(96);
+		for(uint32_t i = 0; i < depth; i++)
+		{
+			out += "<node level=\"";
+			Number(i, out);
+			out += "\">";
+			Word(out);
+		}
+		for(uint32_t i = 0; i < depth; i++)
+			out += "</node>";
+		out += "\n";
+	}
+	out += "</tree>\n";
+}
+
+void XMLBenchCorpus::GenerateAttributes(uint32_t size, cdstring& out)
+{
+	out += "<records>\n";
+	for(uint32_t i = 0; out.length() < size; i++)
+	{
+		out += "\t<record";
+		uint32_t count = 8 + Random(9);
+		for(uint32_t j = 0; j < count; j++)
+		{
+			out += " ";
+			Word(out);
+			Number(j, out);
+			out += (j & 1) ? "='" : "=\"";
+			Words(1 + Random(3), out);
+			out += (j & 1) ? "'" : "\"";
+		}
+		out += "/>\n";
+	}
+	out += "</records>\n";
+}
+
+void XMLBenchCorpus::GenerateText(uint32_t size, cdstring& out)
+{
+	out += "<document>\n";
+	while(out.length() < size)
+	{
+		// Paragraphs of roughly 1 to 8 KB
+		out += "\t<para>";
+		Words(150 + Random(1000), out);
+		out += "</para>\n";
+	}
+	out += "</document>\n";
+}
+
+void XMLBenchCorpus::GenerateEntities(uint32_t size, cdstring& out)
+{
+	out += "<escaped>\n";
+	while(out.length() < size)
+	{
+		out += "\t<value note=\"";
+		Word(out);
+		out += cEntities[Random(cEntityCount)];
+		Word(out);
+		out += "\">";
+		uint32_t count = 4 + Random(12);
+		for(uint32_t i = 0; i < count; i++)
+		{
+			Word(out);
+			out += cEntities[Random(cEntityCount)];
+		}
+		out += "</value>\n";
+	}
+	out += "</escaped>\n";
+}
+
+void XMLBenchCorpus::GenerateNamespaces(uint32_t size, cdstring& out)
+{
+	out += "<D:multistatus xmlns:D=\"DAV:\" xmlns:C=\"urn:ietf:params:xml:ns:caldav\">\n";
+	for(uint32_t i = 0; out.length() < size; i++)
+	{
+		out += "\t<D:response>\n\t\t<D:href>/calendars/";
+		Word(out);
+		out += "/";
+		Number(i, out);
+		out += ".ics</D:href>\n\t\t<D:propstat>\n\t\t\t<D:prop>\n";
+
+		// Some properties in their own default namespace
+		uint32_t count = 1 + Random(4);
+		for(uint32_t j = 0; j < count; j++)
+		{
+			switch(Random(3))
+			{
+			case 0:
+				out += "\t\t\t\t<D:getetag>\"";
+				Number(Random(), out);
+				out += "\"</D:getetag>\n";
+				break;
+			case 1:
+				out += "\t\t\t\t<C:calendar-data C:content-type=\"text/calendar\">";
+				Words(4 + Random(8), out);
+				out += "</C:calendar-data>\n";
+				break;
+			default:
+				out += "\t\t\t\t<x";
+				Number(j, out);
+				out += ":";
+				Word(out);
+				out += " xmlns:x";
+				Number(j, out);
+				out += "=\"http://example.com/ns/";
+				Number(Random(16), out);
+				out += "\"/>\n\t\t\t\t<prop xmlns=\"http://example.com/default\">";
+				Word(out);
+				out += "</prop>\n";
+				break;
+			}
+		}
+		out += "\t\t\t</D:prop>\n\t\t\t<D:status>HTTP/1.1 200 OK</D:status>\n\t\t</D:propstat>\n\t</D:response>\n";
+	}
+	out += "</D:multistatus>\n";
+}
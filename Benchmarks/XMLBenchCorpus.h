@@ -0,0 +1,74 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Header for XMLBenchCorpus class
+
+#ifndef __XMLBENCHCORPUS__XMLLIB__
+#define __XMLBENCHCORPUS__XMLLIB__
+
+#include <stdint.h>
+
+#include "cdstring.h"
+
+namespace xmllib
+{
+
+// Generates benchmark documents. The same shape, size and seed always give the same bytes so
+// results can be compared across builds.
+
+class XMLBenchCorpus
+{
+public:
+	enum EShape
+	{
+		eShallow = 0,		// Many small children of the root
+		eDeep,				// Long chains of nested elements
+		eAttributes,		// Empty elements with many attributes
+		eText,				// Few elements with long runs of text
+		eEntities,			// Text and attribute values full of entity references
+		eNamespaces,		// Prefixed and default namespaces declared throughout
+		eShapeCount
+	};
+
+	XMLBenchCorpus(uint32_t seed = 1);
+
+	static const char* ShapeName(EShape shape);
+	static bool ShapeFromName(const char* name, EShape& shape);
+
+	// Document of roughly size bytes
+	void Generate(EShape shape, uint32_t size, cdstring& out);
+
+private:
+	uint32_t	mSeed;
+	uint32_t	mState;
+
+	uint32_t Random();
+	uint32_t Random(uint32_t range)
+		{ return Random() % range; }
+	void Word(cdstring& out);
+	void Words(uint32_t count, cdstring& out);
+	void Number(uint32_t value, cdstring& out);
+
+	void GenerateShallow(uint32_t size, cdstring& out);
+	void GenerateDeep(uint32_t size, cdstring& out);
+	void GenerateAttributes(uint32_t size, cdstring& out);
+	void GenerateText(uint32_t size, cdstring& out);
+	void GenerateEntities(uint32_t size, cdstring& out);
+	void GenerateNamespaces(uint32_t size, cdstring& out);
+};
+
+}
+#endif
@@ -16,9 +16,23 @@
 
 #include "CStreamBuffer.h"
 
+#include "XMLStats.h"
+
 #include <cstring>
 
-const int cBufferSize = 8192;
+#if defined(__unix__) || defined(__APPLE__)
+#define CSTREAMBUFFER_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const uint32_t cDefaultBufferSize = 64 * 1024;
+const uint32_t cDefaultMaxBufferSize = 64 * 1024 * 1024;
+const uint32_t cMinBufferSize = 16;
+const uint64_t cMaxPushSize = 0x80000000;		// Offsets into the buffer are 32-bit
+const char cEndOfData = 0;
 
 CStreamBuffer::CStreamBuffer()
 {
@@ -27,17 +41,19 @@ CStreamBuffer::CStreamBuffer()
 	bbegin = bnext = beof = bend = NULL;
 	bfail = false;
 	bcount = 0;
-	mStream = NULL;
+	mMapped = NULL;
+	mMappedSize = 0;
+	mPush = false;
+	mOwned = NULL;
+	mOwnedSize = 0;
+	mInitialSize = cDefaultBufferSize;
+	mMaxSize = cDefaultMaxBufferSize;
 }
 
 CStreamBuffer::~CStreamBuffer()
 {
-	// Only if no data
-	if (mData == NULL)
-	{
-		delete[] bbegin;
-		bbegin = bnext = bend = NULL;
-	}
+	Close();
+	delete[] mOwned;
 }
 
 const char* CStreamBuffer::operator++()	// ++p
@@ -46,14 +62,19 @@ const char* CStreamBuffer::operator++()	// ++p
 	return bnext;
 }
 
+// Points at a NUL at the end of the data, so callers must check fail() before relying on it
 const char* CStreamBuffer::operator++(int)	// p++
 {
 	// Make sure we have at least two bytes before we bump to the next one
 	// as we need to refer back to the previous one and don't want the buffer adjusted
 	NeedData(2);
 
-	get();
-	return bnext - 1;
+	// Refilling an empty buffer moves bnext back to the start, so there is no previous byte
+	if (!Fill())
+		return &cEndOfData;
+
+	bcount++;
+	return bnext++;
 }
 
 CStreamBuffer& CStreamBuffer::operator+=(uint32_t bump)
@@ -78,23 +99,212 @@ CStreamBuffer& CStreamBuffer::operator+=(uint32_t bump)
 
 void CStreamBuffer::SetStream(std::istream& is)
 {
-	// Create internal buffer
-	beof = bnext = bbegin = new char[cBufferSize];
-	bend = bbegin + cBufferSize;
+	Close();
+	ReleasePush();
+
+	// Internal buffer is kept from one stream to the next
+	UseOwned();
 
 	// Assign stream and read in first block
+	mData = NULL;
 	mStream = &is;
+	bfail = false;
+	bcount = 0;
 	FillFromStream();
 }
 
 void CStreamBuffer::SetData(const char* data)
 {
+	SetData(data, ::strlen(data));
+}
+
+void CStreamBuffer::SetData(const char* data, uint32_t length)
+{
+	Close();
+	ReleasePush();
+
 	// Assign data
+	mStream = NULL;
 	mData = data;
 	
 	// Set internal buffer
 	bnext = bbegin = mData;
-	beof = bend = bbegin + ::strlen(data);
+	beof = bend = bbegin + length;
+	bfail = false;
+	bcount = 0;
+}
+
+// Regular files are mapped read-only and then treated exactly like fixed data, so the
+// parser works directly on the mapped pages. Pipes, devices, empty files, files too large
+// for the 32-bit offsets and platforms without mmap return false so the caller can fall back
+// to reading a stream.
+bool CStreamBuffer::SetFile(const char* path)
+{
+#ifdef CSTREAMBUFFER_MMAP
+	int fd = ::open(path, O_RDONLY);
+	if (fd == -1)
+		return false;
+
+	struct stat st;
+	if ((::fstat(fd, &st) != 0) || !S_ISREG(st.st_mode) || (st.st_size <= 0) || ((uint64_t)st.st_size > 0xFFFFFFFFULL))
+	{
+		::close(fd);
+		return false;
+	}
+
+	void* mapped = ::mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapped == MAP_FAILED)
+		return false;
+
+	// We only ever read forwards
+	::madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+
+	// Drop any previous mapping
+	Close();
+	ReleasePush();
+	mMapped = mapped;
+	mMappedSize = st.st_size;
+
+	// Set internal buffer
+	mStream = NULL;
+	mData = static_cast<const char*>(mapped);
+	bnext = bbegin = mData;
+	beof = bend = bbegin + mMappedSize;
+	bfail = false;
+	bcount = 0;
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+void CStreamBuffer::Close()
+{
+#ifdef CSTREAMBUFFER_MMAP
+	if (mMapped != NULL)
+	{
+		::munmap(mMapped, mMappedSize);
+		mMapped = NULL;
+		mMappedSize = 0;
+
+		// Nothing left to point at
+		mData = NULL;
+		bbegin = bnext = beof = bend = NULL;
+	}
+#endif
+}
+
+// Pushed data goes in the internal buffer, so the buffer from a previous push or stream is reused
+void CStreamBuffer::SetPush()
+{
+	Close();
+	UseOwned();
+	mPush = true;
+
+	mStream = NULL;
+	mData = NULL;
+	bnext = beof = bbegin;
+	bfail = false;
+	bcount = 0;
+}
+
+// Append to the unconsumed data, dropping what has been consumed or growing the buffer
+// only when the new data does not fit after it. Fails, leaving the buffer as it was, if the
+// unconsumed data would need more than the maximum buffer size.
+bool CStreamBuffer::Push(const char* data, uint32_t length)
+{
+	if (!mPush)
+		return false;
+
+	if (length > (uint32_t)(bend - beof))
+	{
+		// Sizes are worked out in 64 bits so neither the total nor the doubling can wrap
+		uint64_t pending = beof - bnext;
+		uint64_t needed = pending + length;
+		uint64_t limit = (mMaxSize < cMaxPushSize) ? mMaxSize : cMaxPushSize;
+		if (needed > limit)
+			return false;
+		uint64_t size = bend - bbegin;
+		if (size < cMinBufferSize)
+			size = cMinBufferSize;
+		while(size < needed)
+			size *= 2;
+		if (size > limit)
+			size = limit;
+
+		if (size != (uint64_t)(bend - bbegin))
+		{
+			char* buffer = new char[size];
+			::memcpy(buffer, bnext, pending);
+			delete[] mOwned;
+			mOwned = buffer;
+			mOwnedSize = (uint32_t)size;
+			bbegin = buffer;
+			bend = bbegin + size;
+			XMLLIB_STATS_COUNT(eBufferGrowths, 1);
+		}
+		else
+		{
+			::memmove(const_cast<char*>(bbegin), bnext, pending);
+			XMLLIB_STATS_COUNT(eBytesMoved, pending);
+		}
+		bnext = bbegin;
+		beof = bbegin + pending;
+	}
+
+	::memcpy(const_cast<char*>(beof), data, length);
+	beof += length;
+
+	// No longer at the end of the data
+	bfail = false;
+
+	return true;
+}
+
+void CStreamBuffer::SetBufferSize(uint32_t initial, uint32_t maximum)
+{
+	mInitialSize = (initial > cMinBufferSize) ? initial : cMinBufferSize;
+	mMaxSize = (maximum > mInitialSize) ? maximum : mInitialSize;
+}
+
+// The internal buffer itself is kept for the next stream or push
+void CStreamBuffer::ReleasePush()
+{
+	if (mPush)
+	{
+		bbegin = bnext = beof = bend = NULL;
+		mPush = false;
+	}
+}
+
+void CStreamBuffer::Reset()
+{
+	Close();
+	ReleasePush();
+
+	mStream = NULL;
+	mData = NULL;
+	bbegin = bnext = beof = bend = NULL;
+	bfail = false;
+	bcount = 0;
+}
+
+// Point the buffer at the internal storage, only allocating it the first time or when the
+// sizes have changed so it no longer fits them. One grown for a long token is kept.
+void CStreamBuffer::UseOwned()
+{
+	if ((mOwned == NULL) || (mOwnedSize < mInitialSize) || (mOwnedSize > mMaxSize))
+	{
+		delete[] mOwned;
+		mOwned = NULL;
+		mOwned = new char[mInitialSize];
+		mOwnedSize = mInitialSize;
+	}
+
+	bnext = beof = bbegin = mOwned;
+	bend = bbegin + mOwnedSize;
 }
 
 char CStreamBuffer::get()
@@ -102,7 +312,7 @@ char CStreamBuffer::get()
 	// Load more into buffer
 	if (bnext == beof)
 	{
-		ReadMore();
+		ReadMore(1);
 	}
 	
 	// If no more then we are done
@@ -124,10 +334,11 @@ void CStreamBuffer::FillFromStream()
 
 	// Read as much fromt he stream as possible
 	
-	// Stream must be working
+	// Stream must be working - but what was read before it ended can still be used
 	if (mStream->fail())
 	{
-		bfail = true;
+		if (bnext == beof)
+			bfail = true;
 		return;
 	}
 	
@@ -139,6 +350,8 @@ void CStreamBuffer::FillFromStream()
 	
 	// Adjust for the amount actually read in
 	beof += mStream->gcount();
+	XMLLIB_STATS_COUNT(eBufferRefills, 1);
+	XMLLIB_STATS_COUNT(eBytesRead, mStream->gcount());
 }
 
 void CStreamBuffer::NeedData(uint32_t amount)
@@ -146,28 +359,79 @@ void CStreamBuffer::NeedData(uint32_t amount)
 	// Ensure that remaining data in buffer is at least amount bytes long
 	if (Remaining() < amount)
 	{
-		ReadMore();
+		ReadMore(amount);
 	}
 }
 
-void CStreamBuffer::ReadMore()
+// Make sure there is at least one byte available, flagging failure at the end of the data
+bool CStreamBuffer::Fill()
 {
-	// Not if using fixed buffer
-	if (mData != NULL)
+	if (bnext == beof)
+		ReadMore(1);
+
+	if (bnext == beof)
+	{
+		bfail = true;
+		return false;
+	}
+
+	return true;
+}
+
+bool CStreamBuffer::SkipTo(char c)
+{
+	while(Fill())
+	{
+		// Look for it in what we have, consuming everything if not present
+		const char* found = xmllib::XMLScan(bnext, beof, c);
+		bcount += found - bnext;
+		bnext = found;
+		if (found != beof)
+			return true;
+	}
+
+	return false;
+}
+
+// Read more so that at least amount bytes are available from the current position if the
+// stream has them. Reads go into the space after the unconsumed data, which is only moved
+// down once that space is under half the buffer, or copied into a larger buffer when the
+// buffer cannot hold amount at all.
+void CStreamBuffer::ReadMore(uint32_t amount)
+{
+	// Not if using fixed buffer, and push buffers are only added to by Push
+	if ((mData != NULL) || mPush)
 		return;
 
-	uint32_t bytes_used = bnext - bbegin;
-	uint32_t bytes_to_copy = beof - bnext;
-	if (bytes_to_copy != 0)
+	uint32_t pending = beof - bnext;
+	uint32_t size = bend - bbegin;
+	if ((amount > size) && (size < mMaxSize))
+	{
+		while((size < amount) && (size < mMaxSize))
+			size = (size > mMaxSize / 2) ? mMaxSize : size * 2;
+
+		char* buffer = new char[size];
+		::memcpy(buffer, bnext, pending);
+		delete[] mOwned;
+		mOwned = buffer;
+		mOwnedSize = size;
+		bbegin = bnext = buffer;
+		beof = bbegin + pending;
+		bend = bbegin + size;
+		XMLLIB_STATS_COUNT(eBufferGrowths, 1);
+	}
+	else if ((pending == 0) || ((uint32_t)(bend - bnext) < amount) || ((uint32_t)(bend - beof) < size / 2))
 	{
 		// Shift down the remaining bytes so we can append some more
-		::memmove(const_cast<char*>(bbegin), bnext, bytes_to_copy);
+		if (pending != 0)
+		{
+			::memmove(const_cast<char*>(bbegin), bnext, pending);
+			XMLLIB_STATS_COUNT(eBytesMoved, pending);
+		}
+		bnext = bbegin;
+		beof = bbegin + pending;
 	}
 
-	// Adjust buffer pointers
-	bnext = bbegin;
-	beof -= bytes_used;
-
 	// Fill remaining
 	FillFromStream();
 }
@@ -17,7 +17,10 @@
 #ifndef CStreamBuffer_H
 #define CStreamBuffer_H
 
+#include "XMLScan.h"
+
 #include <stdint.h>
+#include <cstring>
 #include <istream>
 
 class CStreamBuffer
@@ -28,10 +31,26 @@ public:
 
 	void SetStream(std::istream& is);
 	void SetData(const char* data);
+	void SetData(const char* data, uint32_t length);	// Need not be NUL terminated
+	bool SetFile(const char* path);		// Map a regular file under 4GB - false if it cannot be mapped
+	void Close();						// Release any mapped file
+	void Reset();						// Detach from the data - the internal buffer is kept for reuse
+
+	// Push mode - data is appended by the caller rather than read from a stream. Push fails if
+	// the unconsumed data would need a buffer larger than the maximum size.
+	void SetPush();
+	bool Push(const char* data, uint32_t length);
+
+	// Size of the internal buffer for streams and pushed data. It starts at initial and doubles,
+	// up to maximum, whenever more of a token is needed at once than it can hold. Push buffers
+	// hold all the unconsumed data, so a pushed token larger than maximum fails the parse. Takes
+	// effect from the next stream or push. Defaults to 64K and 64M.
+	void SetBufferSize(uint32_t initial, uint32_t maximum);
 
+	// Mapped files have no trailing NUL so never dereference the end of the data
 	char operator*()
 	{
-		return *bnext;
+		return (bnext != beof) ? *bnext : 0;
 	}
 
 	const char* operator++();	// ++p
@@ -39,11 +58,37 @@ public:
 
 	CStreamBuffer& operator+=(uint32_t bump);
 
+	// Fixed buffers are never refilled so pointers into them stay valid. Push buffers only
+	// move when more data is pushed, never while it is being parsed.
+	bool IsFixed() const
+	{
+		return (mData != NULL) || mPush;
+	}
+
 	bool HasData() const
 	{
 		return bnext != bbegin;
 	}
 	void NeedData(uint32_t amount);
+	bool Fill();
+
+	// Bulk scanning - the count of bytes from the current position up to the first of
+	// the given bytes, looking only at data already in the buffer
+	uint32_t Span(char c1) const
+	{
+		return xmllib::XMLScan(bnext, beof, c1) - bnext;
+	}
+	uint32_t Span(char c1, char c2) const
+	{
+		return xmllib::XMLScan(bnext, beof, c1, c2) - bnext;
+	}
+	uint32_t Span(char c1, char c2, char c3) const
+	{
+		return xmllib::XMLScan(bnext, beof, c1, c2, c3) - bnext;
+	}
+
+	// Advance to the next occurrence of the byte, refilling as needed - false if not found
+	bool SkipTo(char c);
 
 	const char* next()
 	{
@@ -58,6 +103,13 @@ public:
 		return beof - bnext;
 	}
 
+	// Whether the data at the current position starts with the given bytes
+	bool StartsWith(const char* str, uint32_t length)
+	{
+		NeedData(length);
+		return (Remaining() >= length) && (::memcmp(bnext, str, length) == 0);
+	}
+
 	bool fail() const
 	{
 		return bfail;
@@ -72,10 +124,20 @@ private:
 	const char* 	bend;
 	bool			bfail;
 	uint32_t		bcount;
+	void*			mMapped;
+	size_t			mMappedSize;
+	bool			mPush;
+	char*			mOwned;			// Internal buffer for streams and pushed data
+	uint32_t		mOwnedSize;
+	uint32_t		mInitialSize;
+	uint32_t		mMaxSize;
 
 	char get();
 
-	void ReadMore();
+	void UseOwned();
+	void ReleasePush();
+
+	void ReadMore(uint32_t amount);
 	void FillFromStream();
 };
 
@@ -0,0 +1,175 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Source for XMLArena class
+
+#include "XMLArena.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+using namespace xmllib;
+
+// All allocations are aligned to this
+const size_t cArenaAlignment = 2 * sizeof(void*);
+
+// Block header size rounded up to keep the payload aligned
+const size_t XMLArena::cHeaderSize = (sizeof(XMLArena::SBlock) + cArenaAlignment - 1) & ~(cArenaAlignment - 1);
+
+XMLArena::XMLArena(size_t block_size)
+{
+	mBlocks = NULL;
+	mSpare = NULL;
+	mNext = mEnd = NULL;
+	mBlockSize = (block_size != 0) ? block_size : cDefaultBlockSize;
+	mUsed = 0;
+	mCapacity = 0;
+}
+
+XMLArena::~XMLArena()
+{
+	Release();
+}
+
+void* XMLArena::Allocate(size_t size)
+{
+	// Keep everything aligned
+	size = (size + cArenaAlignment - 1) & ~(cArenaAlignment - 1);
+	if (size == 0)
+		size = cArenaAlignment;
+
+	// Fast path - bump within the current block
+	if (size <= (size_t)(mEnd - mNext))
+	{
+		void* result = mNext;
+		mNext += size;
+		mUsed += size;
+		return result;
+	}
+
+	return AllocateBlock(size);
+}
+
+char* XMLArena::Copy(const char* data, size_t length)
+{
+	char* result = static_cast<char*>(Allocate(length + 1));
+	if (length != 0)
+		::memcpy(result, data, length);
+	result[length] = 0;
+	return result;
+}
+
+void XMLArena::Reset()
+{
+	if (mBlocks == NULL)
+		return;
+
+	// Bumping starts again in the current block and the others are kept for when it fills up
+	SBlock* block = mBlocks->mNext;
+	while(block != NULL)
+	{
+		SBlock* next = block->mNext;
+		block->mNext = mSpare;
+		mSpare = block;
+		block = next;
+	}
+	mBlocks->mNext = NULL;
+
+	mNext = reinterpret_cast<char*>(mBlocks) + cHeaderSize;
+	mEnd = mNext + mBlocks->mSize;
+	mUsed = 0;
+}
+
+void XMLArena::Release()
+{
+	for(int list = 0; list < 2; list++)
+	{
+		SBlock* block = (list == 0) ? mBlocks : mSpare;
+		while(block != NULL)
+		{
+			SBlock* next = block->mNext;
+			std::free(block);
+			block = next;
+		}
+	}
+
+	mBlocks = NULL;
+	mSpare = NULL;
+	mNext = mEnd = NULL;
+	mUsed = 0;
+	mCapacity = 0;
+}
+
+void* XMLArena::AllocateBlock(size_t size)
+{
+	// Large requests get a dedicated block so they do not waste the remainder of the current one
+	bool dedicated = (size > mBlockSize / 4);
+	size_t block_size = dedicated ? size : mBlockSize;
+
+	// Blocks kept by Reset are used before allocating any more
+	SBlock* block = TakeSpare(size);
+	bool spare = (block != NULL);
+	if (spare)
+		block_size = block->mSize;
+	else
+	{
+		block = static_cast<SBlock*>(std::malloc(cHeaderSize + block_size));
+		if (block == NULL)
+			throw std::bad_alloc();
+		block->mSize = block_size;
+		mCapacity += block_size;
+	}
+	mUsed += size;
+
+	char* payload = reinterpret_cast<char*>(block) + cHeaderSize;
+
+	if (dedicated && (mBlocks != NULL))
+	{
+		// Insert behind the current block so bumping continues there
+		block->mNext = mBlocks->mNext;
+		mBlocks->mNext = block;
+		return payload;
+	}
+
+	// New current block
+	block->mNext = mBlocks;
+	mBlocks = block;
+	mNext = payload + size;
+	mEnd = payload + block_size;
+
+	// Grow geometrically so large documents need only a handful of blocks
+	if (!dedicated && !spare && (mBlockSize < cMaxBlockSize))
+		mBlockSize *= 2;
+
+	return payload;
+}
+
+// First kept block with room for the allocation
+XMLArena::SBlock* XMLArena::TakeSpare(size_t size)
+{
+	for(SBlock** link = &mSpare; *link != NULL; link = &(*link)->mNext)
+	{
+		if ((*link)->mSize >= size)
+		{
+			SBlock* block = *link;
+			*link = block->mNext;
+			return block;
+		}
+	}
+
+	return NULL;
+}
@@ -0,0 +1,83 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Header for XMLArena class
+
+#ifndef __XMLARENA__XMLLIB__
+#define __XMLARENA__XMLLIB__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace xmllib
+{
+
+// Monotonic (bump) allocator. Memory is handed out from large blocks and is only
+// returned to the system when the arena is released or destroyed. Objects placed in
+// the arena must still have their destructors run by their owner, but no per-object
+// free is ever done.
+
+class XMLArena
+{
+public:
+	explicit XMLArena(size_t block_size = cDefaultBlockSize);
+	~XMLArena();
+
+	void* Allocate(size_t size);
+	char* Copy(const char* data, size_t length);		// Returns a NUL-terminated copy
+
+	void Reset();				// Discard all allocations but keep the blocks for re-use
+	void Release();				// Discard all allocations and free all blocks
+
+	size_t Used() const
+	{
+		return mUsed;
+	}
+	size_t Capacity() const
+	{
+		return mCapacity;
+	}
+
+	static const size_t cDefaultBlockSize = 8192;
+	static const size_t cMaxBlockSize = 1024 * 1024;
+
+private:
+	struct SBlock
+	{
+		SBlock*		mNext;
+		size_t		mSize;			// Usable bytes following the header
+	};
+
+	static const size_t cHeaderSize;
+
+	SBlock*		mBlocks;			// Current block first
+	SBlock*		mSpare;				// Blocks kept by Reset that are not in use
+	char*		mNext;
+	char*		mEnd;
+	size_t		mBlockSize;			// Size of the next regular block
+	size_t		mUsed;
+	size_t		mCapacity;
+
+	void* AllocateBlock(size_t size);
+	SBlock* TakeSpare(size_t size);
+
+	// Not copyable
+	XMLArena(const XMLArena& copy);
+	XMLArena& operator=(const XMLArena& copy);
+};
+
+}
+#endif
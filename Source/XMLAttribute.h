@@ -19,8 +19,12 @@
 #ifndef __XMLATTRIBUTE__XMLLIB__
 #define __XMLATTRIBUTE__XMLLIB__
 
+#include "XMLArena.h"
+#include "XMLNameTable.h"
+
 #include <list>
 #include <map>
+#include <new>
 
 #include "cdstring.h"
 
@@ -35,35 +39,79 @@ class XMLAttribute
 {
 public:
 	XMLAttribute(const cdstring& name, const cdstring& value = cdstring::null_str)
-		{ mName = name; mValue = value; }
+		{ mName = name; mValue = value; mNames = NULL; mNameID = XMLNameTable::cNoName; mInArena = false; }
 	explicit XMLAttribute(const XMLAttribute& copy)
-		{ _copy(copy); }
+		{ mNames = NULL; mNameID = XMLNameTable::cNoName; _copy(copy); mInArena = false; }
+
+	// Create in an arena - these must be deleted via XMLAttribute_Delete
+	static XMLAttribute* Create(XMLArena& arena, const cdstring& name, const cdstring& value = cdstring::null_str)
+	{
+		XMLAttribute* result = new(arena.Allocate(sizeof(XMLAttribute))) XMLAttribute(name, value);
+		result->mInArena = true;
+		return result;
+	}
+	static XMLAttribute* Create(XMLArena& arena, const XMLAttribute& copy)
+	{
+		XMLAttribute* result = new(arena.Allocate(sizeof(XMLAttribute))) XMLAttribute(copy);
+		result->mInArena = true;
+		return result;
+	}
 
 	XMLAttribute& operator=(const XMLAttribute& copy)
 		{ if (this != &copy) _copy(copy); return *this; }
 	
+	// Attributes in a node keep only the id of their name in the document's table
 	const cdstring& Name() const
-		{ return mName; }
+		{ return (mNames != NULL) ? mNames->Name(mNameID) : mName; }
 	void SetName(const cdstring& name)
-		{ mName = name; }
+		{ if (mNames != NULL) mNameID = mNames->Intern(name); else mName = name; }
+
+	// Interned in the document's name table, or cNoName if not in a node
+	uint32_t NameID() const
+		{ return mNameID; }
 
 	const cdstring& Value() const
 		{ return mValue; }
 	void SetValue(const cdstring& value)
 		{ mValue = value; }
 
+	bool InArena() const
+		{ return mInArena; }
+
 private:
-	cdstring	mName;
-	cdstring	mValue;
+	friend class XMLNode;
+	friend class XMLSnapshot;
+
+	cdstring		mName;				// Only while not in a node
+	cdstring		mValue;
+	XMLNameTable*	mNames;				// Table of the document once in a node
+	uint32_t		mNameID;
+	bool			mInArena;
 	
+	// An attribute already in a node stays there and re-interns the copied name
 	void _copy(const XMLAttribute& copy)
-		{ mName = copy.mName; mValue = copy.mValue; }
+		{ SetName(copy.Name()); mValue = copy.mValue; }
+
+	// Switch to the interned name when added to a node
+	void Attach(XMLNameTable& names, uint32_t id)
+		{ mNames = &names; mNameID = id; mName.clear(); }
 };
 
+// Arena attributes only need their destructor run - the arena owns the memory
+inline void XMLAttribute_Delete(XMLAttribute* attr)
+{
+	if (attr == NULL)
+		return;
+	if (attr->InArena())
+		attr->~XMLAttribute();
+	else
+		delete attr;
+}
+
 inline void XMLAttributeList_DeleteItems(XMLAttributeList& list)
 {
 	for(XMLAttributeList::iterator iter = list.begin(); iter != list.end(); iter++)
-		delete *iter;
+		XMLAttribute_Delete(*iter);
 }
 
 }
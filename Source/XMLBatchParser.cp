@@ -0,0 +1,191 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Source for XMLBatchParser class
+
+#include "XMLBatchParser.h"
+
+#include "XMLDocument.h"
+#include "XMLMutex.h"
+#include "XMLSAXSimple.h"
+#include "XMLThread.h"
+
+using namespace xmllib;
+
+struct XMLBatchParser::SWorker
+{
+	XMLBatchParser*	mOwner;
+	uint32_t		mIndex;
+	XMLSAXSimple	mParser;
+	XMLThread		mThread;
+
+	// Inputs still to be parsed by this worker, the front taken by the worker itself and the
+	// back by others stealing from it
+	XMLMutex		mLock;
+	uint32_t		mBegin;
+	uint32_t		mEnd;
+};
+
+XMLBatchParser::XMLBatchParser(uint32_t threads)
+{
+	mData = NULL;
+	mFiles = NULL;
+	mResults = NULL;
+
+	if (threads == 0)
+		threads = XMLThread::Processors();
+	for(uint32_t i = 0; i < threads; i++)
+	{
+		SWorker* worker = new SWorker;
+		worker->mOwner = this;
+		worker->mIndex = i;
+		worker->mBegin = worker->mEnd = 0;
+		mWorkers.push_back(worker);
+	}
+}
+
+XMLBatchParser::~XMLBatchParser()
+{
+	for(std::vector<SWorker*>::iterator iter = mWorkers.begin(); iter != mWorkers.end(); iter++)
+		delete *iter;
+}
+
+void XMLBatchParser::SetProjection(const XMLProjection* projection)
+{
+	for(std::vector<SWorker*>::iterator iter = mWorkers.begin(); iter != mWorkers.end(); iter++)
+		(*iter)->mParser.SetProjection(projection);
+}
+
+void XMLBatchParser::ParseData(const std::vector<const char*>& data, XMLDocumentList& results)
+{
+	mData = &data;
+	mFiles = NULL;
+	Run(data.size(), results);
+	mData = NULL;
+}
+
+void XMLBatchParser::ParseFiles(const cdstrvect& files, XMLDocumentList& results)
+{
+	mData = NULL;
+	mFiles = &files;
+	Run(files.size(), results);
+	mFiles = NULL;
+}
+
+void XMLBatchParser::Run(uint32_t count, XMLDocumentList& results)
+{
+	results.assign(count, NULL);
+	if (count == 0)
+		return;
+	mResults = &results;
+
+	// No more threads than inputs
+	uint32_t threads = (count < mWorkers.size()) ? count : mWorkers.size();
+
+	// Contiguous runs of inputs per thread - anything uneven is evened out by stealing
+	uint32_t begin = 0;
+	for(uint32_t i = 0; i < mWorkers.size(); i++)
+	{
+		uint32_t share = (i < threads) ? (count - begin) / (threads - i) : 0;
+		mWorkers[i]->mBegin = begin;
+		mWorkers[i]->mEnd = begin + share;
+		begin += share;
+	}
+
+	// The calling thread does its share as the first worker. The inputs of any thread that
+	// cannot be started are stolen by the others.
+	for(uint32_t i = 1; i < threads; i++)
+		mWorkers[i]->mThread.Start(_Work, mWorkers[i]);
+	Work(*mWorkers[0]);
+	for(uint32_t i = 1; i < threads; i++)
+		mWorkers[i]->mThread.Join();
+
+	mResults = NULL;
+}
+
+void XMLBatchParser::_Work(void* worker)
+{
+	SWorker* self = static_cast<SWorker*>(worker);
+	self->mOwner->Work(*self);
+}
+
+void XMLBatchParser::Work(SWorker& worker)
+{
+	uint32_t index;
+	while(Take(worker, index) || Steal(worker, index))
+		Parse(worker, index);
+}
+
+bool XMLBatchParser::Take(SWorker& worker, uint32_t& index)
+{
+	XMLMutexLock lock(worker.mLock);
+	if (worker.mBegin == worker.mEnd)
+		return false;
+
+	index = worker.mBegin++;
+	return true;
+}
+
+// Take the back half of another worker's inputs, starting with the next worker along so
+// thieves spread out. Nothing is ever added to a batch, so once no one has anything left
+// the batch is done.
+bool XMLBatchParser::Steal(SWorker& worker, uint32_t& index)
+{
+	for(uint32_t i = 1; i < mWorkers.size(); i++)
+	{
+		SWorker& victim = *mWorkers[(worker.mIndex + i) % mWorkers.size()];
+		uint32_t begin;
+		uint32_t end;
+		{
+			XMLMutexLock lock(victim.mLock);
+			uint32_t remaining = victim.mEnd - victim.mBegin;
+			if (remaining == 0)
+				continue;
+			end = victim.mEnd;
+			victim.mEnd -= (remaining + 1) / 2;
+			begin = victim.mEnd;
+		}
+
+		// Parse the first now and keep the rest
+		XMLMutexLock lock(worker.mLock);
+		index = begin;
+		worker.mBegin = begin + 1;
+		worker.mEnd = end;
+		return true;
+	}
+
+	return false;
+}
+
+void XMLBatchParser::Parse(SWorker& worker, uint32_t index)
+{
+	XMLSAXSimple& parser = worker.mParser;
+	try
+	{
+		parser.Reset();
+		if (mData != NULL)
+			parser.ParseData((*mData)[index]);
+		else
+			parser.ParseFile((*mFiles)[index].c_str());
+
+		if (!parser.Failed())
+			(*mResults)[index] = parser.ReleaseDocument();
+	}
+	catch(...)
+	{
+		// Nothing may escape the thread - the document is just left out
+	}
+}
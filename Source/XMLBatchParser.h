@@ -0,0 +1,82 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Header for XMLBatchParser class
+
+#ifndef __XMLBATCHPARSER__XMLLIB__
+#define __XMLBATCHPARSER__XMLLIB__
+
+#include "cdstring.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace xmllib
+{
+
+class XMLDocument;
+class XMLProjection;
+
+typedef std::vector<XMLDocument*> XMLDocumentList;
+
+// Parses many independent documents at once across a set of threads. Each thread keeps its
+// own parser, reset between documents so its working storage is reused. Inputs are split
+// evenly between the threads up front and a thread that runs out takes half of what is left
+// from another, so uneven document sizes still keep every thread busy.
+
+class XMLBatchParser
+{
+public:
+	// Defaults to one thread per processor
+	explicit XMLBatchParser(uint32_t threads = 0);
+	~XMLBatchParser();
+
+	uint32_t Threads() const
+	{
+		return mWorkers.size();
+	}
+
+	// Applied to every document - see XMLParserSAX::SetProjection
+	void SetProjection(const XMLProjection* projection);
+
+	// Each result is the document for the input in the same position, or NULL if it could not
+	// be parsed. The documents belong to the caller.
+	void ParseData(const std::vector<const char*>& data, XMLDocumentList& results);
+	void ParseFiles(const cdstrvect& files, XMLDocumentList& results);
+
+private:
+	struct SWorker;
+
+	std::vector<SWorker*>			mWorkers;
+	const std::vector<const char*>*	mData;				// Inputs of the current batch
+	const cdstrvect*				mFiles;
+	XMLDocumentList*				mResults;
+
+	void Run(uint32_t count, XMLDocumentList& results);
+
+	static void _Work(void* worker);
+	void Work(SWorker& worker);
+	bool Take(SWorker& worker, uint32_t& index);
+	bool Steal(SWorker& worker, uint32_t& index);
+	void Parse(SWorker& worker, uint32_t index);
+
+	// Not copyable
+	XMLBatchParser(const XMLBatchParser& copy);
+	XMLBatchParser& operator=(const XMLBatchParser& copy);
+};
+
+}
+#endif
@@ -0,0 +1,405 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Source for value conversion utilities
+
+#include "XMLConvert.h"
+
+#include <cfloat>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace xmllib
+{
+
+const uint64_t cMaxUnsigned32 = 0xFFFFFFFFULL;
+const uint64_t cMaxSigned32 = 0x7FFFFFFFULL;
+const uint64_t cMaxUnsigned64 = 0xFFFFFFFFFFFFFFFFULL;
+const uint64_t cMaxSigned64 = 0x7FFFFFFFFFFFFFFFULL;
+
+// Doubles up to 2^53 and powers of ten up to 10^22 are exact, so one multiply or divide
+// gives the correctly rounded result
+const uint64_t cMaxExactMantissa = 1ULL << 53;
+const int cMaxExactPower = 22;
+const double cPowers[cMaxExactPower + 1] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool IsSpace(char c)
+{
+	return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r');
+}
+
+static inline bool IsDigit(char c)
+{
+	return (c >= '0') && (c <= '9');
+}
+
+// Drop whitespace around the value - false if nothing is left
+static bool Trim(const char*& p, const char*& end)
+{
+	while((p < end) && IsSpace(*p))
+		p++;
+	while((end > p) && IsSpace(end[-1]))
+		end--;
+	return p < end;
+}
+
+static bool Matches(const char* p, const char* end, const char* text)
+{
+	size_t length = ::strlen(text);
+	return ((size_t)(end - p) == length) && (::memcmp(p, text, length) == 0);
+}
+
+// Nothing but digits, at most max
+static bool ParseDigits(const char* p, const char* end, uint64_t max, uint64_t& value)
+{
+	if (p == end)
+		return false;
+
+	uint64_t result = 0;
+	for(; p < end; p++)
+	{
+		if (!IsDigit(*p))
+			return false;
+		uint32_t digit = *p - '0';
+		if (result > (max - digit) / 10)
+			return false;
+		result = result * 10 + digit;
+	}
+
+	value = result;
+	return true;
+}
+
+static bool ParseUnsigned(const char* p, size_t length, uint64_t max, uint64_t& value)
+{
+	const char* end = p + length;
+	if (!Trim(p, end))
+		return false;
+	if (*p == '+')
+		p++;
+
+	return ParseDigits(p, end, max, value);
+}
+
+// The most negative value has a magnitude one more than max
+static bool ParseSigned(const char* p, size_t length, uint64_t max, int64_t& value)
+{
+	const char* end = p + length;
+	if (!Trim(p, end))
+		return false;
+	bool negative = (*p == '-');
+	if (negative || (*p == '+'))
+		p++;
+
+	uint64_t magnitude;
+	if (!ParseDigits(p, end, negative ? max + 1 : max, magnitude))
+		return false;
+
+	value = negative ? ((magnitude == 0) ? 0 : -(int64_t)(magnitude - 1) - 1) : (int64_t)magnitude;
+	return true;
+}
+
+// Anything the fast path cannot do exactly goes to strtod, which wants the locale's decimal point
+static bool ParseDoubleSlow(const char* p, const char* end, double& value)
+{
+	char point = '.';
+	const char* locale_point = ::localeconv()->decimal_point;
+	if ((locale_point != NULL) && (locale_point[0] != 0) && (locale_point[1] == 0))
+		point = locale_point[0];
+
+	cdstring text(p, end - p);
+	if (point != '.')
+	{
+		cdstring::size_type pos = text.find('.');
+		if (pos != cdstring::npos)
+			text[pos] = point;
+	}
+
+	char* stop = NULL;
+	double result = ::strtod(text.c_str(), &stop);
+	if ((stop != text.c_str() + text.length()) || (result == HUGE_VAL) || (result == -HUGE_VAL))
+		return false;
+
+	value = result;
+	return true;
+}
+
+static size_t FormatMagnitude(uint64_t value, bool negative, char* out)
+{
+	char digits[24];
+	char* p = digits + sizeof(digits);
+	do
+	{
+		*--p = '0' + (char)(value % 10);
+		value /= 10;
+	} while(value != 0);
+
+	size_t length = 0;
+	if (negative)
+		out[length++] = '-';
+	size_t count = digits + sizeof(digits) - p;
+	::memcpy(out + length, p, count);
+	length += count;
+	out[length] = 0;
+	return length;
+}
+
+static size_t FormatSigned(int64_t value, char* out)
+{
+	if (value < 0)
+		return FormatMagnitude((uint64_t)(-(value + 1)) + 1, true, out);
+	else
+		return FormatMagnitude(value, false, out);
+}
+
+// sprintf uses the locale's decimal point
+static size_t FormatDouble(double value, int precision, char* out)
+{
+	int length = ::sprintf(out, "%.*g", precision, value);
+	const char* locale_point = ::localeconv()->decimal_point;
+	if ((locale_point != NULL) && (locale_point[0] != '.') && (locale_point[0] != 0) && (locale_point[1] == 0))
+	{
+		char* point = ::strchr(out, locale_point[0]);
+		if (point != NULL)
+			*point = '.';
+	}
+	return length;
+}
+
+bool XMLParseValue(const char* p, size_t length, uint32_t& value)
+{
+	uint64_t result;
+	if (!ParseUnsigned(p, length, cMaxUnsigned32, result))
+		return false;
+	value = (uint32_t)result;
+	return true;
+}
+
+bool XMLParseValue(const char* p, size_t length, int32_t& value)
+{
+	int64_t result;
+	if (!ParseSigned(p, length, cMaxSigned32, result))
+		return false;
+	value = (int32_t)result;
+	return true;
+}
+
+bool XMLParseValue(const char* p, size_t length, uint64_t& value)
+{
+	return ParseUnsigned(p, length, cMaxUnsigned64, value);
+}
+
+bool XMLParseValue(const char* p, size_t length, int64_t& value)
+{
+	return ParseSigned(p, length, cMaxSigned64, value);
+}
+
+bool XMLParseValue(const char* p, size_t length, double& value)
+{
+	const char* end = p + length;
+	if (!Trim(p, end))
+		return false;
+
+	if (Matches(p, end, "INF") || Matches(p, end, "+INF"))
+	{
+		value = std::numeric_limits<double>::infinity();
+		return true;
+	}
+	if (Matches(p, end, "-INF"))
+	{
+		value = -std::numeric_limits<double>::infinity();
+		return true;
+	}
+	if (Matches(p, end, "NaN"))
+	{
+		value = std::numeric_limits<double>::quiet_NaN();
+		return true;
+	}
+
+	// Up to 19 significant digits fit in the mantissa, any more only change the exponent
+	const char* start = p;
+	bool negative = (*p == '-');
+	if (negative || (*p == '+'))
+		p++;
+	uint64_t mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool any = false;
+	bool dropped = false;
+	for(; (p < end) && IsDigit(*p); p++)
+	{
+		any = true;
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + (*p - '0');
+			if (mantissa != 0)
+				digits++;
+		}
+		else
+		{
+			exponent++;
+			dropped = dropped || (*p != '0');
+		}
+	}
+	if ((p < end) && (*p == '.'))
+	{
+		for(p++; (p < end) && IsDigit(*p); p++)
+		{
+			any = true;
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				if (mantissa != 0)
+					digits++;
+				exponent--;
+			}
+			else
+				dropped = dropped || (*p != '0');
+		}
+	}
+	if (!any)
+		return false;
+
+	if ((p < end) && ((*p == 'e') || (*p == 'E')))
+	{
+		p++;
+		bool negative_exponent = (p < end) && (*p == '-');
+		if ((p < end) && ((*p == '-') || (*p == '+')))
+			p++;
+		if ((p == end) || !IsDigit(*p))
+			return false;
+		int power = 0;
+		for(; (p < end) && IsDigit(*p); p++)
+		{
+			if (power < 100000)
+				power = power * 10 + (*p - '0');
+		}
+		exponent += negative_exponent ? -power : power;
+	}
+	if (p != end)
+		return false;
+
+	if (mantissa == 0)
+	{
+		value = negative ? -0.0 : 0.0;
+		return true;
+	}
+	if (dropped || (mantissa > cMaxExactMantissa) || (exponent < -cMaxExactPower) || (exponent > cMaxExactPower))
+		return ParseDoubleSlow(start, end, value);
+
+	double result = (double)mantissa;
+	if (exponent < 0)
+		result /= cPowers[-exponent];
+	else
+		result *= cPowers[exponent];
+	value = negative ? -result : result;
+	return true;
+}
+
+bool XMLParseValue(const char* p, size_t length, bool& value)
+{
+	const char* end = p + length;
+	if (!Trim(p, end))
+		return false;
+
+	if (Matches(p, end, "true") || Matches(p, end, "1"))
+	{
+		value = true;
+		return true;
+	}
+	else if (Matches(p, end, "false") || Matches(p, end, "0"))
+	{
+		value = false;
+		return true;
+	}
+	else
+		return false;
+}
+
+bool XMLParseEnum(const char* p, size_t length, const char** sarray, uint32_t& index)
+{
+	for(uint32_t i = 0; sarray[i] != NULL; i++)
+	{
+		if (Matches(p, p + length, sarray[i]))
+		{
+			index = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+size_t XMLFormatValue(uint32_t value, char* out)
+{
+	return FormatMagnitude(value, false, out);
+}
+
+size_t XMLFormatValue(int32_t value, char* out)
+{
+	return FormatSigned(value, out);
+}
+
+size_t XMLFormatValue(uint64_t value, char* out)
+{
+	return FormatMagnitude(value, false, out);
+}
+
+size_t XMLFormatValue(int64_t value, char* out)
+{
+	return FormatSigned(value, out);
+}
+
+// The shortest of 15 or 17 significant digits that reads back as the same value
+size_t XMLFormatValue(double value, char* out)
+{
+	const char* special = NULL;
+	if (value != value)
+		special = "NaN";
+	else if (value > DBL_MAX)
+		special = "INF";
+	else if (value < -DBL_MAX)
+		special = "-INF";
+	if (special != NULL)
+	{
+		::strcpy(out, special);
+		return ::strlen(special);
+	}
+
+	size_t length = FormatDouble(value, 15, out);
+	double check;
+	if (XMLParseValue(out, length, check) && (check == value))
+		return length;
+
+	return FormatDouble(value, 17, out);
+}
+
+size_t XMLFormatValue(bool value, char* out)
+{
+	const char* text = value ? "true" : "false";
+	::strcpy(out, text);
+	return ::strlen(text);
+}
+
+}
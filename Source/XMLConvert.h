@@ -0,0 +1,69 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Header for value conversion utilities
+
+#ifndef __XMLCONVERT__XMLLIB__
+#define __XMLCONVERT__XMLLIB__
+
+#include "XMLStringView.h"
+
+#include "cdstring.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace xmllib
+{
+
+// Conversion between values and their text in documents, working directly on the characters
+// so no strings are made. Numbers are read and written the same way whatever the process
+// locale. Whitespace around a value is ignored when reading, but empty text, anything else
+// that is not part of the value, or a value out of range for the type returns false and
+// leaves the value alone. Booleans are "true"/"false" or "1"/"0", and doubles also accept
+// "INF", "-INF" and "NaN", as in XML Schema.
+
+const size_t cXMLMaxValueLength = 32;				// Longest value written, including the NUL
+
+bool XMLParseValue(const char* p, size_t length, uint32_t& value);
+bool XMLParseValue(const char* p, size_t length, int32_t& value);
+bool XMLParseValue(const char* p, size_t length, uint64_t& value);
+bool XMLParseValue(const char* p, size_t length, int64_t& value);
+bool XMLParseValue(const char* p, size_t length, double& value);
+bool XMLParseValue(const char* p, size_t length, bool& value);
+
+template <class T> inline bool XMLParseValue(const XMLStringView& text, T& value)
+{
+	return XMLParseValue(text.Data(), text.Length(), value);
+}
+template <class T> inline bool XMLParseValue(const cdstring& text, T& value)
+{
+	return XMLParseValue(text.c_str(), text.length(), value);
+}
+
+// Index of the text in a NULL terminated array, compared exactly
+bool XMLParseEnum(const char* p, size_t length, const char** sarray, uint32_t& index);
+
+// Write into out, which must have room for cXMLMaxValueLength - returns the length
+size_t XMLFormatValue(uint32_t value, char* out);
+size_t XMLFormatValue(int32_t value, char* out);
+size_t XMLFormatValue(uint64_t value, char* out);
+size_t XMLFormatValue(int64_t value, char* out);
+size_t XMLFormatValue(double value, char* out);
+size_t XMLFormatValue(bool value, char* out);
+
+}
+#endif
@@ -18,219 +18,63 @@
 
 #include "XMLDOMlibxml2.h"
 
-#include <libxml/parserInternals.h>
-
-#include <cstdarg>
-#include <strstream>
+#include "XMLDocument.h"
 
 using namespace xmllib;
 
 XMLDOMlibxml2::XMLDOMlibxml2()
 {
-	mRoot = NULL;
-	mParseContext = NULL;
-
-	xmlSAXHandler handlers =
-	{
-		NULL,						// internalSubset
-		NULL,						// isStandalone
-		NULL,						// hasInternalSubset
-		NULL,						// hasExternalSubset
-		NULL,						// resolveEntity
-		NULL,						// getEntity
-		NULL,						// entityDecl
-		NULL,						// notationDecl
-		NULL,						// attributeDecl
-		NULL,						// elementDecl
-		NULL,						// unparsedEntityDecl
-		NULL,						// setDocumentLocator
-		_StartDocument,				// startDocument
-		_EndDocument,				// endDocument
-		_StartElement,				// startElement
-		_EndElement,				// endElement
-		NULL,						// reference
-		_Characters,				// characters
-		NULL,						// ignorableWhitespace
-		NULL,						// processingInstruction
-		_Comment,					// comment
-		_Warning,					// warning
-		_Error,						// error
-		_FatalError,				// fatalError
-		NULL,						// getParameterEntity
-		NULL,						// cdataBlock
-		NULL						// externalSubset
-	};
-	mSAXHandler = handlers;
-	
-	mError = false;
+	mPushing = false;
 }
 
 XMLDOMlibxml2::~XMLDOMlibxml2()
 {
-	if(mParseContext)
-		::xmlFreeParserCtxt(mParseContext);
 }
 
-void XMLSAXlibxml2::ParseData(const char* data)
+// Every parse starts afresh, keeping the context and storage of the last one
+void XMLDOMlibxml2::ParseData(const char* data)
 {
-	mParseContext = ::xmlCreateFileParserCtxt("test.xml");
-
-	mParseContext->sax = &mSAXHandler;
-	mParseContext->userData = this;
-
-	::xmlKeepBlanksDefault(0);
-
-	::xmlParseDocument(mParseContext);
-
-	mParseContext->sax = NULL;
-	::xmlFreeParserCtxt(mParseContext);
-	mParseContext = NULL;
+	mParser.Reset();
+	mParser.ParseData(data);
 }
 
-void XMLSAXlibxml2::ParseFile(const char* file)
+void XMLDOMlibxml2::ParseData(const char* data, size_t length)
 {
-	mParseContext = ::xmlCreateFileParserCtxt(file);
-
-	mParseContext->sax = &mSAXHandler;
-	mParseContext->userData = this;
-
-	::xmlKeepBlanksDefault(0);
-
-	::xmlParseDocument(mParseContext);
-
-	mParseContext->sax = NULL;
-	::xmlFreeParserCtxt(mParseContext);
-	mParseContext = NULL;
+	mParser.Reset();
+	mParser.ParseData(data, length);
 }
 
-void XMLDOMlibxml2::HandleException(const std::exception& ex)
+void XMLDOMlibxml2::ParseFile(const char* file)
 {
-	mError = true;
-	::xmlStopParser(mParseContext);
+	mParser.Reset();
+	mParser.ParseFile(file);
 }
 
-#pragma mark ____________________________callbacks
-
-void XMLDOMlibxml2::_StartDocument(void* parser)
-{
-	// Get parser object
-	XMLDOMlibxml2* xmlparser = static_cast<XMLDOMlibxml2*>(parser);
-
-	// Add a default (empty) root item
-	xmlparser->mRoot = new XMLNode(std::string());
-	xmlparser->mNodeList.push_back(xmlparser->mRoot);
-
-};
-
-void XMLDOMlibxml2::_EndDocument(void* parser)
-{
-	// Nothing to do
-};
-
-void XMLDOMlibxml2::_StartElement(void* parser, const xmlChar* name, const xmlChar** p)
-{
-	// Get parser object
-	XMLDOMlibxml2* xmlparser = static_cast<XMLDOMlibxml2*>(parser);
-
-	// Don't bother if on error state
-	if (xmlparser->mError)
-		return;
-
-	try
-	{
-		// Create a new node
-		XMLNode* node = new XMLNode(std::string((const char *) name));
-		
-		// Get attributes
-		if (node && p)
-		{
-			for(const xmlChar** item = p; item && *item; item++)
-			{
-				std::string name = (const char *) *item++;
-				std::string value = (const char *) *item;
-
-				node->AddAttribute(name, value);
-			}
-		}
-		
-		// Make it a child of current stack element
-		if (xmlparser->mNodeList.size() && (xmlparser->mNodeList.back() != NULL))
-			xmlparser->mNodeList.back()->AddChild(node);
-
-		// Push onto stack
-		xmlparser->mNodeList.push_back(node);
-	}
-	catch (const std::exception& e)
-	{
-		xmlparser->HandleException(e);
-	}
-};
-
-void XMLDOMlibxml2::_EndElement(void* parser, const xmlChar* name) 
-{
-	// Get parser object
-	XMLDOMlibxml2* xmlparser = static_cast<XMLDOMlibxml2*>(parser);
-
-	// Don't bother if on error state
-	if (xmlparser->mError)
-		return;
-
-	try
-	{
-		// Pop current item off the stack
-		xmlparser->mNodeList.pop_back();
-	}
-	catch(const std::exception& e)
-	{
-		xmlparser->HandleException(e);
-	}
-};
-
-void XMLDOMlibxml2::_Characters(void* parser, const xmlChar* ch, int len)
+bool XMLDOMlibxml2::Feed(const char* data, size_t length)
 {
-	// Get parser object
-	XMLDOMlibxml2* xmlparser = static_cast<XMLDOMlibxml2*>(parser);
-
-	// Don't bother if on error state
-	if (xmlparser->mError)
-		return;
-
-	try
-	{
-		// Add data to current stack element
-		if (xmlparser->mNodeList.size() && (xmlparser->mNodeList.back() != NULL))
-			xmlparser->mNodeList.back()->SetData(std::string((const char *) ch, len));
-	}
-	catch(const std::exception& e)
+	if (!mPushing)
 	{
-		xmlparser->HandleException(e);
+		mParser.Reset();
+		mPushing = true;
 	}
-};
-
-void XMLDOMlibxml2::_Comment(void* parser, const xmlChar* value)
-{
-	// Nothing to do
-};
+	return mParser.Feed(data, length);
+}
 
-void XMLDOMlibxml2::_Warning(void* parser, const char* fmt, ...)
+bool XMLDOMlibxml2::Finish()
 {
-	// Nothing to do
-};
+	if (!mPushing)
+		mParser.Reset();
+	mPushing = false;
+	return mParser.Finish();
+}
 
-void XMLDOMlibxml2::_Error(void* parser, const char* fmt, ...)
+XMLNode* XMLDOMlibxml2::Root()
 {
-	// Get parser object
-	XMLDOMlibxml2* xmlparser = static_cast<XMLDOMlibxml2*>(parser);
-
-	// Set error state
-	xmlparser->mError = true;
-};
+	return (!mParser.Failed() && (mParser.Document() != NULL)) ? mParser.Document()->GetRoot() : NULL;
+}
 
-void XMLDOMlibxml2::_FatalError(void* parser, const char *fmt, ...)
+void XMLDOMlibxml2::Reset()
 {
-	// Get parser object
-	XMLDOMlibxml2* xmlparser = static_cast<XMLDOMlibxml2*>(parser);
-
-	// Set error state
-	xmlparser->mError = true;
-};
\ No newline at end of file
+	mParser.Reset();
+	mPushing = false;
+}
@@ -21,13 +21,16 @@
 
 #include "XMLParserDOM.h"
 
-#include "XMLNode.h"
-
-#include <libxml/parser.h>
+#include "XMLSAXlibxml2.h"
 
 namespace xmllib
 {
 
+class XMLDocument;
+
+// The tree is built from libxml2's SAX callbacks into a document owned by the parser, so
+// the root is valid until the next parse, Reset or the parser is deleted.
+
 class XMLDOMlibxml2 : public XMLParserDOM
 {
 public:
@@ -37,29 +40,31 @@ public:
 	virtual void ParseData(const char* data);
 	virtual void ParseFile(const char* filename);
 
-	virtual XMLNode* Root()
-		{ return mRoot; }
+	// Data in memory that need not be NUL terminated
+	void ParseData(const char* data, size_t length);
 
-private:
-	XMLNode*			mRoot;
-	XMLNodeList			mNodeList;
-	xmlParserCtxtPtr 	mParseContext;
-	xmlSAXHandler		mSAXHandler;
-	bool				mError;
-
-	void		HandleException(const std::exception& ex);
-
-	// Callbacks
-	static void _StartDocument(void* parser);
-	static void _EndDocument(void* parser);
-	static void _StartElement(void* parser, const xmlChar* name, const xmlChar** p);
-	static void _EndElement(void* parser, const xmlChar* name);
-	static void _Characters(void* parser, const xmlChar* ch, int len);
-	static void _Comment(void* parser, const xmlChar* value);
-	static void _Warning(void* parser, const char* fmt, ...);
-	static void _Error(void* parser, const char* fmt, ...);
-	static void _FatalError(void* parser, const char* fmt, ...);
+	// Incremental parsing - as for XMLSAXlibxml2, with the first piece starting afresh
+	bool Feed(const char* data, size_t length);
+	bool Finish();
+
+	virtual XMLNode* Root();
 
+	XMLDocument* Document()
+	{
+		return mParser.Document();
+	}
+
+	bool Failed() const
+	{
+		return mParser.Failed();
+	}
+
+	// Ready to parse another document, keeping the parser context and document storage
+	void Reset();
+
+private:
+	XMLSAXlibxml2		mParser;
+	bool				mPushing;
 };
 
 }
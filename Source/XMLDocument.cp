@@ -17,20 +17,74 @@
 #include "XMLDocument.h"
 
 #include "XMLNode.h"
+#include "XMLStats.h"
+#include "XMLWriter.h"
+
+#include <cstring>
+#include <new>
 
 namespace xmllib
 {
 
-XMLDocument::XMLDocument()
+XMLDocument::XMLDocument(XMLNameTable* names)
 {
-	mRoot = new XMLNode(this, NULL, cdstring::null_str);
-	mNamespaces.push_back(XMLNamespace(cdstring::null_str));
+	mOwnNames = (names == NULL);
+	mNames = mOwnNames ? new XMLNameTable : names;
+	mNamespaceMask = 0;
+	mNamespaceSlotsUsed = 0;
+	AppendNamespace(XMLNamespace(cdstring::null_str), XMLNameTable::cEmptyName, XMLNameTable::cEmptyName);
+	mRoot = CreateNode(NULL, cdstring::null_str);
 }
 
 
 XMLDocument::~XMLDocument()
 {
-	delete mRoot;
+	// Runs the node destructors - the arena releases all the node memory in one go
+	XMLNode_Delete(mRoot);
+	if (mOwnNames)
+		delete mNames;
+}
+
+// Back to the state of a new document for parsing another one into, keeping the arena's blocks,
+// the namespace table's capacity and the interned names
+void XMLDocument::Clear()
+{
+	XMLNode_Delete(mRoot);
+	mRoot = NULL;
+	mArena.Reset();
+
+	mNamespaces.clear();
+	mNamespaceIDs.clear();
+	SNamespaceSlot empty;
+	empty.mName = 0;
+	empty.mPrefix = 0;
+	empty.mIndex = cNoNamespace;
+	mNamespaceSlots.assign(mNamespaceSlots.size(), empty);
+	mNamespaceSlotsUsed = 0;
+
+	AppendNamespace(XMLNamespace(cdstring::null_str), XMLNameTable::cEmptyName, XMLNameTable::cEmptyName);
+	mRoot = CreateNode(NULL, cdstring::null_str);
+}
+
+XMLNode* XMLDocument::CreateNode(XMLNode* parent, const cdstring& name)
+{
+	XMLNode* node = new(mArena.Allocate(sizeof(XMLNode))) XMLNode(this, parent, name);
+	node->mInArena = true;
+	return node;
+}
+
+XMLNode* XMLDocument::CreateNode(XMLNode* parent, const XMLStringView& name)
+{
+	XMLNode* node = new(mArena.Allocate(sizeof(XMLNode))) XMLNode(this, parent, name);
+	node->mInArena = true;
+	return node;
+}
+
+XMLNode* XMLDocument::CreateNode(const XMLNode& copy, XMLNode* parent)
+{
+	XMLNode* node = new(mArena.Allocate(sizeof(XMLNode))) XMLNode(copy, parent);
+	node->mInArena = true;
+	return node;
 }
 
 // Add the namespace to the documents list, and update the index in
@@ -38,32 +92,88 @@ XMLDocument::~XMLDocument()
 // will avoid the need to use this method again if the namespace object is re-used.
 uint32_t XMLDocument::AddNamespace(const XMLNamespace& namespc)
 {
-	// Check whether already present
-	XMLNamespaceList::const_iterator found =  mNamespaces.end();
-	bool test_prefix = namespc.Prefix().empty();
-	for(XMLNamespaceList::const_iterator iter = mNamespaces.begin(); iter != mNamespaces.end(); iter++)
+	// Policy: first try full match with name & prefix
+	// then try partial match with name and no prefix
+	uint32_t name = mNames->Intern(namespc.Name());
+	uint32_t prefix = mNames->Intern(namespc.Prefix());
+	uint32_t found = FindNamespace(name, prefix);
+	if ((found == cNoNamespace) && namespc.Prefix().empty())
+		found = FindNamespace(name, XMLNameTable::cNoName);
+	if (found != cNoNamespace)
+		return found;
+
+	namespc.SetIndex(mNamespaces.size());
+	AppendNamespace(namespc, name, prefix);
+	XMLLIB_STATS_COUNT(eNamespaces, 1);
+	return namespc.Index();
+}
+
+static uint32_t HashNamespace(uint32_t name, uint32_t prefix)
+{
+	uint32_t hash = name * 0x9E3779B1U;
+	return hash ^ (prefix + 0x7F4A7C15U + (hash << 6) + (hash >> 2));
+}
+
+uint32_t XMLDocument::FindNamespace(uint32_t name, uint32_t prefix) const
+{
+	for(uint32_t slot = HashNamespace(name, prefix) & mNamespaceMask; ; slot = (slot + 1) & mNamespaceMask)
 	{
-		// Policy: first try full match with name & prefix
-		// then try partial match with name and no prefix
-		if (*iter == namespc)
-		{
-			found = iter;
-			break;
-		}
-		// For partial match just use the first one found
-		else if (test_prefix && ((*iter).Name() == namespc.Name()))
+		const SNamespaceSlot& entry = mNamespaceSlots[slot];
+		if (entry.mIndex == cNoNamespace)
+			return cNoNamespace;
+		if ((entry.mName == name) && (entry.mPrefix == prefix))
+			return entry.mIndex;
+	}
+}
+
+// No checks for duplicates so the namespaces of a snapshot keep their indices
+void XMLDocument::AppendNamespace(const XMLNamespace& namespc, uint32_t name, uint32_t prefix)
+{
+	uint32_t index = mNamespaces.size();
+	mNamespaces.push_back(namespc);
+	mNamespaceIDs.push_back(name);
+
+	IndexNamespace(name, prefix, index);
+	IndexNamespace(name, XMLNameTable::cNoName, index);
+}
+
+// Only the first namespace with a key is indexed
+void XMLDocument::IndexNamespace(uint32_t name, uint32_t prefix, uint32_t index)
+{
+	// Keep the table at most half full
+	if ((mNamespaceSlotsUsed + 1) * 2 > mNamespaceSlots.size())
+	{
+		std::vector<SNamespaceSlot> old;
+		old.swap(mNamespaceSlots);
+
+		SNamespaceSlot empty;
+		empty.mName = 0;
+		empty.mPrefix = 0;
+		empty.mIndex = cNoNamespace;
+		mNamespaceSlots.assign(old.empty() ? 16 : old.size() * 2, empty);
+		mNamespaceMask = mNamespaceSlots.size() - 1;
+		mNamespaceSlotsUsed = 0;
+		XMLLIB_STATS_COUNT(eNamespaceTableGrowths, 1);
+
+		for(std::vector<SNamespaceSlot>::const_iterator iter = old.begin(); iter != old.end(); iter++)
 		{
-			found = iter;
-			test_prefix = false;
+			if ((*iter).mIndex != cNoNamespace)
+				IndexNamespace((*iter).mName, (*iter).mPrefix, (*iter).mIndex);
 		}
 	}
-	
-	if (found != mNamespaces.end())
-		return found - mNamespaces.begin();
 
-	namespc.SetIndex(mNamespaces.size());
-	mNamespaces.push_back(namespc);
-	return namespc.Index();
+	uint32_t slot = HashNamespace(name, prefix) & mNamespaceMask;
+	while(mNamespaceSlots[slot].mIndex != cNoNamespace)
+	{
+		if ((mNamespaceSlots[slot].mName == name) && (mNamespaceSlots[slot].mPrefix == prefix))
+			return;
+		slot = (slot + 1) & mNamespaceMask;
+	}
+
+	mNamespaceSlots[slot].mName = name;
+	mNamespaceSlots[slot].mPrefix = prefix;
+	mNamespaceSlots[slot].mIndex = index;
+	mNamespaceSlotsUsed++;
 }
 
 const cdstring& XMLDocument::GetNamespace(uint32_t index) const
@@ -80,8 +190,17 @@ const cdstring& XMLDocument::GetNamespacePrefix(uint32_t index) const
 	return mNamespaces.at(index).Prefix();
 }
 
+uint32_t XMLDocument::GetNamespaceID(uint32_t index) const
+{
+	if (index >= mNamespaceIDs.size())
+		index = 0;
+	return mNamespaceIDs[index];
+}
+
 void XMLDocument::Generate(std::ostream& os, bool indent) const
 {
+	XMLLIB_STATS_TIMER(eTimerGenerate);
+
 	// Handle namespace:
 	//  Make sure each namespace has a unique prefix
 	//  Add to root element as xmlns
@@ -116,6 +235,10 @@ void XMLDocument::Generate(std::ostream& os, bool indent) const
 			while(prefix.count(name) != 0)
 				name += (char)::toupper(name[(cdstring::size_type)0]);
 			const_cast<XMLNamespace&>(*iter).SetPrefix(name);
+
+			// Index the new prefix too so adding the same namespace with it finds this one
+			uint32_t index = iter - mNamespaces.begin();
+			const_cast<XMLDocument*>(this)->IndexNamespace(mNamespaceIDs[index], mNames->Intern(name), index);
 		}
 		else
 			prefix.insert((*iter).Prefix());
@@ -123,11 +246,15 @@ void XMLDocument::Generate(std::ostream& os, bool indent) const
 		mRoot->AddNamespace(*iter);
 	}
 	
+	// Whole document goes through one buffer sized up front
+	XMLWriter writer(os, indent, XMLNode::GenerateBufferSize(::strlen(cXMLDeclaration) + mRoot->GenerateSize(0, indent)));
+
 	// Do declaration
-	os << "<?xml version=\"1.0\" encoding=\"utf-8\" ?>" << std::endl;
+	writer.StartDocument();
 	
 	// Do each child of the main root element
-	mRoot->Generate(os, 0, indent);
+	mRoot->Generate(writer);
+	writer.EndDocument();
 }
 
 }
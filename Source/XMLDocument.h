@@ -24,7 +24,10 @@
 
 #include "cdstring.h"
 
+#include "XMLArena.h"
+#include "XMLNameTable.h"
 #include "XMLNamespace.h"
+#include "XMLStringView.h"
 
 namespace xmllib {
 
@@ -33,23 +36,73 @@ class XMLNode;
 class XMLDocument
 {
 public:
-	XMLDocument();
+	// Names are interned in a table owned by the document unless a shared one is passed in,
+	// e.g. XMLNameTable::Process() to let many documents share a single copy of each name
+	explicit XMLDocument(XMLNameTable* names = NULL);
 	virtual ~XMLDocument();
 
+	// Remove everything, leaving an empty root as in a new document. All nodes are deleted,
+	// but the memory they used is kept for the next document built here.
+	void Clear();
+
 	XMLNode* GetRoot()
 	{
 		return mRoot;
 	}
 
+	// Nodes created here are owned by the document's arena and must never be
+	// passed to delete directly - use XMLNode_Delete
+	XMLArena& Arena()
+	{
+		return mArena;
+	}
+	XMLNode* CreateNode(XMLNode* parent, const cdstring& name);
+	XMLNode* CreateNode(XMLNode* parent, const XMLStringView& name);
+	XMLNode* CreateNode(const XMLNode& copy, XMLNode* parent);
+
+	XMLNameTable& Names() const
+	{
+		return *mNames;
+	}
+
 	uint32_t			AddNamespace(const XMLNamespace& namespc);
 	const cdstring&		GetNamespace(uint32_t index) const;
 	const cdstring&		GetNamespacePrefix(uint32_t index) const;
+	uint32_t			GetNamespaceID(uint32_t index) const;
+	uint32_t			CountNamespaces() const
+	{
+		return mNamespaces.size();
+	}
 	
 	void	Generate(std::ostream& os, bool indent = true) const;
 
 protected:
+	friend class XMLSnapshot;
+
+	// Namespaces are found by the interned ids of their name and prefix - the first one with
+	// a name is also found under that name with no prefix id, for matching any prefix
+	struct SNamespaceSlot
+	{
+		uint32_t	mName;
+		uint32_t	mPrefix;
+		uint32_t	mIndex;				// cNoNamespace when the slot is empty
+	};
+
+	static const uint32_t cNoNamespace = 0xFFFFFFFF;
+
+	XMLArena			mArena;				// Storage for nodes and attributes
+	XMLNameTable*		mNames;				// Interned element, attribute and namespace names
+	bool				mOwnNames;			// Table is deleted with the document
 	XMLNode*			mRoot;				// Root element of document
 	XMLNamespaceList	mNamespaces;		// List of all namespaces used in the document
+	std::vector<uint32_t>	mNamespaceIDs;	// Interned name of each namespace
+	std::vector<SNamespaceSlot>	mNamespaceSlots;	// Open addressing table of the namespaces
+	uint32_t			mNamespaceMask;
+	uint32_t			mNamespaceSlotsUsed;
+
+	uint32_t	FindNamespace(uint32_t name, uint32_t prefix) const;
+	void		AppendNamespace(const XMLNamespace& namespc, uint32_t name, uint32_t prefix);
+	void		IndexNamespace(uint32_t name, uint32_t prefix, uint32_t index);
 };
 
 }	// namespace xmllib
@@ -0,0 +1,186 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Source for entity and character reference decoding
+
+#include "XMLEntities.h"
+
+#include "XMLScan.h"
+#include "XMLStats.h"
+
+#include <cstring>
+
+namespace xmllib
+{
+
+// Longest entity looked for after a '&' - enough for any predefined entity or character
+const size_t cMaxEntityLength = 16;
+
+// Letters only - other bytes never match a lower case letter once 0x20 is set
+static bool MatchLower(const char* name, const char* lower, size_t length)
+{
+	for(size_t i = 0; i < length; i++)
+	{
+		if ((name[i] | 0x20) != lower[i])
+			return false;
+	}
+	return true;
+}
+
+bool XMLPredefinedEntity(const char* name, size_t length, char& c)
+{
+	switch(length)
+	{
+	case 2:
+		if ((name[1] | 0x20) != 't')
+			return false;
+		switch(name[0] | 0x20)
+		{
+		case 'l':
+			c = '<';
+			return true;
+		case 'g':
+			c = '>';
+			return true;
+		default:
+			return false;
+		}
+	case 3:
+		c = '&';
+		return MatchLower(name, "amp", 3);
+	case 4:
+		switch(name[0] | 0x20)
+		{
+		case 'a':
+			c = '\'';
+			return MatchLower(name + 1, "pos", 3);
+		case 'q':
+			c = '"';
+			return MatchLower(name + 1, "uot", 3);
+		default:
+			return false;
+		}
+	default:
+		return false;
+	}
+}
+
+size_t XMLEncodeUTF8(uint32_t c, char* out)
+{
+	if (c < 0x80)
+	{
+		if (c == 0)
+			return 0;
+		out[0] = (char)c;
+		return 1;
+	}
+	else if (c < 0x800)
+	{
+		out[0] = (char)(0xC0 | (c >> 6));
+		out[1] = (char)(0x80 | (c & 0x3F));
+		return 2;
+	}
+	else if (c < 0x10000)
+	{
+		if ((c >= 0xD800) && (c <= 0xDFFF))
+			return 0;
+		out[0] = (char)(0xE0 | (c >> 12));
+		out[1] = (char)(0x80 | ((c >> 6) & 0x3F));
+		out[2] = (char)(0x80 | (c & 0x3F));
+		return 3;
+	}
+	else if (c < 0x110000)
+	{
+		out[0] = (char)(0xF0 | (c >> 18));
+		out[1] = (char)(0x80 | ((c >> 12) & 0x3F));
+		out[2] = (char)(0x80 | ((c >> 6) & 0x3F));
+		out[3] = (char)(0x80 | (c & 0x3F));
+		return 4;
+	}
+	else
+		return 0;
+}
+
+// Digits after the '#' - the value is complete before anything is written, and is never
+// longer than the reference it replaces
+static size_t DecodeReference(const char* p, const char* end, char* out)
+{
+	bool hex = (p < end) && ((*p | 0x20) == 'x');
+	if (hex)
+		p++;
+	if (p == end)
+		return 0;
+
+	uint32_t value = 0;
+	for(; p < end; p++)
+	{
+		uint32_t digit;
+		if ((*p >= '0') && (*p <= '9'))
+			digit = *p - '0';
+		else if (hex && ((*p | 0x20) >= 'a') && ((*p | 0x20) <= 'f'))
+			digit = (*p | 0x20) - 'a' + 10;
+		else
+			return 0;
+
+		value = value * (hex ? 16 : 10) + digit;
+		if (value >= 0x110000)
+			return 0;
+	}
+
+	return XMLEncodeUTF8(value, out);
+}
+
+size_t XMLDecodeEntities(const char* p, size_t length, char* out)
+{
+	const char* end = p + length;
+	char* start = out;
+	while(p < end)
+	{
+		// Copy up to the next entity in one go - the output never gets ahead of the input
+		const char* amp = XMLScan(p, end, '&');
+		if (out != p)
+			::memmove(out, p, amp - p);
+		out += amp - p;
+		if (amp == end)
+			break;
+
+		// Entity runs up to ';' - if there is none close by, or another '&' comes first, treat
+		// '&' as a literal
+		const char* name = amp + 1;
+		const char* limit = ((size_t)(end - name) > cMaxEntityLength) ? name + cMaxEntityLength : end;
+		const char* semi = name;
+		while((semi < limit) && (*semi != ';') && (*semi != '&'))
+			semi++;
+		if ((semi == limit) || (*semi == '&'))
+		{
+			*out++ = '&';
+			p = name;
+			continue;
+		}
+		p = semi + 1;
+		XMLLIB_STATS_COUNT(eEntityDecodes, 1);
+
+		char c;
+		if ((name < semi) && (*name == '#'))
+			out += DecodeReference(name + 1, semi, out);
+		else if (XMLPredefinedEntity(name, semi - name, c))
+			*out++ = c;
+	}
+
+	return out - start;
+}
+
+}
@@ -0,0 +1,43 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Header for entity and character reference decoding
+
+#ifndef __XMLENTITIES__XMLLIB__
+#define __XMLENTITIES__XMLLIB__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace xmllib
+{
+
+// Decodes the predefined entities and character references in text or an attribute value,
+// returning the number of bytes written to out. Character references become UTF-8. Unknown
+// entities and references to characters that cannot be encoded are dropped, and a '&' not
+// closed by a ';' soon after it is kept as it is. The result is never longer than the input,
+// so out can be the same as p to decode in place.
+size_t XMLDecodeEntities(const char* p, size_t length, char* out);
+
+// Name without the '&' and ';' - compared ignoring case
+bool XMLPredefinedEntity(const char* name, size_t length, char& c);
+
+// Number of bytes written to out, at most 4, or 0 for a surrogate, NUL or anything past the
+// end of Unicode
+size_t XMLEncodeUTF8(uint32_t c, char* out);
+
+}
+#endif
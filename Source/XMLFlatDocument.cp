@@ -0,0 +1,340 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Source for XMLFlatDocument class
+
+#include "XMLFlatDocument.h"
+
+#include "XMLConvert.h"
+#include "XMLName.h"
+#include "XMLNode.h"
+
+#include <cstring>
+
+using namespace xmllib;
+
+const cdstring& XMLFlatNode::Name() const
+{
+	return mDocument->Names().Name(NameID());
+}
+
+uint32_t XMLFlatNode::NameID() const
+{
+	return mDocument->Node(mIndex).mNameID;
+}
+
+bool XMLFlatNode::CompareFullName(const XMLName& xmlname) const
+{
+	uint32_t ns_id;
+	uint32_t name_id;
+	return MakeKey(xmlname, ns_id, name_id) && (NameID() == name_id) && (NamespaceNameID() == ns_id);
+}
+
+const cdstring& XMLFlatNode::Namespace() const
+{
+	return mDocument->Names().Name(NamespaceNameID());
+}
+
+uint32_t XMLFlatNode::NamespaceNameID() const
+{
+	return mDocument->Node(mIndex).mNamespaceID;
+}
+
+cdstring XMLFlatNode::GetFullName() const
+{
+	cdstring result = Namespace();
+	result += Name();
+	
+	return result;
+}
+
+XMLStringView XMLFlatNode::Data() const
+{
+	const XMLFlatDocument::SNode& node = mDocument->Node(mIndex);
+	return mDocument->String(node.mData, node.mDataLength);
+}
+
+bool XMLFlatNode::DataValue(cdstring& value) const
+{
+	value = Data().ToString();
+	return true;
+}
+
+bool XMLFlatNode::DataValue(uint32_t& value) const
+{
+	return XMLParseValue(Data(), value);
+}
+
+bool XMLFlatNode::DataValue(int32_t& value) const
+{
+	return XMLParseValue(Data(), value);
+}
+
+bool XMLFlatNode::DataValue(uint64_t& value) const
+{
+	return XMLParseValue(Data(), value);
+}
+
+bool XMLFlatNode::DataValue(int64_t& value) const
+{
+	return XMLParseValue(Data(), value);
+}
+
+bool XMLFlatNode::DataValue(double& value) const
+{
+	return XMLParseValue(Data(), value);
+}
+
+bool XMLFlatNode::DataValue(bool& value) const
+{
+	return XMLParseValue(Data(), value);
+}
+
+uint32_t XMLFlatNode::CountAttributes() const
+{
+	return mDocument->Node(mIndex).mAttributeCount;
+}
+
+const cdstring& XMLFlatNode::AttributeName(uint32_t index) const
+{
+	const XMLFlatDocument::SAttribute& attr = mDocument->mAttributes[mDocument->Node(mIndex).mAttributes + index];
+	return mDocument->Names().Name(attr.mNameID);
+}
+
+XMLStringView XMLFlatNode::AttributeValue(uint32_t index) const
+{
+	const XMLFlatDocument::SAttribute& attr = mDocument->mAttributes[mDocument->Node(mIndex).mAttributes + index];
+	return mDocument->String(attr.mValue, attr.mValueLength);
+}
+
+// Attributes are few per element so a scan comparing interned ids is all that is needed
+bool XMLFlatNode::FindAttribute(const cdstring& name, uint32_t& index) const
+{
+	// A name that was never interned cannot be present
+	uint32_t id;
+	if (!mDocument->Names().Find(name.c_str(), name.length(), id))
+		return false;
+
+	const XMLFlatDocument::SNode& node = mDocument->Node(mIndex);
+	for(uint32_t i = 0; i < node.mAttributeCount; i++)
+	{
+		if (mDocument->mAttributes[node.mAttributes + i].mNameID == id)
+		{
+			index = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool XMLFlatNode::HasAttribute(const cdstring& name) const
+{
+	uint32_t index;
+	return FindAttribute(name, index);
+}
+
+bool XMLFlatNode::AttributeValue(const cdstring& name, XMLStringView& value) const
+{
+	uint32_t index;
+	if (FindAttribute(name, index))
+	{
+		value = AttributeValue(index);
+		return true;
+	}
+	else
+		return false;
+}
+
+bool XMLFlatNode::AttributeValue(const cdstring& name, cdstring& value) const
+{
+	XMLStringView found;
+	if (AttributeValue(name, found))
+	{
+		value = found.ToString();
+		return true;
+	}
+	else
+		return false;
+}
+
+bool XMLFlatNode::AttributeValue(const cdstring& name, uint32_t& value) const
+{
+	XMLStringView found;
+	return AttributeValue(name, found) && XMLParseValue(found, value);
+}
+
+bool XMLFlatNode::AttributeValue(const cdstring& name, int32_t& value) const
+{
+	XMLStringView found;
+	return AttributeValue(name, found) && XMLParseValue(found, value);
+}
+
+bool XMLFlatNode::AttributeValue(const cdstring& name, uint64_t& value) const
+{
+	XMLStringView found;
+	return AttributeValue(name, found) && XMLParseValue(found, value);
+}
+
+bool XMLFlatNode::AttributeValue(const cdstring& name, int64_t& value) const
+{
+	XMLStringView found;
+	return AttributeValue(name, found) && XMLParseValue(found, value);
+}
+
+bool XMLFlatNode::AttributeValue(const cdstring& name, double& value) const
+{
+	XMLStringView found;
+	return AttributeValue(name, found) && XMLParseValue(found, value);
+}
+
+bool XMLFlatNode::AttributeValue(const cdstring& name, uint32_t& index, const char** array) const
+{
+	// A missing attribute matches nothing
+	XMLStringView found;
+	if (AttributeValue(name, found) && XMLParseEnum(found.Data(), found.Length(), array, index))
+		return true;
+
+	index = 0;
+	return false;
+}
+
+bool XMLFlatNode::AttributeValue(const cdstring& name, bool& value) const
+{
+	XMLStringView found;
+	return AttributeValue(name, found) && XMLParseValue(found, value);
+}
+
+XMLFlatNode XMLFlatNode::Parent() const
+{
+	return XMLFlatNode(mDocument, mDocument->Node(mIndex).mParent);
+}
+
+XMLFlatNode XMLFlatNode::FirstChild() const
+{
+	return XMLFlatNode(mDocument, mDocument->Node(mIndex).mFirstChild);
+}
+
+XMLFlatNode XMLFlatNode::NextSibling() const
+{
+	return XMLFlatNode(mDocument, mDocument->Node(mIndex).mNextSibling);
+}
+
+uint32_t XMLFlatNode::CountChildren() const
+{
+	uint32_t result = 0;
+	for(uint32_t child = mDocument->Node(mIndex).mFirstChild; child != cNoNode; child = mDocument->Node(child).mNextSibling)
+		result++;
+	return result;
+}
+
+void XMLFlatNode::Children(XMLFlatNodeList& result) const
+{
+	for(uint32_t child = mDocument->Node(mIndex).mFirstChild; child != cNoNode; child = mDocument->Node(child).mNextSibling)
+		result.push_back(XMLFlatNode(mDocument, child));
+}
+
+// Full names are the namespace followed directly by the local name, as for XMLNode
+bool XMLFlatNode::MatchesFullName(const cdstring& fullname) const
+{
+	const cdstring& ns = Namespace();
+	const cdstring& name = Name();
+
+	return (ns.length() + name.length() == fullname.length()) &&
+			(::memcmp(fullname.c_str(), ns.c_str(), ns.length()) == 0) &&
+			(::memcmp(fullname.c_str() + ns.length(), name.c_str(), name.length()) == 0);
+}
+
+// False if the name was never interned, in which case nothing can match
+bool XMLFlatNode::MakeKey(const XMLName& name, uint32_t& ns_id, uint32_t& name_id) const
+{
+	const char* namespc = (name.Namespace() != NULL) ? name.Namespace() : "";
+	const char* local = (name.Name() != NULL) ? name.Name() : "";
+	return mDocument->Names().Find(namespc, ns_id) && mDocument->Names().Find(local, name_id);
+}
+
+XMLFlatNode XMLFlatNode::GetChild(const cdstring& name) const
+{
+	for(XMLFlatNode child = FirstChild(); child.IsValid(); child = child.NextSibling())
+	{
+		if (child.MatchesFullName(name))
+			return child;
+	}
+	
+	return XMLFlatNode();
+}
+
+XMLFlatNode XMLFlatNode::GetChild(const XMLName& name) const
+{
+	uint32_t ns_id;
+	uint32_t name_id;
+	if (!MakeKey(name, ns_id, name_id))
+		return XMLFlatNode();
+
+	// Compare ids directly rather than going through a handle for each child
+	const std::vector<XMLFlatDocument::SNode>& nodes = mDocument->mNodes;
+	for(uint32_t child = nodes[mIndex].mFirstChild; child != cNoNode; child = nodes[child].mNextSibling)
+	{
+		if ((nodes[child].mNameID == name_id) && (nodes[child].mNamespaceID == ns_id))
+			return XMLFlatNode(mDocument, child);
+	}
+	
+	return XMLFlatNode();
+}
+
+void XMLFlatNode::GetChildren(const cdstring& name, XMLFlatNodeList& result) const
+{
+	for(XMLFlatNode child = FirstChild(); child.IsValid(); child = child.NextSibling())
+	{
+		if (child.MatchesFullName(name))
+			result.push_back(child);
+	}
+}
+
+void XMLFlatNode::GetChildren(const XMLName& name, XMLFlatNodeList& result) const
+{
+	uint32_t ns_id;
+	uint32_t name_id;
+	if (!MakeKey(name, ns_id, name_id))
+		return;
+
+	const std::vector<XMLFlatDocument::SNode>& nodes = mDocument->mNodes;
+	for(uint32_t child = nodes[mIndex].mFirstChild; child != cNoNode; child = nodes[child].mNextSibling)
+	{
+		if ((nodes[child].mNameID == name_id) && (nodes[child].mNamespaceID == ns_id))
+			result.push_back(XMLFlatNode(mDocument, child));
+	}
+}
+
+XMLFlatDocument::XMLFlatDocument(XMLNameTable* names)
+{
+	mOwnNames = (names == NULL);
+	mNames = mOwnNames ? new XMLNameTable : names;
+	mPool.push_back(0);
+}
+
+XMLFlatDocument::~XMLFlatDocument()
+{
+	if (mOwnNames)
+		delete mNames;
+}
+
+void XMLFlatDocument::Clear()
+{
+	mNodes.clear();
+	mAttributes.clear();
+	mPool.assign(1, 0);
+}
@@ -0,0 +1,197 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Header for XMLFlatDocument class
+
+#ifndef __XMLFLATDOCUMENT__XMLLIB__
+#define __XMLFLATDOCUMENT__XMLLIB__
+
+#include "XMLNameTable.h"
+#include "XMLStringView.h"
+
+#include <stdint.h>
+#include <vector>
+
+#include "cdstring.h"
+
+namespace xmllib
+{
+
+class XMLFlatDocument;
+class XMLFlatNode;
+typedef std::vector<XMLFlatNode> XMLFlatNodeList;
+
+class XMLName;
+
+// Read-only handle on one element of a flat document. Handles are small enough to pass by
+// value and are only valid while their document is. A default constructed handle, or one
+// returned when there is no such element, is not valid and must not be read.
+
+class XMLFlatNode
+{
+public:
+	static const uint32_t cNoNode = 0xFFFFFFFF;
+
+	XMLFlatNode()
+		{ mDocument = NULL; mIndex = cNoNode; }
+	XMLFlatNode(const XMLFlatDocument* doc, uint32_t index)
+		{ mDocument = doc; mIndex = index; }
+
+	bool IsValid() const
+		{ return mIndex != cNoNode; }
+	const XMLFlatDocument* Document() const
+		{ return mDocument; }
+
+	// Position in document order, the root being 0
+	uint32_t Index() const
+		{ return mIndex; }
+
+	int operator==(const XMLFlatNode& comp) const
+		{ return (mDocument == comp.mDocument) && (mIndex == comp.mIndex); }
+	int operator!=(const XMLFlatNode& comp) const
+		{ return !(*this == comp); }
+
+	// Name - local part only, the prefix having been resolved to the namespace
+	const cdstring& Name() const;
+	uint32_t NameID() const;
+
+	bool CompareFullName(const XMLName& xmlname) const;
+
+	// Namespace
+	const cdstring& Namespace() const;
+	uint32_t NamespaceNameID() const;
+	cdstring GetFullName() const;
+
+	// Data content - all of the element's own text joined together
+	XMLStringView Data() const;
+	bool DataValue(cdstring& value) const;
+	bool DataValue(uint32_t& value) const;
+	bool DataValue(int32_t& value) const;
+	bool DataValue(uint64_t& value) const;
+	bool DataValue(int64_t& value) const;
+	bool DataValue(double& value) const;
+	bool DataValue(bool& value) const;
+
+	// Attributes - in the order they appeared, with names exactly as written
+	uint32_t CountAttributes() const;
+	const cdstring& AttributeName(uint32_t index) const;
+	XMLStringView AttributeValue(uint32_t index) const;
+
+	bool HasAttribute(const cdstring& name) const;
+	bool AttributeValue(const cdstring& name, XMLStringView& value) const;
+	bool AttributeValue(const cdstring& name, cdstring& value) const;
+	bool AttributeValue(const cdstring& name, uint32_t& value) const;
+	bool AttributeValue(const cdstring& name, int32_t& value) const;
+	bool AttributeValue(const cdstring& name, uint64_t& value) const;
+	bool AttributeValue(const cdstring& name, int64_t& value) const;
+	bool AttributeValue(const cdstring& name, double& value) const;
+	bool AttributeValue(const cdstring& name, uint32_t& index, const char** array) const;
+	bool AttributeValue(const cdstring& name, bool& value) const;
+
+	// Structure
+	XMLFlatNode Parent() const;
+	XMLFlatNode FirstChild() const;
+	XMLFlatNode NextSibling() const;
+	uint32_t CountChildren() const;
+	void Children(XMLFlatNodeList& result) const;
+
+	XMLFlatNode GetChild(const cdstring& name) const;
+	XMLFlatNode GetChild(const XMLName& name) const;
+	void GetChildren(const cdstring& name, XMLFlatNodeList& result) const;
+	void GetChildren(const XMLName& name, XMLFlatNodeList& result) const;
+
+private:
+	const XMLFlatDocument*	mDocument;
+	uint32_t				mIndex;
+
+	bool FindAttribute(const cdstring& name, uint32_t& index) const;
+	bool MatchesFullName(const cdstring& fullname) const;
+	bool MakeKey(const XMLName& name, uint32_t& ns_id, uint32_t& name_id) const;
+};
+
+// An immutable document held in a handful of flat arrays rather than a tree of nodes:
+// elements in document order linked by first child and next sibling indices, each element's
+// attributes as a range in one array, names as ids in a name table and all text and
+// attribute values in a single pool. Built directly by XMLFlatParser for consumers that only
+// ever read a document, it costs a few allocations in total rather than several per element.
+// Text in the pool is NUL terminated, so the data of views it hands out can be passed
+// straight to C string functions.
+
+class XMLFlatDocument
+{
+public:
+	// Names are interned as for XMLDocument's constructor
+	explicit XMLFlatDocument(XMLNameTable* names = NULL);
+	~XMLFlatDocument();
+
+	// Not valid if nothing was parsed
+	XMLFlatNode GetRoot() const
+		{ return XMLFlatNode(this, mNodes.empty() ? XMLFlatNode::cNoNode : 0); }
+	XMLFlatNode GetNode(uint32_t index) const
+		{ return XMLFlatNode(this, (index < mNodes.size()) ? index : XMLFlatNode::cNoNode); }
+	uint32_t CountNodes() const
+		{ return mNodes.size(); }
+
+	XMLNameTable& Names() const
+	{
+		return *mNames;
+	}
+
+private:
+	friend class XMLFlatNode;
+	friend class XMLFlatParser;
+
+	struct SNode
+	{
+		uint32_t	mNameID;
+		uint32_t	mNamespaceID;		// Interned namespace name, empty for none
+		uint32_t	mParent;
+		uint32_t	mFirstChild;
+		uint32_t	mNextSibling;
+		uint32_t	mAttributes;		// First in mAttributes
+		uint32_t	mAttributeCount;
+		uint32_t	mData;				// Offset in mPool
+		uint32_t	mDataLength;
+	};
+
+	struct SAttribute
+	{
+		uint32_t	mNameID;
+		uint32_t	mValue;				// Offset in mPool
+		uint32_t	mValueLength;
+	};
+
+	std::vector<SNode>		mNodes;
+	std::vector<SAttribute>	mAttributes;
+	std::vector<char>		mPool;			// Starts with the NUL that empty text refers to
+	XMLNameTable*			mNames;
+	bool					mOwnNames;		// Table is deleted with the document
+
+	const SNode& Node(uint32_t index) const
+		{ return mNodes[index]; }
+	XMLStringView String(uint32_t offset, uint32_t length) const
+		{ return XMLStringView(&mPool[offset], length); }
+
+	// Empty again for the parser to reuse, keeping the capacity
+	void Clear();
+
+	// Not copyable
+	XMLFlatDocument(const XMLFlatDocument& copy);
+	XMLFlatDocument& operator=(const XMLFlatDocument& copy);
+};
+
+}
+#endif
@@ -0,0 +1,231 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Source for XMLFlatParser class
+
+#include "XMLFlatParser.h"
+
+#include "XMLFlatDocument.h"
+
+#include <cstring>
+
+using namespace xmllib;
+
+XMLFlatParser::XMLFlatParser(XMLNameTable* names)
+{
+	mNames = names;
+	mFlat = NULL;
+	mSpare = NULL;
+	mLastTop = XMLFlatNode::cNoNode;
+}
+
+XMLFlatParser::~XMLFlatParser()
+{
+	delete mFlat;
+	delete mSpare;
+}
+
+void XMLFlatParser::Reset()
+{
+	XMLSAXSimple::Reset();
+
+	RecycleFlat();
+	mOpen.clear();
+	mText.clear();
+	mLastTop = XMLFlatNode::cNoNode;
+}
+
+void XMLFlatParser::StartDocument()
+{
+	// A document that was not released is cleared and built again
+	RecycleFlat();
+	if (mSpare != NULL)
+	{
+		mFlat = mSpare;
+		mSpare = NULL;
+	}
+	else
+		mFlat = new XMLFlatDocument(mNames);
+	mOpen.clear();
+	mNamespaceScope.Reset();
+	mText.clear();
+	mLastTop = XMLFlatNode::cNoNode;
+}
+
+void XMLFlatParser::StartElementView(const XMLStringView& name, const XMLAttributeViewList& attributes)
+{
+	// Don't bother if on error state
+	if (mError)
+		return;
+
+	// We always need a document
+	if (mFlat == NULL)
+		StartDocument();
+
+	try
+	{
+		SScope scope;
+		scope.mNode = mFlat->mNodes.size();
+		scope.mLastChild = XMLFlatNode::cNoNode;
+		scope.mDefault = mOpen.empty() ? XMLNameTable::cEmptyName : mOpen.back().mDefault;
+		scope.mText = mText.size();
+
+		XMLFlatDocument::SNode node;
+		node.mParent = mOpen.empty() ? XMLFlatNode::cNoNode : mOpen.back().mNode;
+		node.mFirstChild = XMLFlatNode::cNoNode;
+		node.mNextSibling = XMLFlatNode::cNoNode;
+		node.mAttributes = mFlat->mAttributes.size();
+		node.mAttributeCount = attributes.size();
+		node.mData = 0;
+		node.mDataLength = 0;
+
+		// Attributes are kept as written, but namespace declarations also go into scope as they
+		// apply to the element's own name
+		mNamespaceScope.Push();
+		for(XMLAttributeViewList::const_iterator iter = attributes.begin(); iter != attributes.end(); iter++)
+		{
+			const XMLStringView& attr_name = (*iter).mName;
+			const XMLStringView& attr_value = (*iter).mValue;
+
+			XMLFlatDocument::SAttribute attr;
+			attr.mNameID = Intern(attr_name);
+			attr.mValue = AddString(attr_value.Data(), attr_value.Length());
+			attr.mValueLength = attr_value.Length();
+			mFlat->mAttributes.push_back(attr);
+
+			if ((attr_name.Length() < 5) || (::memcmp(attr_name.Data(), "xmlns", 5) != 0))
+				continue;
+			if (attr_name.Length() == 5)
+				scope.mDefault = Intern(attr_value);
+			else if (attr_name[5] == ':')
+				mNamespaceScope.Bind(mFlat->Names().Intern(attr_name.Data() + 6, attr_name.Length() - 6), Intern(attr_value));
+		}
+
+		// A prefix selects a declared namespace, otherwise the default one applies
+		const char* colon = static_cast<const char*>(::memchr(name.Data(), ':', name.Length()));
+		if (colon != NULL)
+		{
+			size_t prefix_length = colon - name.Data();
+			node.mNameID = mFlat->Names().Intern(colon + 1, name.Length() - prefix_length - 1);
+			node.mNamespaceID = ResolvePrefix(name.Data(), prefix_length);
+		}
+		else
+		{
+			node.mNameID = Intern(name);
+			node.mNamespaceID = scope.mDefault;
+		}
+
+		// Link after the previous element at the same level
+		uint32_t& previous = mOpen.empty() ? mLastTop : mOpen.back().mLastChild;
+		if (previous != XMLFlatNode::cNoNode)
+			mFlat->mNodes[previous].mNextSibling = scope.mNode;
+		else if (node.mParent != XMLFlatNode::cNoNode)
+			mFlat->mNodes[node.mParent].mFirstChild = scope.mNode;
+		previous = scope.mNode;
+
+		mFlat->mNodes.push_back(node);
+		mOpen.push_back(scope);
+	}
+	catch (const std::exception& e)
+	{
+		HandleException(e);
+	}
+}
+
+void XMLFlatParser::EndElementView(const XMLStringView& name)
+{
+	// Don't bother if on error state
+	if (mError || mOpen.empty())
+		return;
+
+	try
+	{
+		// The element's text is only complete now, as it can be split around its children
+		const SScope& scope = mOpen.back();
+		if (mText.size() > scope.mText)
+		{
+			XMLFlatDocument::SNode& node = mFlat->mNodes[scope.mNode];
+			node.mDataLength = mText.size() - scope.mText;
+			node.mData = AddString(&mText[scope.mText], node.mDataLength);
+			mText.resize(scope.mText);
+		}
+		mNamespaceScope.Pop();
+
+		mOpen.pop_back();
+	}
+	catch (const std::exception& e)
+	{
+		HandleException(e);
+	}
+}
+
+void XMLFlatParser::CharactersView(const XMLStringView& data)
+{
+	// Don't bother if on error state or there is no element to add it to
+	if (mError || mOpen.empty())
+		return;
+
+	try
+	{
+		mText.insert(mText.end(), data.Data(), data.Data() + data.Length());
+	}
+	catch (const std::exception& e)
+	{
+		HandleException(e);
+	}
+}
+
+// Only one document is kept for reuse
+void XMLFlatParser::RecycleFlat()
+{
+	if (mFlat == NULL)
+		return;
+
+	if (mSpare == NULL)
+	{
+		mFlat->Clear();
+		mSpare = mFlat;
+	}
+	else
+		delete mFlat;
+	mFlat = NULL;
+}
+
+uint32_t XMLFlatParser::Intern(const XMLStringView& name)
+{
+	return mFlat->Names().Intern(name.Data(), name.Length());
+}
+
+// Strings are NUL terminated in the pool
+uint32_t XMLFlatParser::AddString(const char* data, size_t length)
+{
+	std::vector<char>& pool = mFlat->mPool;
+	uint32_t offset = pool.size();
+	pool.insert(pool.end(), data, data + length);
+	pool.push_back(0);
+	return offset;
+}
+
+// Undeclared prefixes are in no namespace
+uint32_t XMLFlatParser::ResolvePrefix(const char* prefix, size_t length) const
+{
+	uint32_t id;
+	uint32_t result;
+	if (mFlat->Names().Find(prefix, length, id) && mNamespaceScope.Lookup(id, result))
+		return result;
+
+	return XMLNameTable::cEmptyName;
+}
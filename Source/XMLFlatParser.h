@@ -0,0 +1,98 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Header for XMLFlatParser class
+
+#ifndef __XMLFLATPARSER__XMLLIB__
+#define __XMLFLATPARSER__XMLLIB__
+
+#include "XMLSAXSimple.h"
+
+#include <vector>
+
+namespace xmllib
+{
+
+class XMLFlatDocument;
+class XMLNameTable;
+
+// Parses straight into an XMLFlatDocument - no XMLDocument is built, so Document() stays
+// NULL. All the ways XMLSAXSimple can be given a document work, including feeding it in
+// pieces and parallel parsing. Element namespaces are resolved as each start tag is read,
+// from the declarations in scope at that point. The scope maps prefixes to interned
+// namespace names rather than to a document's namespace indices.
+
+class XMLFlatParser : public XMLSAXSimple
+{
+public:
+	// Names in every document built are interned as for XMLFlatDocument's constructor
+	explicit XMLFlatParser(XMLNameTable* names = NULL);
+	virtual ~XMLFlatParser();
+
+	XMLFlatDocument* FlatDocument()
+	{
+		return mFlat;
+	}
+
+	// Hand over control of document to caller
+	XMLFlatDocument* ReleaseFlatDocument()
+	{
+		XMLFlatDocument* temp = mFlat;
+		mFlat = NULL;
+		return temp;
+	}
+
+	virtual void Reset();
+
+protected:
+	virtual void StartDocument();
+	virtual void StartElementView(const XMLStringView& name, const XMLAttributeViewList& attributes);
+	virtual void EndElementView(const XMLStringView& name);
+	virtual void CharactersView(const XMLStringView& data);
+
+private:
+	// An open element
+	struct SScope
+	{
+		uint32_t	mNode;
+		uint32_t	mLastChild;
+		uint32_t	mDefault;			// Default namespace in scope inside it
+		uint32_t	mText;				// Start of its text in mText
+	};
+
+	XMLNameTable*			mNames;
+	XMLFlatDocument*		mFlat;
+	XMLFlatDocument*		mSpare;				// Cleared document to reuse for the next one
+	std::vector<SScope>		mOpen;
+	std::vector<char>		mText;				// Text of all open elements, innermost last
+	uint32_t				mLastTop;			// Last element outside any other
+
+	// Elements are never built so cannot be dropped
+	using XMLParserSAX::SetProjection;
+
+	void RecycleFlat();
+
+	uint32_t Intern(const XMLStringView& name);
+	uint32_t AddString(const char* data, size_t length);
+	uint32_t ResolvePrefix(const char* prefix, size_t length) const;
+
+	// Not copyable
+	XMLFlatParser(const XMLFlatParser& copy);
+	XMLFlatParser& operator=(const XMLFlatParser& copy);
+};
+
+}
+#endif
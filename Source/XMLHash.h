@@ -0,0 +1,49 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Header for string hashing utilities
+
+#ifndef __XMLHASH__XMLLIB__
+#define __XMLHASH__XMLLIB__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace xmllib
+{
+
+// FNV-1a. Hashing is incremental so hashing two strings one after the other gives the
+// same result as hashing their concatenation.
+
+const uint32_t cXMLHashInit = 2166136261U;
+
+inline uint32_t XMLHash(uint32_t hash, const char* p, size_t length)
+{
+	for(const char* end = p + length; p < end; p++)
+	{
+		hash ^= (unsigned char)*p;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+inline uint32_t XMLHash(const char* p, size_t length)
+{
+	return XMLHash(cXMLHashInit, p, length);
+}
+
+}
+#endif
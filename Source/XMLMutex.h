@@ -0,0 +1,92 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Header for XMLMutex class
+
+#ifndef __XMLMUTEX__XMLLIB__
+#define __XMLMUTEX__XMLLIB__
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+namespace xmllib
+{
+
+class XMLMutex
+{
+public:
+#if defined(_WIN32)
+	XMLMutex()
+		{ ::InitializeCriticalSection(&mMutex); }
+	~XMLMutex()
+		{ ::DeleteCriticalSection(&mMutex); }
+
+	void Lock()
+		{ ::EnterCriticalSection(&mMutex); }
+	void Unlock()
+		{ ::LeaveCriticalSection(&mMutex); }
+#else
+	XMLMutex()
+		{ ::pthread_mutex_init(&mMutex, NULL); }
+	~XMLMutex()
+		{ ::pthread_mutex_destroy(&mMutex); }
+
+	void Lock()
+		{ ::pthread_mutex_lock(&mMutex); }
+	void Unlock()
+		{ ::pthread_mutex_unlock(&mMutex); }
+#endif
+
+private:
+#if defined(_WIN32)
+	CRITICAL_SECTION	mMutex;
+#else
+	pthread_mutex_t		mMutex;
+#endif
+
+	// Not copyable
+	XMLMutex(const XMLMutex& copy);
+	XMLMutex& operator=(const XMLMutex& copy);
+};
+
+// Holds the lock for the lifetime of the object - optionally a no-op
+class XMLMutexLock
+{
+public:
+	explicit XMLMutexLock(XMLMutex& mutex, bool active = true)
+	{
+		mMutex = active ? &mutex : NULL;
+		if (mMutex != NULL)
+			mMutex->Lock();
+	}
+	~XMLMutexLock()
+	{
+		if (mMutex != NULL)
+			mMutex->Unlock();
+	}
+
+private:
+	XMLMutex*	mMutex;
+
+	XMLMutexLock(const XMLMutexLock& copy);
+	XMLMutexLock& operator=(const XMLMutexLock& copy);
+};
+
+}
+#endif
@@ -0,0 +1,136 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Source for XMLNameTable class
+
+#include "XMLNameTable.h"
+
+#include "XMLHash.h"
+
+#include <cstring>
+
+using namespace xmllib;
+
+const uint32_t XMLNameTable::cEmptyName;
+const uint32_t XMLNameTable::cNoName;
+
+const uint32_t cNameTableInitialSize = 64;
+
+XMLNameTable::XMLNameTable(bool shared)
+{
+	mShared = shared;
+	mMask = cNameTableInitialSize - 1;
+	mSlots.assign(cNameTableInitialSize, 0);
+
+	// Empty name is always present
+	Intern("", 0);
+}
+
+XMLNameTable::~XMLNameTable()
+{
+}
+
+XMLNameTable& XMLNameTable::Process()
+{
+	static XMLNameTable sProcess(true);
+	return sProcess;
+}
+
+uint32_t XMLNameTable::Intern(const char* name, size_t length)
+{
+	XMLMutexLock lock(mLock, mShared);
+
+	uint32_t hash = XMLHash(name, length);
+	uint32_t slot;
+	if (Lookup(name, length, hash, slot))
+		return mSlots[slot] - 1;
+
+	// Add new name
+	uint32_t id = mNames.size();
+	mNames.push_back(cdstring(name, length));
+	mHashes.push_back(hash);
+	mSlots[slot] = id + 1;
+
+	// Keep the table at most half full
+	if (mNames.size() * 2 > mSlots.size())
+		Grow();
+
+	return id;
+}
+
+bool XMLNameTable::Find(const char* name, size_t length, uint32_t& id) const
+{
+	XMLMutexLock lock(mLock, mShared);
+
+	uint32_t slot;
+	if (Lookup(name, length, XMLHash(name, length), slot))
+	{
+		id = mSlots[slot] - 1;
+		return true;
+	}
+	else
+		return false;
+}
+
+const cdstring& XMLNameTable::Name(uint32_t id) const
+{
+	XMLMutexLock lock(mLock, mShared);
+
+	return (id < mNames.size()) ? mNames[id] : cdstring::null_str;
+}
+
+uint32_t XMLNameTable::Hash(uint32_t id) const
+{
+	XMLMutexLock lock(mLock, mShared);
+
+	return (id < mHashes.size()) ? mHashes[id] : 0;
+}
+
+uint32_t XMLNameTable::Count() const
+{
+	XMLMutexLock lock(mLock, mShared);
+
+	return mNames.size();
+}
+
+// Find the slot holding the name, or the empty slot where it would go
+bool XMLNameTable::Lookup(const char* name, size_t length, uint32_t hash, uint32_t& slot) const
+{
+	slot = hash & mMask;
+	while(mSlots[slot] != 0)
+	{
+		uint32_t id = mSlots[slot] - 1;
+		if ((mHashes[id] == hash) && (mNames[id].length() == length) && (::memcmp(mNames[id].c_str(), name, length) == 0))
+			return true;
+		slot = (slot + 1) & mMask;
+	}
+
+	return false;
+}
+
+void XMLNameTable::Grow()
+{
+	// Double and rehash from the stored hashes
+	mSlots.assign(mSlots.size() * 2, 0);
+	mMask = mSlots.size() - 1;
+	for(uint32_t id = 0; id < mNames.size(); id++)
+	{
+		uint32_t slot = mHashes[id] & mMask;
+		while(mSlots[slot] != 0)
+			slot = (slot + 1) & mMask;
+		mSlots[slot] = id + 1;
+	}
+}
@@ -0,0 +1,84 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Header for XMLNameTable class
+
+#ifndef __XMLNAMETABLE__XMLLIB__
+#define __XMLNAMETABLE__XMLLIB__
+
+#include "XMLMutex.h"
+
+#include <stdint.h>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+#include "cdstring.h"
+
+namespace xmllib
+{
+
+// Interns element, attribute and namespace names so each distinct string is stored once and
+// can be compared by integer id. Every document has its own table unless it is given a shared
+// one, such as the process-wide table, in which case all access is serialised.
+
+class XMLNameTable
+{
+public:
+	explicit XMLNameTable(bool shared = false);
+	~XMLNameTable();
+
+	static XMLNameTable& Process();
+
+	uint32_t Intern(const char* name, size_t length);
+	uint32_t Intern(const char* name)
+		{ return Intern(name, (name != NULL) ? ::strlen(name) : 0); }
+	uint32_t Intern(const cdstring& name)
+		{ return Intern(name.c_str(), name.length()); }
+
+	// Lookup only - false if the name has never been interned
+	bool Find(const char* name, size_t length, uint32_t& id) const;
+	bool Find(const char* name, uint32_t& id) const
+		{ return Find(name, (name != NULL) ? ::strlen(name) : 0, id); }
+
+	const cdstring& Name(uint32_t id) const;
+
+	// XMLHash of the name, so names can be matched against ones hashed without a table
+	uint32_t Hash(uint32_t id) const;
+
+	uint32_t Count() const;
+
+	static const uint32_t cEmptyName = 0;			// Always the id of ""
+	static const uint32_t cNoName = 0xFFFFFFFF;
+
+private:
+	std::deque<cdstring>	mNames;			// Indexed by id - deque so references stay valid
+	std::vector<uint32_t>	mHashes;		// Hash of each name, indexed by id
+	std::vector<uint32_t>	mSlots;			// Open addressing table of id + 1, 0 when empty
+	uint32_t				mMask;
+	bool					mShared;
+	mutable XMLMutex		mLock;
+
+	bool Lookup(const char* name, size_t length, uint32_t hash, uint32_t& slot) const;
+	void Grow();
+
+	// Not copyable
+	XMLNameTable(const XMLNameTable& copy);
+	XMLNameTable& operator=(const XMLNameTable& copy);
+};
+
+}
+#endif
@@ -20,3 +20,39 @@
 
 using namespace xmllib;
 
+// Storage is kept for the next document
+void XMLNamespaceScope::Reset()
+{
+	mBound.assign(mBound.size(), 0);
+	mHidden.clear();
+	mLevels.clear();
+}
+
+void XMLNamespaceScope::Push()
+{
+	mLevels.push_back(mHidden.size());
+}
+
+void XMLNamespaceScope::Pop()
+{
+	if (mLevels.empty())
+		return;
+
+	// Undo the level's bindings in reverse so a prefix bound twice ends up as it was
+	for(uint32_t i = mHidden.size(); i > mLevels.back(); i--)
+		mBound[mHidden[i - 1].mPrefix] = mHidden[i - 1].mPrevious;
+	mHidden.resize(mLevels.back());
+	mLevels.pop_back();
+}
+
+void XMLNamespaceScope::Bind(uint32_t prefix, uint32_t namespc)
+{
+	if (prefix >= mBound.size())
+		mBound.resize(prefix + 1, 0);
+
+	SHidden hidden;
+	hidden.mPrefix = prefix;
+	hidden.mPrevious = mBound[prefix];
+	mHidden.push_back(hidden);
+	mBound[prefix] = namespc + 1;
+}
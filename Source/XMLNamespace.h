@@ -19,6 +19,9 @@
 #ifndef __XMLNamespace__XMLLIB__
 #define __XMLNamespace__XMLLIB__
 
+#include <stdint.h>
+#include <vector>
+
 #include "cdstring.h"
 
 namespace xmllib
@@ -90,5 +93,47 @@ private:
 	}
 };
 
+// Namespace prefixes in scope while parsing, keyed by the interned name id of the prefix.
+// Each element opens a level before binding its own declarations and closes it when it ends,
+// which puts back any bindings it hid, so binding and lookup take constant time however deep
+// the document is and however many prefixes it declares. What number stands for a namespace
+// is up to the caller.
+
+class XMLNamespaceScope
+{
+public:
+	XMLNamespaceScope() {}
+	~XMLNamespaceScope() {}
+
+	void Reset();
+
+	void Push();
+	void Pop();
+
+	void Bind(uint32_t prefix, uint32_t namespc);
+	bool Lookup(uint32_t prefix, uint32_t& namespc) const
+	{
+		if ((prefix >= mBound.size()) || (mBound[prefix] == 0))
+			return false;
+		namespc = mBound[prefix] - 1;
+		return true;
+	}
+
+private:
+	struct SHidden
+	{
+		uint32_t	mPrefix;
+		uint32_t	mPrevious;
+	};
+
+	std::vector<uint32_t>	mBound;			// Namespace + 1 for each prefix id, 0 when not bound
+	std::vector<SHidden>	mHidden;		// Bindings hidden by the open levels, innermost last
+	std::vector<uint32_t>	mLevels;		// Start of each open level in mHidden
+
+	// Not copyable
+	XMLNamespaceScope(const XMLNamespaceScope& copy);
+	XMLNamespaceScope& operator=(const XMLNamespaceScope& copy);
+};
+
 }
 #endif
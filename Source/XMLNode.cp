@@ -18,11 +18,15 @@
 
 #include "XMLNode.h"
 
+#include "XMLConvert.h"
 #include "XMLDocument.h"
 #include "XMLName.h"
 #include "XMLNamespace.h"
+#include "XMLNodeIndex.h"
+#include "XMLStats.h"
+#include "XMLWriter.h"
 
-#include <cstdlib>
+#include <cstring>
 #include <ostream>
 
 namespace xmllib
@@ -46,21 +50,23 @@ XMLNode::~XMLNode()
 	CleanChildren();
 }
 
-void XMLNode::_init(XMLDocument* doc, XMLNode* parent, const cdstring& name, const XMLNamespace* namespc)
+// Lookups by name only switch to the hash index past this many children
+const XMLNodeList::size_type cChildIndexThreshold = 8;
+
+void XMLNode::_init(XMLDocument* doc, XMLNode* parent, const char* name, size_t length, const XMLNamespace* namespc)
 {
+	XMLLIB_STATS_COUNT(eNodesCreated, 1);
+
 	mDocument = doc;
 	mParent = parent;
-	mName = name;
+	mInArena = false;
+	mChildIndex = NULL;
+	mNameID = doc->Names().Intern(name, length);
 	if (namespc != NULL)
-	{
 		mNamespaceIndex = namespc->HasIndex() ? namespc->Index() : doc->AddNamespace(*namespc);
-		mNamespaceDefault = (mNamespaceIndex == 0);
-	}
 	else
-	{
 		mNamespaceIndex = 0;
-		mNamespaceDefault = true;
-	}
+	mDefaultNamespace = (parent != NULL) ? parent->mDefaultNamespace : 0;
 	
 	// Add to parent
 	if (mParent != NULL)
@@ -71,9 +77,10 @@ void XMLNode::_copy(const XMLNode& copy)
 {
 	mDocument = copy.mDocument;
 
-	mName = copy.mName;
+	mNameID = copy.mNameID;
 	mData = copy.mData;
 	mChildren = copy.mChildren;
+	InvalidateChildIndex();
 	
 	// Must reset parent of copied children to this one
 	for(XMLNodeList::iterator iter = mChildren.begin(); iter != mChildren.end(); iter++)
@@ -85,36 +92,50 @@ void XMLNode::_copy(const XMLNode& copy)
 	SetAttributes(copy.mAttributeList);
 	
 	mNamespaceIndex = copy.mNamespaceIndex;
-	mNamespaceDefault = copy.mNamespaceDefault;
+	mDefaultNamespace = copy.mDefaultNamespace;
+}
+
+const cdstring& XMLNode::Name() const
+{
+	return mDocument->Names().Name(mNameID);
+}
+
+void XMLNode::SetName(const cdstring& name)
+{
+	mNameID = mDocument->Names().Intern(name);
+	ParentChanged();
 }
 
 void XMLNode::SetName(const cdstring& name, const XMLNamespace& namespc)
 {
-	mName = name;
+	mNameID = mDocument->Names().Intern(name);
 	mNamespaceIndex = namespc.HasIndex() ? namespc.Index() : mDocument->AddNamespace(namespc);
-	mNamespaceDefault = mNamespaceIndex == 0;
+	ParentChanged();
+}
+
+void XMLNode::SetName(const XMLStringView& name)
+{
+	mNameID = mDocument->Names().Intern(name.Data(), name.Length());
+	ParentChanged();
 }
 
 void XMLNode::SetName(const XMLName& name)
 {
-	mName = name.Name();
+	mNameID = mDocument->Names().Intern(name.Name());
 	if (name.Namespace() != NULL)
 	{
 		XMLNamespace temp(name.Namespace());
 		mNamespaceIndex = mDocument->AddNamespace(temp);
-		mNamespaceDefault = (mNamespaceIndex == 0);
 	}
 	else
-	{
 		mNamespaceIndex = 0;
-		mNamespaceDefault = true;
-	}
+	ParentChanged();
 }
 
 bool XMLNode::CompareFullName(const XMLName& xmlname) const
 {
-	return (mName == xmlname.Name()) &&
-			(mDocument->GetNamespace(mNamespaceIndex) == xmlname.Namespace());
+	XMLNodeIndex::SKey key;
+	return XMLNodeIndex::MakeKey(key, *mDocument, xmlname) && XMLNodeIndex::Matches(this, key);
 }
 
 // Create attribute defining the namespace
@@ -130,6 +151,11 @@ const cdstring& XMLNode::Namespace() const
 	return mDocument->GetNamespace(mNamespaceIndex);
 }
 
+uint32_t XMLNode::NamespaceNameID() const
+{
+	return mDocument->GetNamespaceID(mNamespaceIndex);
+}
+
 bool XMLNode::DataValue(cdstring& value) const
 {
 	value = mData;
@@ -138,24 +164,27 @@ bool XMLNode::DataValue(cdstring& value) const
 
 bool XMLNode::DataValue(uint32_t& value) const
 {
-	if (mData.empty())
-		return false;
-	else
-	{
-		value = strtoul(mData.c_str(), NULL, 10);
-		return true;
-	}
+	return XMLParseValue(mData, value);
 }
 
 bool XMLNode::DataValue(int32_t& value) const
 {
-	if (mData.empty())
-		return false;
-	else
-	{
-		value = strtol(mData.c_str(), NULL, 10);
-		return true;
-	}
+	return XMLParseValue(mData, value);
+}
+
+bool XMLNode::DataValue(uint64_t& value) const
+{
+	return XMLParseValue(mData, value);
+}
+
+bool XMLNode::DataValue(int64_t& value) const
+{
+	return XMLParseValue(mData, value);
+}
+
+bool XMLNode::DataValue(double& value) const
+{
+	return XMLParseValue(mData, value);
 }
 
 const char* cXMLValueTrue = "true";
@@ -163,23 +192,39 @@ const char* cXMLValueFalse = "false";
 
 bool XMLNode::DataValue(bool& value) const
 {
-	if (mData.empty())
-		return false;
-	else
-	{
-		value = (mData == cXMLValueTrue);
-		return true;
-	}
+	return XMLParseValue(mData, value);
+}
+
+// Values are formatted on the stack and copied straight into the data
+template <class T> static void SetValue(cdstring& data, T value)
+{
+	char buffer[cXMLMaxValueLength];
+	data.assign(buffer, XMLFormatValue(value, buffer));
 }
 
 void XMLNode::SetData(uint32_t data)
 {
-	mData = data;
+	SetValue(mData, data);
 }
 
 void XMLNode::SetData(int32_t data)
 {
-	mData = data;
+	SetValue(mData, data);
+}
+
+void XMLNode::SetData(uint64_t data)
+{
+	SetValue(mData, data);
+}
+
+void XMLNode::SetData(int64_t data)
+{
+	SetValue(mData, data);
+}
+
+void XMLNode::SetData(double data)
+{
+	SetValue(mData, data);
 }
 
 void XMLNode::SetData(bool data)
@@ -190,18 +235,34 @@ void XMLNode::SetData(bool data)
 void XMLNode::CleanAttributes()
 {
 	// Delete each attribute in the list
-	for(XMLAttributeList::iterator iter = mAttributeList.begin(); iter != mAttributeList.end(); iter++)
-		delete *iter;
+	XMLAttributeList_DeleteItems(mAttributeList);
 	mAttributeList.clear();
-	mAttributeMap.clear();
 }
 
 void XMLNode::CleanChildren()
 {
-	// Delete each attribute in the list
+	// Delete each child in the list
 	for(XMLNodeList::iterator iter = mChildren.begin(); iter != mChildren.end(); iter++)
-		delete *iter;
+		XMLNode_Delete(*iter);
 	mChildren.clear();
+	InvalidateChildIndex();
+}
+
+// Attributes of arena nodes are placed in the same arena
+XMLAttribute* XMLNode::NewAttribute(const cdstring& name, const cdstring& value)
+{
+	if (mInArena)
+		return XMLAttribute::Create(mDocument->Arena(), name, value);
+	else
+		return new XMLAttribute(name, value);
+}
+
+XMLAttribute* XMLNode::NewAttribute(const XMLAttribute& copy)
+{
+	if (mInArena)
+		return XMLAttribute::Create(mDocument->Arena(), copy);
+	else
+		return new XMLAttribute(copy);
 }
 
 void XMLNode::SetAttributes(const XMLAttributeList& attributes)
@@ -209,33 +270,61 @@ void XMLNode::SetAttributes(const XMLAttributeList& attributes)
 	// Clean out old set
 	CleanAttributes();
 	
-	// Add each new one to list and map
+	// Add each new one to list
 	for(XMLAttributeList::const_iterator iter = attributes.begin(); iter != attributes.end(); iter++)
 	{
-		XMLAttribute* attr = new XMLAttribute(**iter);
+		XMLAttribute* attr = NewAttribute(**iter);
 		if (attr)
-		{
-			mAttributeList.push_back(attr);
-			mAttributeMap[attr->Name()] = attr;
-		}
+			AdoptAttribute(attr);
+	}
+}
+
+// Each attribute is made once straight from the parser's views, only its value being copied
+void XMLNode::SetAttributes(const XMLAttributeViewList& attributes)
+{
+	CleanAttributes();
+
+	XMLNameTable& names = mDocument->Names();
+	for(XMLAttributeViewList::const_iterator iter = attributes.begin(); iter != attributes.end(); iter++)
+	{
+		XMLAttribute* attr = NewAttribute(cdstring::null_str, cdstring::null_str);
+		attr->mValue.assign((*iter).mValue.Data(), (*iter).mValue.Length());
+		attr->Attach(names, names.Intern((*iter).mName.Data(), (*iter).mName.Length()));
+		mAttributeList.push_back(attr);
 	}
 }
 
 bool XMLNode::HasAttribute(const cdstring& name) const
 {
-	// Check map for item
-	XMLAttributeMap::const_iterator found = mAttributeMap.find(name);
-	return (found != mAttributeMap.end());
+	return FindAttribute(name) != NULL;
 }
 
 XMLAttribute* XMLNode::Attribute(const cdstring& name)
 {
-	// Find it
-	XMLAttributeMap::const_iterator found = mAttributeMap.find(name);
-	if (found != mAttributeMap.end())
-		return found->second;
-	else
+	return FindAttribute(name);
+}
+
+// Attributes are few per element so a scan comparing interned ids beats a map
+XMLAttribute* XMLNode::FindAttribute(const cdstring& name) const
+{
+	// A name that was never interned cannot be on any attribute
+	uint32_t id;
+	if (!mDocument->Names().Find(name.c_str(), name.length(), id))
 		return NULL;
+
+	for(XMLAttributeList::const_iterator iter = mAttributeList.begin(); iter != mAttributeList.end(); iter++)
+	{
+		if ((*iter)->mNameID == id)
+			return *iter;
+	}
+
+	return NULL;
+}
+
+void XMLNode::AdoptAttribute(XMLAttribute* attr)
+{
+	attr->Attach(mDocument->Names(), mDocument->Names().Intern(attr->Name()));
+	mAttributeList.push_back(attr);
 }
 
 bool XMLNode::AttributeValue(const cdstring& name, cdstring& value) const
@@ -253,44 +342,40 @@ bool XMLNode::AttributeValue(const cdstring& name, cdstring& value) const
 bool XMLNode::AttributeValue(const cdstring& name, uint32_t& value) const
 {
 	const XMLAttribute* found = Attribute(name);
-	if (found)
-	{
-		value = strtoul(found->Value().c_str(), NULL, 10);
-		return true;
-	}
-	else
-		return false;	
+	return (found != NULL) && XMLParseValue(found->Value(), value);
 }
 
 bool XMLNode::AttributeValue(const cdstring& name, int32_t& value) const
 {
 	const XMLAttribute* found = Attribute(name);
-	if (found)
-	{
-		value = strtol(found->Value().c_str(), NULL, 10);
-		return true;
-	}
-	else
-		return false;	
+	return (found != NULL) && XMLParseValue(found->Value(), value);
+}
+
+bool XMLNode::AttributeValue(const cdstring& name, uint64_t& value) const
+{
+	const XMLAttribute* found = Attribute(name);
+	return (found != NULL) && XMLParseValue(found->Value(), value);
+}
+
+bool XMLNode::AttributeValue(const cdstring& name, int64_t& value) const
+{
+	const XMLAttribute* found = Attribute(name);
+	return (found != NULL) && XMLParseValue(found->Value(), value);
+}
+
+bool XMLNode::AttributeValue(const cdstring& name, double& value) const
+{
+	const XMLAttribute* found = Attribute(name);
+	return (found != NULL) && XMLParseValue(found->Value(), value);
 }
 
 bool XMLNode::AttributeValue(const cdstring& name, uint32_t& index, const char** array) const
 {
-	// Get the string value
-	cdstring txt;
-	AttributeValue(name, txt);
+	// Compared in place - a missing attribute matches nothing
+	const XMLAttribute* found = Attribute(name);
+	if ((found != NULL) && XMLParseEnum(found->Value().c_str(), found->Value().length(), array, index))
+		return true;
 
-	// Loop over all items in NULL terminated array looking for a match
-	index = 0;
-	const char* p = array[index];
-	while(p != NULL)
-	{
-		if (txt == p)
-			return true;
-		
-		p = array[++index];
-	}
-	
 	index = 0;
 	return false;
 }
@@ -298,34 +383,51 @@ bool XMLNode::AttributeValue(const cdstring& name, uint32_t& index, const char**
 bool XMLNode::AttributeValue(const cdstring& name, bool& value) const
 {
 	const XMLAttribute* found = Attribute(name);
-	if (found)
-	{
-		value = found->Value() == cXMLValueTrue;
-		return true;
-	}
-	else
-		return false;	
+	return (found != NULL) && XMLParseValue(found->Value(), value);
 }
 
 void XMLNode::AddAttribute(const cdstring& name, const cdstring& value)
 {
 	// Does it already exist
-	if (mAttributeMap.find(name) != mAttributeMap.end())
+	if (HasAttribute(name))
 		return;
 	
 	// Create the new attribute
-	XMLAttribute* attr = new XMLAttribute(name, value);
+	XMLAttribute* attr = NewAttribute(name, value);
 	if (attr)
-	{
-		mAttributeList.push_back(attr);
-		mAttributeMap[attr->Name()] = attr;
-	}
+		AdoptAttribute(attr);
+}
+
+// Values are formatted on the stack so the only string made is the attribute's own
+template <class T> static void AddValue(XMLNode* node, const cdstring& name, T value)
+{
+	char buffer[cXMLMaxValueLength];
+	node->AddAttribute(name, cdstring(buffer, XMLFormatValue(value, buffer)));
 }
 
 void XMLNode::AddAttribute(const cdstring& name, uint32_t value)
 {
-	// Convert to string and add
-	AddAttribute(name, cdstring(value));
+	AddValue(this, name, value);
+}
+
+void XMLNode::AddAttribute(const cdstring& name, int32_t value)
+{
+	AddValue(this, name, value);
+}
+
+void XMLNode::AddAttribute(const cdstring& name, uint64_t value)
+{
+	AddValue(this, name, value);
+}
+
+void XMLNode::AddAttribute(const cdstring& name, int64_t value)
+{
+	AddValue(this, name, value);
+}
+
+void XMLNode::AddAttribute(const cdstring& name, double value)
+{
+	AddValue(this, name, value);
 }
 
 void XMLNode::AddAttribute(const cdstring& name, uint32_t index, const char** array)
@@ -350,26 +452,21 @@ void XMLNode::AddAttribute(XMLAttribute* attr)
 	if (HasAttribute(attr->Name()))
 		RemoveAttribute(attr->Name());
 	
-	// Add to list and map
-	mAttributeList.push_back(attr);
-	mAttributeMap[attr->Name()] = attr;
+	// Add to list
+	AdoptAttribute(attr);
 }
 
 void XMLNode::RemoveAttribute(const cdstring& name)
 {
 	// Must exist
-	XMLAttributeMap::iterator found = mAttributeMap.find(name);
-	if (found != mAttributeMap.end())
+	XMLAttribute* attr = FindAttribute(name);
+	if (attr != NULL)
 	{
-		// Get the attribute
-		XMLAttribute* attr = found->second;
-
-		// Remove from list and map
+		// Remove from list
 		mAttributeList.remove(attr);
-		mAttributeMap.erase(found);
 		
 		// Delete it
-		delete attr;
+		XMLAttribute_Delete(attr);
 	}
 }
 
@@ -381,7 +478,7 @@ void XMLNode::SetChildren(const XMLNodeList& children)
 	// Add each new one to list and map
 	for(XMLNodeList::const_iterator iter = children.begin(); iter != children.end(); iter++)
 	{
-		XMLNode* child = new XMLNode(**iter, this);
+		XMLNode* child = mInArena ? mDocument->CreateNode(**iter, this) : new XMLNode(**iter, this);
 		if (child)
 			mChildren.push_back(child);
 	}
@@ -391,15 +488,48 @@ void XMLNode::AddChild(XMLNode* child)
 {
 	// Just add to list if it exists
 	if (child)
+	{
 		mChildren.push_back(child);
+		InvalidateChildIndex();
+	}
+}
+
+void XMLNode::RemoveChild(XMLNode* child)
+{
+	// Most likely the last one added so search backwards
+	for(XMLNodeList::iterator iter = mChildren.end(); iter != mChildren.begin(); )
+	{
+		if (*--iter == child)
+		{
+			mChildren.erase(iter);
+			InvalidateChildIndex();
+			break;
+		}
+	}
+}
+
+// Full names can only be looked up by string when the hash index is not in use
+static bool MatchesFullName(const XMLNode* node, const cdstring& fullname)
+{
+	const cdstring& ns = node->Namespace();
+	const cdstring& name = node->Name();
+
+	return (ns.length() + name.length() == fullname.length()) &&
+			(::memcmp(fullname.c_str(), ns.c_str(), ns.length()) == 0) &&
+			(::memcmp(fullname.c_str() + ns.length(), name.c_str(), name.length()) == 0);
 }
 
 const XMLNode* XMLNode::GetChild(const cdstring& name) const
 {
+	// Use the index if there is one
+	const XMLNodeIndex* index = ChildIndex();
+	if (index != NULL)
+		return index->Find(*mDocument, name);
+
 	// Find the first one with the required name
 	for(XMLNodeList::const_iterator iter = mChildren.begin(); iter != mChildren.end(); iter++)
 	{
-		if ((*iter)->GetFullName() == name)
+		if (MatchesFullName(*iter, name))
 			return *iter;
 	}
 	
@@ -408,102 +538,136 @@ const XMLNode* XMLNode::GetChild(const cdstring& name) const
 
 const XMLNode* XMLNode::GetChild(const XMLName& name) const
 {
+	// Names that were never interned cannot be present
+	XMLNodeIndex::SKey key;
+	if (!XMLNodeIndex::MakeKey(key, *mDocument, name))
+		return NULL;
+
+	// Use the index if there is one
+	const XMLNodeIndex* index = ChildIndex();
+	if (index != NULL)
+		return index->Find(key);
+
 	// Find the first one with the required name
 	for(XMLNodeList::const_iterator iter = mChildren.begin(); iter != mChildren.end(); iter++)
 	{
-		if ((*iter)->CompareFullName(name))
+		if (XMLNodeIndex::Matches(*iter, key))
 			return *iter;
 	}
 	
 	return NULL;
 }
 
-const XMLNodeMap* XMLNode::ChildMap() const
+void XMLNode::GetChildren(const cdstring& name, XMLConstNodeList& result) const
 {
-	XMLNodeMap* result = new XMLNodeMap;
+	// Use the index if there is one
+	const XMLNodeIndex* index = ChildIndex();
+	if ((index != NULL) && index->FindAll(*mDocument, name, result))
+		return;
 
-	// Now add children
 	for(XMLNodeList::const_iterator iter = mChildren.begin(); iter != mChildren.end(); iter++)
 	{
-		result->insert(XMLNodeMap::value_type((*iter)->Name(), *iter));
+		if (MatchesFullName(*iter, name))
+			result.push_back(*iter);
 	}
-	
-	return result;
 }
 
-void XMLNode::DetermineNamespace()
+void XMLNode::GetChildren(const XMLName& name, XMLConstNodeList& result) const
 {
-	// Look for xmlns attributes
-	
-	// Look for the default one first
-	bool had_default = false;
-	if (mAttributeMap.count("xmlns") != 0)
+	// Names that were never interned cannot be present
+	XMLNodeIndex::SKey key;
+	if (!XMLNodeIndex::MakeKey(key, *mDocument, name))
+		return;
+
+	// Use the index if there is one
+	const XMLNodeIndex* index = ChildIndex();
+	if (index != NULL)
 	{
-		cdstring default_ns = (*mAttributeMap.find("xmlns")).second->Value();
-		mNamespaceIndex = mDocument->AddNamespace(XMLNamespace(default_ns));
-		mNamespaceDefault = true;
-		had_default = true;
+		index->FindAll(key, result);
+		return;
 	}
-	
-	// Now look for prefixes
+
+	for(XMLNodeList::const_iterator iter = mChildren.begin(); iter != mChildren.end(); iter++)
+	{
+		if (XMLNodeIndex::Matches(*iter, key))
+			result.push_back(*iter);
+	}
+}
+
+// Build the index on first use, but only when there are enough children to make it worthwhile
+const XMLNodeIndex* XMLNode::ChildIndex() const
+{
+	if ((mChildIndex == NULL) && (mChildren.size() > cChildIndexThreshold))
+		mChildIndex = new XMLNodeIndex(mChildren);
+	return mChildIndex;
+}
+
+void XMLNode::InvalidateChildIndex()
+{
+	delete mChildIndex;
+	mChildIndex = NULL;
+}
+
+void XMLNode::DetermineNamespace(XMLNamespaceScope* scope)
+{
+	// The default namespace is inherited unless this element declares its own
+	mDefaultNamespace = (mParent != NULL) ? mParent->mDefaultNamespace : 0;
+
+	// Look for xmlns attributes - the first five characters are enough to pass over the rest
 	for(XMLAttributeList::const_iterator iter = mAttributeList.begin(); iter != mAttributeList.end(); iter++)
 	{
-		if ((*iter)->Name().compare(0, 6, "xmlns:") == 0)
+		const cdstring& attr_name = (*iter)->Name();
+		if ((attr_name.length() < 5) || (::memcmp(attr_name.c_str(), "xmlns", 5) != 0))
+			continue;
+
+		if (attr_name.length() == 5)
+			mDefaultNamespace = mDocument->AddNamespace(XMLNamespace((*iter)->Value()));
+		else if (attr_name[5] == ':')
 		{
-			// Get the prefix and namespace name (attribute value)
-			cdstring prefix((*iter)->Name(), 6, cdstring::npos);
-			cdstring ns = (*iter)->Value();
-			
-			// Add namespace to document
-			uint32_t ns_index = mDocument->AddNamespace(XMLNamespace(ns, prefix));
-			
-			// Add to map
-			mNamespaceLookup.insert(XMLNamespaceLookup::value_type(prefix, ns_index));
+			// Add namespace to document and bring its prefix into scope
+			cdstring prefix(attr_name, 6, cdstring::npos);
+			uint32_t ns_index = mDocument->AddNamespace(XMLNamespace((*iter)->Value(), prefix));
+			if (scope != NULL)
+				scope->Bind(mDocument->Names().Intern(prefix), ns_index);
 		}
 	}
 	
 	// Now determine this elements namespace
-	cdstring::size_type cpos = mName.find(':');
-	if (cpos != cdstring::npos)
-	{
-		// Get the prefix
-		cdstring prefix(mName, 0, cpos);
-		
-		// Lookup the index
-		mNamespaceIndex = GetNamespaceIndexFromPrefix(prefix);
-		mNamespaceDefault = false;
+	const cdstring& name = Name();
+	const char* colon = static_cast<const char*>(::memchr(name.c_str(), ':', name.length()));
+	if (colon != NULL)
+	{
+		// Lookup the prefix - undeclared ones are in no namespace
+		size_t cpos = colon - name.c_str();
+		uint32_t prefix_id;
+		if (scope == NULL)
+			mNamespaceIndex = GetNamespaceIndexFromPrefix(cdstring(name, 0, cpos));
+		else if (!mDocument->Names().Find(name.c_str(), cpos, prefix_id) || !scope->Lookup(prefix_id, mNamespaceIndex))
+			mNamespaceIndex = 0;
 		
 		// Reset the name to exclude the prefix
-		mName.erase(0, cpos + 1);
-	}
-	else if (!had_default)
-	{
-		// Find the parent that has a default namepsace definition and use that
-		XMLNode* parent = mParent;
-		while (parent != NULL)
-		{
-			if (parent->mNamespaceDefault)
-			{
-				mNamespaceIndex = parent->mNamespaceIndex;
-				break;
-			}
-			else
-				parent = parent->mParent;
-		}
+		mNameID = mDocument->Names().Intern(colon + 1, name.length() - cpos - 1);
 	}
+	else
+		mNamespaceIndex = mDefaultNamespace;
+
+	// Name or namespace may have changed
+	ParentChanged();
 }
 
+// Only used when there is no parser scope, so it is fine to walk the ancestors
 uint32_t XMLNode::GetNamespaceIndexFromPrefix(const cdstring& prefix) const
 {
-	// See if its in this node's prefix map
-	XMLNamespaceLookup::const_iterator found = mNamespaceLookup.find(prefix);
-	if (found != mNamespaceLookup.end())
+	cdstring attr_name("xmlns:");
+	attr_name += prefix;
+	for(const XMLNode* node = this; node != NULL; node = node->mParent)
 	{
-		return (*found).second;
+		const XMLAttribute* found = node->FindAttribute(attr_name);
+		if (found != NULL)
+			return mDocument->AddNamespace(XMLNamespace(found->Value(), prefix));
 	}
 	
-	// Otherwise ask parent node
-	return mParent != NULL ? mParent->GetNamespaceIndexFromPrefix(prefix) : 0;
+	return 0;
 }
 
 cdstring XMLNode::GetFullName() const
@@ -524,67 +688,87 @@ cdstring XMLNode::GetPrefixName() const
 	return result;
 }
 
+// Generated output is collected in one buffer sized from the tree up to this limit, then
+// written in blocks of that size
+const size_t cGenerateBufferMax = 4 * 1024 * 1024;
+
+size_t XMLNode::GenerateBufferSize(size_t estimate)
+{
+	return (estimate < cGenerateBufferMax) ? estimate + 1 : cGenerateBufferMax;
+}
+
 void XMLNode::Generate(std::ostream& os, uint32_t level, bool indent) const
 {
-	// Initially we will not do xmlns shortcuts
-	
-	// Indent
-	if (indent)
-	{
-		for(uint32_t ctr = 0; ctr < level; ctr++)
-			os << "\t";
-	}
+	XMLLIB_STATS_TIMER(eTimerGenerate);
+
+	XMLWriter writer(os, indent, GenerateBufferSize(GenerateSize(level, indent)));
+	writer.SetBaseLevel(level);
+	Generate(writer);
+	writer.Flush();
+}
 
+void XMLNode::GenerateChildren(std::ostream& os, uint32_t level, bool indent) const
+{
+	XMLLIB_STATS_TIMER(eTimerGenerate);
+
+	size_t size = 0;
+	for(XMLNodeList::const_iterator iter = mChildren.begin(); iter != mChildren.end(); iter++)
+		size += (*iter)->GenerateSize(level, indent);
+
+	XMLWriter writer(os, indent, GenerateBufferSize(size));
+	writer.SetBaseLevel(level);
+	for(XMLNodeList::const_iterator iter = mChildren.begin(); iter != mChildren.end(); iter++)
+		(*iter)->Generate(writer);
+	writer.Flush();
+}
+
+// Initially we will not do xmlns shortcuts
+void XMLNode::Generate(XMLWriter& writer) const
+{
 	// Do name with prefix namespace
-	os << "<" << GetPrefixName();
+	writer.StartPrefixedElement(mDocument->GetNamespacePrefix(mNamespaceIndex), Name());
 	
 	// Do each attribute
 	for(XMLAttributeList::const_iterator iter = mAttributeList.begin(); iter != mAttributeList.end(); iter++)
-	{
-		os << " " << (*iter)->Name() << "=\"" << (*iter)->Value() << "\"";
-	}
-	
-	// See if we have an empty tag and close it
-	if (mData.empty() && mChildren.empty())
-	{
-		os << "/>" << std::endl;
-		return;
-	}
-	else
-		os << ">";
+		writer.Attribute((*iter)->Name(), (*iter)->Value());
 	
 	// Do children
-	if (mChildren.size())
-	{
-		os << std::endl;
-		GenerateChildren(os, level + 1, indent);
-	}
+	for(XMLNodeList::const_iterator iter = mChildren.begin(); iter != mChildren.end(); iter++)
+		(*iter)->Generate(writer);
 
 	// Now do data
-	if (!mData.empty())
-		GenerateData(os, mData);
-	
-	// Indent
-	if (indent && (mChildren.size() != 0))
-	{
-		for(uint32_t ctr = 0; ctr < level; ctr++)
-			os << "\t";
-	}
+	writer.Text(mData);
 
-	// End tag
-	os << "</" << GetPrefixName() << ">" << std::endl;
+	writer.EndElement();
 }
 
-void XMLNode::GenerateChildren(std::ostream& os, uint32_t level, bool indent) const
+// Size of the generated output before escaping
+size_t XMLNode::GenerateSize(uint32_t level, bool indent) const
 {
-	// Now do children
-	for(XMLNodeList::const_iterator iter = mChildren.begin(); iter != mChildren.end(); iter++)
+	size_t indent_size = indent ? level : 0;
+	size_t name_size = mDocument->GetNamespacePrefix(mNamespaceIndex).length() + 1 + Name().length();
+
+	// Start tag
+	size_t size = indent_size + 1 + name_size;
+	for(XMLAttributeList::const_iterator iter = mAttributeList.begin(); iter != mAttributeList.end(); iter++)
+		size += (*iter)->Name().length() + (*iter)->Value().length() + 4;
+
+	if (mData.empty() && mChildren.empty())
+		return size + 3;
+
+	size += 1;
+	if (!mChildren.empty())
 	{
-		(*iter)->Generate(os, level, indent);
+		size += 1 + indent_size;
+		for(XMLNodeList::const_iterator iter = mChildren.begin(); iter != mChildren.end(); iter++)
+			size += (*iter)->GenerateSize(level + 1, indent);
 	}
+
+	// Data and end tag
+	return size + mData.length() + name_size + 4;
 }
 
-const char cXMLReserved[] = // XML chars to escape
+const char cXMLReserved[256] = // XML chars to escape
   { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,		// 0 - 15
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,		// 16 - 31
     0, 0, 1, 0, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0,		// 32 - 47
@@ -653,7 +837,7 @@ void XMLNode::GenerateData(std::ostream& os, const cdstring& data) const
 void XMLNode::DebugPrint(std::ostream& os, uint32_t level) const
 {
 	// Always start new line for new node
-	os << std::endl;
+	os << '\n';
 
 	// Indent
 	for(uint32_t ctr = 0; ctr < level; ctr++)
@@ -662,13 +846,15 @@ void XMLNode::DebugPrint(std::ostream& os, uint32_t level) const
 	os << "<" << GetPrefixName();
 	for(XMLAttributeList::const_iterator iter = mAttributeList.begin(); iter != mAttributeList.end(); iter++)
 	{
-		os << " " << (*iter)->Name() << "=\"" << (*iter)->Value() << "\"";
+		os << " " << (*iter)->Name() << "=\"";
+		GenerateData(os, (*iter)->Value());
+		os << "\"";
 	}
 	
 	// See if we have an empty tag and close it
 	if (mData.empty() && mChildren.empty())
 	{
-		os << "/>" << std::endl;
+		os << "/>" << '\n';
 		return;
 	}
 	else
@@ -692,7 +878,7 @@ void XMLNode::DebugPrint(std::ostream& os, uint32_t level) const
 	}
 
 	// End tag
-	os << "</" << GetPrefixName() << ">" << std::endl;
+	os << "</" << GetPrefixName() << ">" << '\n';
 }
 
 }
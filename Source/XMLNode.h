@@ -21,9 +21,10 @@
 
 #include "XMLAttribute.h"
 #include "XMLNamespace.h"
+#include "XMLStringView.h"
 
 #include <stdint.h>
-#include <map>
+#include <vector>
 
 
 #include "cdstring.h"
@@ -33,11 +34,20 @@ namespace xmllib
 
 class XMLNode;
 typedef std::list<XMLNode*> XMLNodeList;
-typedef std::map<cdstring, XMLNode*> XMLNodeMap;
+typedef std::vector<const XMLNode*> XMLConstNodeList;
 
 class XMLDocument;
 class XMLNamespace;
+class XMLNamespaceScope;
 class XMLName;
+class XMLNodeIndex;
+class XMLWriter;
+
+// Characters that must be escaped in text and attribute values
+extern const char cXMLReserved[256];
+
+extern const char* cXMLValueTrue;
+extern const char* cXMLValueFalse;
 
 class XMLNode
 {
@@ -51,6 +61,10 @@ public:
 		_init(doc, parent, name, &namespc);
 	}
 	explicit XMLNode(XMLDocument* doc, XMLNode* parent, const XMLName& name);
+	explicit XMLNode(XMLDocument* doc, XMLNode* parent, const XMLStringView& name)
+	{
+		_init(doc, parent, name.Data(), name.Length());
+	}
 	XMLNode(XMLDocument* doc, XMLNode* parent, const cdstring& name, const cdstring& data)
 	{
 		_init(doc, parent, name);
@@ -102,34 +116,46 @@ public:
 		SetData(data);
 	}
 	explicit XMLNode(const XMLNode& copy)
-		{ _copy(copy); }
+		{ mParent = NULL; mInArena = false; mChildIndex = NULL; _copy(copy); }
 	explicit XMLNode(const XMLNode& copy, XMLNode* parent)
-		{ mParent = parent; _copy(copy); }
+		{ mParent = parent; mInArena = false; mChildIndex = NULL; _copy(copy); }
 	~XMLNode();
 
 	XMLNode& operator=(const XMLNode& copy)
 		{ if (this != &copy) _copy(copy); return *this; }
+
+	// Nodes created by XMLDocument::CreateNode live in the document's arena
+	bool InArena() const
+		{ return mInArena; }
+
+	XMLDocument* Document() const
+		{ return mDocument; }
 	
-	// Name
-	const cdstring& Name() const
-		{ return mName; }
-	void SetName(const cdstring& name)
-		{ mName = name; }
+	// Name - stored as an id in the document's name table
+	const cdstring& Name() const;
+	uint32_t NameID() const
+		{ return mNameID; }
+	void SetName(const cdstring& name);
 	void SetName(const cdstring& name, const XMLNamespace& namespc);
 	void SetName(const XMLName& name);
+	void SetName(const XMLStringView& name);
 
 	bool CompareFullName(const XMLName& xmlname) const;
 
 	// Namespace
 	void AddNamespace(const XMLNamespace& namespc);
 	const cdstring& Namespace() const;
+	uint32_t NamespaceNameID() const;
 
-	// Data content
+	// Data content - typed values are converted as XMLParseValue and XMLFormatValue do
 	const cdstring& Data() const
 		{ return mData; }
 	bool DataValue(cdstring& value) const;
 	bool DataValue(uint32_t& value) const;
 	bool DataValue(int32_t& value) const;
+	bool DataValue(uint64_t& value) const;
+	bool DataValue(int64_t& value) const;
+	bool DataValue(double& value) const;
 	bool DataValue(bool& value) const;
 	void SetData(const cdstring& data)
 		{ mData = data; }
@@ -137,14 +163,20 @@ public:
 		{ mData = data; }
 	void SetData(uint32_t data);
 	void SetData(int32_t data);
+	void SetData(uint64_t data);
+	void SetData(int64_t data);
+	void SetData(double data);
 	void SetData(bool data);
 	void AppendData(const cdstring& data)
 		{ mData += data; }
+	void AppendData(const XMLStringView& data)
+		{ mData.append(data.Data(), data.Length()); }
 
 	// Attributes
 	const XMLAttributeList& Attributes() const
 		{ return mAttributeList; }
 	void SetAttributes(const XMLAttributeList& attributes);
+	void SetAttributes(const XMLAttributeViewList& attributes);
 
 	bool HasAttribute(const cdstring& name) const;
 	XMLAttribute* Attribute(const cdstring& name);
@@ -154,6 +186,9 @@ public:
 	bool AttributeValue(const cdstring& name, cdstring& value) const;
 	bool AttributeValue(const cdstring& name, uint32_t& value) const;
 	bool AttributeValue(const cdstring& name, int32_t& value) const;
+	bool AttributeValue(const cdstring& name, uint64_t& value) const;
+	bool AttributeValue(const cdstring& name, int64_t& value) const;
+	bool AttributeValue(const cdstring& name, double& value) const;
 	bool AttributeValue(const cdstring& name, uint32_t& index, const char** array) const;
 	bool AttributeValue(const cdstring& name, bool& value) const;
 
@@ -165,28 +200,35 @@ public:
 	}
 	void AddAttribute(const cdstring& name, uint32_t value);
 	void AddAttribute(const cdstring& name, int32_t value);
+	void AddAttribute(const cdstring& name, uint64_t value);
+	void AddAttribute(const cdstring& name, int64_t value);
+	void AddAttribute(const cdstring& name, double value);
 	void AddAttribute(const cdstring& name, uint32_t index, const char** array);
 	void AddAttribute(const cdstring& name, bool value);
 	void AddAttribute(XMLAttribute* value);
 
 	void RemoveAttribute(const cdstring& name);
 
-	// Child nodes
+	// Child nodes - lookups by name use a hash index once there are enough children. The
+	// index is built lazily, so concurrent lookups on the same node need external locking.
 	const XMLNodeList& Children() const
 		{ return mChildren; }
 	void SetChildren(const XMLNodeList& children);
 	void AddChild(XMLNode* child);
+	void RemoveChild(XMLNode* child);		// Caller deletes the child
 	const XMLNode* GetChild(const cdstring& name) const;
 	const XMLNode* GetChild(const XMLName& name) const;
-	const XMLNodeMap* ChildMap() const;
+	void GetChildren(const cdstring& name, XMLConstNodeList& result) const;
+	void GetChildren(const XMLName& name, XMLConstNodeList& result) const;
 
-	// Namespace handling
-	void DetermineNamespace();
+	// Namespace handling - a parser passes in the prefixes in scope with a level opened for
+	// this element, otherwise prefixes are looked up in the xmlns attributes of its ancestors
+	void DetermineNamespace(XMLNamespaceScope* scope = NULL);
 	uint32_t GetNamespaceIndexFromPrefix(const cdstring& prefix) const;
 	cdstring GetFullName() const;
 	cdstring GetPrefixName() const;
 
-	// Generating XML
+	// Generating XML - output is buffered and written to the stream in large blocks
 	void Generate(std::ostream& os, uint32_t level = 0, bool indent = true) const;
 	void GenerateChildren(std::ostream& os, uint32_t level = 0, bool indent = true) const;
 	void GenerateData(std::ostream& os, const cdstring& data) const;
@@ -195,29 +237,58 @@ public:
 	void DebugPrint(std::ostream& os, uint32_t level = 0) const;
 
 private:
-	typedef std::map<cdstring, uint32_t>	XMLNamespaceLookup;
+	friend class XMLDocument;
+	friend class XMLSnapshot;
 
 	XMLDocument*		mDocument;
 	XMLNode*			mParent;
+	bool				mInArena;
 
-	cdstring			mName;
+	uint32_t			mNameID;
 	cdstring			mData;
 	
 	XMLAttributeList	mAttributeList;
-	XMLAttributeMap		mAttributeMap;
 	
 	XMLNodeList			mChildren;
+	mutable XMLNodeIndex*	mChildIndex;
 
 	uint32_t			mNamespaceIndex;
-	bool				mNamespaceDefault;
-	XMLNamespaceLookup	mNamespaceLookup;
+	uint32_t			mDefaultNamespace;	// Default namespace in scope inside the element
 
-	void _init(XMLDocument* doc, XMLNode* parent, const cdstring& name, const XMLNamespace* namespc = NULL);
+	void _init(XMLDocument* doc, XMLNode* parent, const cdstring& name, const XMLNamespace* namespc = NULL)
+		{ _init(doc, parent, name.c_str(), name.length(), namespc); }
+	void _init(XMLDocument* doc, XMLNode* parent, const char* name, size_t length, const XMLNamespace* namespc = NULL);
 	void _copy(const XMLNode& copy);
 	
 	void CleanAttributes();
 	void CleanChildren();
+
+	XMLAttribute* FindAttribute(const cdstring& name) const;
+	void AdoptAttribute(XMLAttribute* attr);
+
+	const XMLNodeIndex* ChildIndex() const;
+	void InvalidateChildIndex();
+	void ParentChanged()
+		{ if (mParent != NULL) mParent->InvalidateChildIndex(); }
+
+	void Generate(XMLWriter& writer) const;
+	size_t GenerateSize(uint32_t level, bool indent) const;
+	static size_t GenerateBufferSize(size_t estimate);
+
+	XMLAttribute* NewAttribute(const cdstring& name, const cdstring& value);
+	XMLAttribute* NewAttribute(const XMLAttribute& copy);
 };
 
+// Arena nodes only need their destructor run - the document's arena owns the memory
+inline void XMLNode_Delete(XMLNode* node)
+{
+	if (node == NULL)
+		return;
+	if (node->InArena())
+		node->~XMLNode();
+	else
+		delete node;
+}
+
 }
 #endif
@@ -0,0 +1,162 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Source for XMLNodeIndex class
+
+#include "XMLNodeIndex.h"
+
+#include "XMLDocument.h"
+#include "XMLName.h"
+
+#include <cstring>
+
+using namespace xmllib;
+
+XMLNodeIndex::XMLNodeIndex(const XMLNodeList& children)
+{
+	// Table is at most half full
+	uint32_t size = 16;
+	while(size < children.size() * 2)
+		size <<= 1;
+	mMask = size - 1;
+	mSlots.assign(size, -1);
+	mEntries.reserve(children.size());
+
+	// Tail of each chain so duplicates stay in document order
+	std::vector<int32_t> tails(size, -1);
+
+	for(XMLNodeList::const_iterator iter = children.begin(); iter != children.end(); iter++)
+	{
+		SEntry entry;
+		entry.mKey.mNamespaceID = (*iter)->NamespaceNameID();
+		entry.mKey.mNameID = (*iter)->NameID();
+		entry.mNode = *iter;
+		entry.mNext = -1;
+		int32_t index = mEntries.size();
+		mEntries.push_back(entry);
+
+		// Probe for an existing chain or an empty slot
+		uint32_t slot = Hash(entry.mKey) & mMask;
+		while(true)
+		{
+			int32_t first = mSlots[slot];
+			if (first == -1)
+			{
+				mSlots[slot] = index;
+				tails[slot] = index;
+				break;
+			}
+			if (SameKey(mEntries[first].mKey, entry.mKey))
+			{
+				mEntries[tails[slot]].mNext = index;
+				tails[slot] = index;
+				break;
+			}
+			slot = (slot + 1) & mMask;
+		}
+	}
+}
+
+const XMLNode* XMLNodeIndex::Find(const SKey& key) const
+{
+	int32_t first = FindFirst(key);
+	return (first != -1) ? mEntries[first].mNode : NULL;
+}
+
+void XMLNodeIndex::FindAll(const SKey& key, XMLConstNodeList& result) const
+{
+	for(int32_t index = FindFirst(key); index != -1; index = mEntries[index].mNext)
+		result.push_back(mEntries[index].mNode);
+}
+
+const XMLNode* XMLNodeIndex::Find(const XMLDocument& doc, const cdstring& fullname) const
+{
+	SKeyList keys;
+	SplitFullName(doc, fullname, keys);
+
+	// Earliest child matching any of the possible splits
+	int32_t result = -1;
+	for(SKeyList::const_iterator iter = keys.begin(); iter != keys.end(); iter++)
+	{
+		int32_t first = FindFirst(*iter);
+		if ((first != -1) && ((result == -1) || (first < result)))
+			result = first;
+	}
+
+	return (result != -1) ? mEntries[result].mNode : NULL;
+}
+
+// Returns false when the full name splits more than one way, as the matches from each chain
+// would then need merging back into document order
+bool XMLNodeIndex::FindAll(const XMLDocument& doc, const cdstring& fullname, XMLConstNodeList& result) const
+{
+	SKeyList keys;
+	SplitFullName(doc, fullname, keys);
+	if (keys.size() > 1)
+		return false;
+
+	if (keys.size() == 1)
+		FindAll(keys.front(), result);
+	return true;
+}
+
+int32_t XMLNodeIndex::FindFirst(const SKey& key) const
+{
+	uint32_t slot = Hash(key) & mMask;
+	while(true)
+	{
+		int32_t first = mSlots[slot];
+		if ((first == -1) || SameKey(mEntries[first].mKey, key))
+			return first;
+		slot = (slot + 1) & mMask;
+	}
+}
+
+bool XMLNodeIndex::MakeKey(SKey& key, const XMLDocument& doc, const XMLName& name)
+{
+	const char* namespc = (name.Namespace() != NULL) ? name.Namespace() : "";
+	const char* local = (name.Name() != NULL) ? name.Name() : "";
+	return doc.Names().Find(namespc, key.mNamespaceID) && doc.Names().Find(local, key.mNameID);
+}
+
+// A full name has no separator, so try each of the document's namespaces as a prefix
+void XMLNodeIndex::SplitFullName(const XMLDocument& doc, const cdstring& fullname, SKeyList& keys)
+{
+	for(uint32_t i = 0; i < doc.CountNamespaces(); i++)
+	{
+		const cdstring& ns = doc.GetNamespace(i);
+		if ((ns.length() > fullname.length()) || (::memcmp(ns.c_str(), fullname.c_str(), ns.length()) != 0))
+			continue;
+
+		SKey key;
+		key.mNamespaceID = doc.GetNamespaceID(i);
+		if (!doc.Names().Find(fullname.c_str() + ns.length(), fullname.length() - ns.length(), key.mNameID))
+			continue;
+
+		// The same namespace can appear more than once with different prefixes
+		bool duplicate = false;
+		for(SKeyList::const_iterator iter = keys.begin(); iter != keys.end(); iter++)
+		{
+			if (SameKey(*iter, key))
+			{
+				duplicate = true;
+				break;
+			}
+		}
+		if (!duplicate)
+			keys.push_back(key);
+	}
+}
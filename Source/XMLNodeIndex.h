@@ -0,0 +1,82 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Header for XMLNodeIndex class
+
+#ifndef __XMLNODEINDEX__XMLLIB__
+#define __XMLNODEINDEX__XMLLIB__
+
+#include "XMLNode.h"
+
+#include <vector>
+
+namespace xmllib
+{
+
+// Hash index over a node's children keyed by interned namespace and local name ids. Built on
+// demand by XMLNode for nodes with many children and thrown away whenever the children change.
+
+class XMLNodeIndex
+{
+public:
+	struct SKey
+	{
+		uint32_t		mNamespaceID;
+		uint32_t		mNameID;
+	};
+
+	explicit XMLNodeIndex(const XMLNodeList& children);
+
+	const XMLNode* Find(const SKey& key) const;
+	void FindAll(const SKey& key, XMLConstNodeList& result) const;
+
+	// Full names (namespace followed directly by local name, as returned by XMLNode::GetFullName)
+	const XMLNode* Find(const XMLDocument& doc, const cdstring& fullname) const;
+	bool FindAll(const XMLDocument& doc, const cdstring& fullname, XMLConstNodeList& result) const;
+
+	// False if the name was never interned, in which case nothing can match
+	static bool MakeKey(SKey& key, const XMLDocument& doc, const XMLName& name);
+	static bool Matches(const XMLNode* node, const SKey& key)
+		{ return (node->NameID() == key.mNameID) && (node->NamespaceNameID() == key.mNamespaceID); }
+
+private:
+	typedef std::vector<SKey> SKeyList;
+
+	struct SEntry
+	{
+		SKey				mKey;
+		const XMLNode*		mNode;
+		int32_t				mNext;			// Next child with the same name, -1 at the end
+	};
+
+	std::vector<SEntry>		mEntries;		// One per child in document order
+	std::vector<int32_t>	mSlots;			// First entry for each distinct name, -1 when empty
+	uint32_t				mMask;
+
+	int32_t FindFirst(const SKey& key) const;
+
+	static uint32_t Hash(const SKey& key)
+	{
+		uint32_t hash = key.mNameID * 0x9E3779B1U;
+		return hash ^ (key.mNamespaceID + 0x7F4A7C15U + (hash << 6) + (hash >> 2));
+	}
+	static bool SameKey(const SKey& key1, const SKey& key2)
+		{ return (key1.mNameID == key2.mNameID) && (key1.mNamespaceID == key2.mNamespaceID); }
+	static void SplitFullName(const XMLDocument& doc, const cdstring& fullname, SKeyList& keys);
+};
+
+}
+#endif
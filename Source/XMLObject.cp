@@ -18,11 +18,7 @@
 
 #include "XMLObject.h"
 
-#include <cerrno>
-#include <cstdio>
-#include <cstdlib>
-
-extern unsigned long strindexfind(const char* s, const char** ss, unsigned long default_index = 0);
+#include "XMLConvert.h"
 
 namespace xmllib
 {
@@ -32,6 +28,13 @@ const char* cXMLStdAttributeType = "type";
 const char* cXMLTrue = "true";
 const char* cXMLFalse = "false";
 
+// Enums are matched in place rather than through a copy of the text
+static uint32_t ReadEnum(const char* p, size_t length, const char** sarray, uint32_t default_index)
+{
+	uint32_t index;
+	return XMLParseEnum(p, length, sarray, index) ? index : default_index;
+}
+
 // Read
 void XMLObject::ReadXMLFromParent(const XMLNode* parent)
 {
@@ -61,77 +64,57 @@ bool XMLObject::ReadData(const XMLNode* node, cdstring& value)
 bool XMLObject::ReadData(const XMLNode* node, uint32_t& value, bool use_stdattribute)
 {
 	if (use_stdattribute)
-	{
 		return ReadAttribute(node, cXMLStdAttributeName, value);
-	}
 	else
-	{
-		errno = 0;
-		uint32_t temp = strtoul(node->Data().c_str(), NULL, 10);
-		if (errno == 0)
-		{
-			value = temp;
-			return true;
-		}
-		else
-			return false;
-	}
+		return XMLParseValue(node->Data(), value);
 }
 
 bool XMLObject::ReadData(const XMLNode* node, int32_t& value, bool use_stdattribute)
 {
 	if (use_stdattribute)
-	{
 		return ReadAttribute(node, cXMLStdAttributeName, value);
-	}
 	else
-	{
-		errno = 0;
-		int32_t temp = strtol(node->Data().c_str(), NULL, 10);
-		if (errno == 0)
-		{
-			value = temp;
-			return true;
-		}
-		else
-			return false;
-	}
+		return XMLParseValue(node->Data(), value);
+}
+
+bool XMLObject::ReadData(const XMLNode* node, uint64_t& value, bool use_stdattribute)
+{
+	if (use_stdattribute)
+		return ReadAttribute(node, cXMLStdAttributeName, value);
+	else
+		return XMLParseValue(node->Data(), value);
+}
+
+bool XMLObject::ReadData(const XMLNode* node, int64_t& value, bool use_stdattribute)
+{
+	if (use_stdattribute)
+		return ReadAttribute(node, cXMLStdAttributeName, value);
+	else
+		return XMLParseValue(node->Data(), value);
+}
+
+bool XMLObject::ReadData(const XMLNode* node, double& value, bool use_stdattribute)
+{
+	if (use_stdattribute)
+		return ReadAttribute(node, cXMLStdAttributeName, value);
+	else
+		return XMLParseValue(node->Data(), value);
 }
 
 bool XMLObject::ReadData(const XMLNode* node, bool& value, bool use_stdattribute)
 {
 	if (use_stdattribute)
-	{
 		return ReadAttribute(node, cXMLStdAttributeName, value);
-	}
 	else
-	{
-		if (strcmp(node->Data().c_str(), cXMLTrue) == 0)
-		{
-			value = true;
-			return true;
-		}
-		else if (strcmp(node->Data().c_str(), cXMLTrue) == 0)
-		{
-			value = false;
-			return true;
-		}
-		else
-			return false;
-	}
+		return XMLParseValue(node->Data(), value);
 }
 
 uint32_t XMLObject::ReadDataEnum(const XMLNode* node, const char** sarray, uint32_t default_index, bool use_stdattribute)
 {
 	if (use_stdattribute)
-	{
 		return ReadAttributeEnum(node, cXMLStdAttributeType, sarray, default_index);
-	}
 	else
-	{
-		cdstring temp = node->Data();
-		return ::strindexfind(temp.c_str(), sarray, default_index);
-	}
+		return ReadEnum(node->Data().c_str(), node->Data().length(), sarray, default_index);
 }
 
 bool XMLObject::ReadAttribute(const XMLNode* node, const cdstring& name, cdstring& value)
@@ -149,64 +132,167 @@ bool XMLObject::ReadAttribute(const XMLNode* node, const cdstring& name, cdstrin
 bool XMLObject::ReadAttribute(const XMLNode* node, const cdstring& name, uint32_t& value)
 {
 	const XMLAttribute* attr = node->Attribute(name);
-	if (attr)
-	{
-		errno = 0;
-		uint32_t temp = strtoul(attr->Value().c_str(), NULL, 10);
-		if (errno == 0)
-		{
-			value = temp;
-			return true;
-		}
-	}
-	
-	return false;
+	return (attr != NULL) && XMLParseValue(attr->Value(), value);
 }
 
 bool XMLObject::ReadAttribute(const XMLNode* node, const cdstring& name, int32_t& value)
 {
 	const XMLAttribute* attr = node->Attribute(name);
-	if (attr)
-	{
-		errno = 0;
-		int32_t temp = strtol(attr->Value().c_str(), NULL, 10);
-		if (errno == 0)
-		{
-			value = temp;
-			return true;
-		}
-	}
-	
-	return false;
+	return (attr != NULL) && XMLParseValue(attr->Value(), value);
 }
 
-bool XMLObject::ReadAttribute(const XMLNode* node, const cdstring& name, bool& value)
+bool XMLObject::ReadAttribute(const XMLNode* node, const cdstring& name, uint64_t& value)
 {
 	const XMLAttribute* attr = node->Attribute(name);
-	if (attr)
-	{
-		if (strcmp(attr->Value().c_str(), cXMLTrue) == 0)
-		{
-			value = true;
-			return true;
-		}
-		else if (strcmp(attr->Value().c_str(), cXMLTrue) == 0)
-		{
-			value = false;
-			return true;
-		}
-	}
+	return (attr != NULL) && XMLParseValue(attr->Value(), value);
+}
+
+bool XMLObject::ReadAttribute(const XMLNode* node, const cdstring& name, int64_t& value)
+{
+	const XMLAttribute* attr = node->Attribute(name);
+	return (attr != NULL) && XMLParseValue(attr->Value(), value);
+}
+
+bool XMLObject::ReadAttribute(const XMLNode* node, const cdstring& name, double& value)
+{
+	const XMLAttribute* attr = node->Attribute(name);
+	return (attr != NULL) && XMLParseValue(attr->Value(), value);
+}
 
-	return false;
+bool XMLObject::ReadAttribute(const XMLNode* node, const cdstring& name, bool& value)
+{
+	const XMLAttribute* attr = node->Attribute(name);
+	return (attr != NULL) && XMLParseValue(attr->Value(), value);
 }
 
 uint32_t XMLObject::ReadAttributeEnum(const XMLNode* node, const cdstring& name, const char** sarray, uint32_t default_index)
 {
 	const XMLAttribute* attr = node->Attribute(name);
 	if (attr)
-	{
-		return ::strindexfind(attr->Value().c_str(), sarray, default_index);
-	}
+		return ReadEnum(attr->Value().c_str(), attr->Value().length(), sarray, default_index);
+	else
+		return default_index;
+}
+
+// Read from a flat document
+uint32_t XMLObject::ReadValueEnum(const XMLFlatNode& parent, const XMLName& child_name, const char** sarray, uint32_t default_index)
+{
+	// Get single child node
+	XMLFlatNode child = parent.GetChild(child_name);
+	if (child.IsValid())
+		return ReadDataEnum(child, sarray, default_index);
+	else
+		return default_index;
+}
+
+bool XMLObject::ReadData(const XMLFlatNode& node, cdstring& value)
+{
+	value = node.Data().ToString();
+	return true;
+}
+
+bool XMLObject::ReadData(const XMLFlatNode& node, uint32_t& value, bool use_stdattribute)
+{
+	if (use_stdattribute)
+		return ReadAttribute(node, cXMLStdAttributeName, value);
+	else
+		return XMLParseValue(node.Data(), value);
+}
+
+bool XMLObject::ReadData(const XMLFlatNode& node, int32_t& value, bool use_stdattribute)
+{
+	if (use_stdattribute)
+		return ReadAttribute(node, cXMLStdAttributeName, value);
+	else
+		return XMLParseValue(node.Data(), value);
+}
+
+bool XMLObject::ReadData(const XMLFlatNode& node, uint64_t& value, bool use_stdattribute)
+{
+	if (use_stdattribute)
+		return ReadAttribute(node, cXMLStdAttributeName, value);
+	else
+		return XMLParseValue(node.Data(), value);
+}
+
+bool XMLObject::ReadData(const XMLFlatNode& node, int64_t& value, bool use_stdattribute)
+{
+	if (use_stdattribute)
+		return ReadAttribute(node, cXMLStdAttributeName, value);
+	else
+		return XMLParseValue(node.Data(), value);
+}
+
+bool XMLObject::ReadData(const XMLFlatNode& node, double& value, bool use_stdattribute)
+{
+	if (use_stdattribute)
+		return ReadAttribute(node, cXMLStdAttributeName, value);
+	else
+		return XMLParseValue(node.Data(), value);
+}
+
+bool XMLObject::ReadData(const XMLFlatNode& node, bool& value, bool use_stdattribute)
+{
+	if (use_stdattribute)
+		return ReadAttribute(node, cXMLStdAttributeName, value);
+	else
+		return XMLParseValue(node.Data(), value);
+}
+
+uint32_t XMLObject::ReadDataEnum(const XMLFlatNode& node, const char** sarray, uint32_t default_index, bool use_stdattribute)
+{
+	if (use_stdattribute)
+		return ReadAttributeEnum(node, cXMLStdAttributeType, sarray, default_index);
+	else
+		return ReadEnum(node.Data().Data(), node.Data().Length(), sarray, default_index);
+}
+
+bool XMLObject::ReadAttribute(const XMLFlatNode& node, const cdstring& name, cdstring& value)
+{
+	return node.AttributeValue(name, value);
+}
+
+bool XMLObject::ReadAttribute(const XMLFlatNode& node, const cdstring& name, uint32_t& value)
+{
+	XMLStringView text;
+	return node.AttributeValue(name, text) && XMLParseValue(text, value);
+}
+
+bool XMLObject::ReadAttribute(const XMLFlatNode& node, const cdstring& name, int32_t& value)
+{
+	XMLStringView text;
+	return node.AttributeValue(name, text) && XMLParseValue(text, value);
+}
+
+bool XMLObject::ReadAttribute(const XMLFlatNode& node, const cdstring& name, uint64_t& value)
+{
+	XMLStringView text;
+	return node.AttributeValue(name, text) && XMLParseValue(text, value);
+}
+
+bool XMLObject::ReadAttribute(const XMLFlatNode& node, const cdstring& name, int64_t& value)
+{
+	XMLStringView text;
+	return node.AttributeValue(name, text) && XMLParseValue(text, value);
+}
+
+bool XMLObject::ReadAttribute(const XMLFlatNode& node, const cdstring& name, double& value)
+{
+	XMLStringView text;
+	return node.AttributeValue(name, text) && XMLParseValue(text, value);
+}
+
+bool XMLObject::ReadAttribute(const XMLFlatNode& node, const cdstring& name, bool& value)
+{
+	XMLStringView text;
+	return node.AttributeValue(name, text) && XMLParseValue(text, value);
+}
+
+uint32_t XMLObject::ReadAttributeEnum(const XMLFlatNode& node, const cdstring& name, const char** sarray, uint32_t default_index)
+{
+	XMLStringView text;
+	if (node.AttributeValue(name, text))
+		return ReadEnum(text.Data(), text.Length(), sarray, default_index);
 	else
 		return default_index;
 }
@@ -235,37 +321,49 @@ void XMLObject::WriteData(XMLNode* node, const cdstring& value)
 void XMLObject::WriteData(XMLNode* node, uint32_t value, bool use_stdattribute)
 {
 	if (use_stdattribute)
-	{
 		WriteAttribute(node, cXMLStdAttributeName, value);
-	}
 	else
-	{
-		node->SetData(cdstring(value));
-	}
+		node->SetData(value);
 }
 
 void XMLObject::WriteData(XMLNode* node, int32_t value, bool use_stdattribute)
 {
 	if (use_stdattribute)
-	{
 		WriteAttribute(node, cXMLStdAttributeName, value);
-	}
 	else
-	{
-		node->SetData(cdstring(value));
-	}
+		node->SetData(value);
+}
+
+void XMLObject::WriteData(XMLNode* node, uint64_t value, bool use_stdattribute)
+{
+	if (use_stdattribute)
+		WriteAttribute(node, cXMLStdAttributeName, value);
+	else
+		node->SetData(value);
+}
+
+void XMLObject::WriteData(XMLNode* node, int64_t value, bool use_stdattribute)
+{
+	if (use_stdattribute)
+		WriteAttribute(node, cXMLStdAttributeName, value);
+	else
+		node->SetData(value);
+}
+
+void XMLObject::WriteData(XMLNode* node, double value, bool use_stdattribute)
+{
+	if (use_stdattribute)
+		WriteAttribute(node, cXMLStdAttributeName, value);
+	else
+		node->SetData(value);
 }
 
 void XMLObject::WriteData(XMLNode* node, bool value, bool use_stdattribute)
 {
 	if (use_stdattribute)
-	{
 		WriteAttribute(node, cXMLStdAttributeName, value);
-	}
 	else
-	{
-		node->SetData(cdstring(value ? cXMLTrue : cXMLFalse));
-	}
+		node->SetData(value);
 }
 
 void XMLObject::WriteDataEnum(XMLNode* node, uint32_t index, const char** sarray, bool use_stdattribute)
@@ -287,17 +385,32 @@ void XMLObject::WriteAttribute(XMLNode* node, const cdstring& name, const cdstri
 
 void XMLObject::WriteAttribute(XMLNode* node, const cdstring& name, uint32_t value)
 {
-	node->AddAttribute(name, cdstring(value));
+	node->AddAttribute(name, value);
 }
 
 void XMLObject::WriteAttribute(XMLNode* node, const cdstring& name, int32_t value)
 {
-	node->AddAttribute(name, cdstring(value));
+	node->AddAttribute(name, value);
+}
+
+void XMLObject::WriteAttribute(XMLNode* node, const cdstring& name, uint64_t value)
+{
+	node->AddAttribute(name, value);
+}
+
+void XMLObject::WriteAttribute(XMLNode* node, const cdstring& name, int64_t value)
+{
+	node->AddAttribute(name, value);
+}
+
+void XMLObject::WriteAttribute(XMLNode* node, const cdstring& name, double value)
+{
+	node->AddAttribute(name, value);
 }
 
 void XMLObject::WriteAttribute(XMLNode* node, const cdstring& name, bool value)
 {
-	node->AddAttribute(name, cdstring(value ? cXMLTrue : cXMLFalse));
+	node->AddAttribute(name, value);
 }
 
 void XMLObject::WriteAttributeEnum(XMLNode* node, const cdstring& name, uint32_t data, const char** sarray)
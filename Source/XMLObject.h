@@ -24,6 +24,7 @@
 
 #include "cdstring.h"
 
+#include "XMLFlatDocument.h"
 #include "XMLName.h"
 #include "XMLNode.h"
 
@@ -68,25 +69,59 @@ public:
 	static bool ReadData(const XMLNode* node, cdstring& value);
 	static bool ReadData(const XMLNode* node, uint32_t& value, bool use_stdattribute = true);
 	static bool ReadData(const XMLNode* node, int32_t& value, bool use_stdattribute = true);
+	static bool ReadData(const XMLNode* node, uint64_t& value, bool use_stdattribute = true);
+	static bool ReadData(const XMLNode* node, int64_t& value, bool use_stdattribute = true);
+	static bool ReadData(const XMLNode* node, double& value, bool use_stdattribute = true);
 	static bool ReadData(const XMLNode* node, bool& value, bool use_stdattribute = true);
 	static uint32_t ReadDataEnum(const XMLNode* node, const char** sarray, uint32_t default_index, bool use_stdattribute = true);
 
 	static bool ReadAttribute(const XMLNode* node, const cdstring& name, cdstring& value);
 	static bool ReadAttribute(const XMLNode* node, const cdstring& name, uint32_t& value);
 	static bool ReadAttribute(const XMLNode* node, const cdstring& name, int32_t& value);
+	static bool ReadAttribute(const XMLNode* node, const cdstring& name, uint64_t& value);
+	static bool ReadAttribute(const XMLNode* node, const cdstring& name, int64_t& value);
+	static bool ReadAttribute(const XMLNode* node, const cdstring& name, double& value);
 	static bool ReadAttribute(const XMLNode* node, const cdstring& name, bool& value);
 	static uint32_t ReadAttributeEnum(const XMLNode* node, const cdstring& name, const char** sarray, uint32_t default_index);
+
+	// Read from a flat document
+	template <typename T> static bool ReadValue(const XMLFlatNode& parent, const XMLName& child_name, T& value);
+						  static uint32_t ReadValueEnum(const XMLFlatNode& parent, const XMLName& child_name, const char** sarray, uint32_t default_index);
+
+	static bool ReadData(const XMLFlatNode& node, cdstring& value);
+	static bool ReadData(const XMLFlatNode& node, uint32_t& value, bool use_stdattribute = true);
+	static bool ReadData(const XMLFlatNode& node, int32_t& value, bool use_stdattribute = true);
+	static bool ReadData(const XMLFlatNode& node, uint64_t& value, bool use_stdattribute = true);
+	static bool ReadData(const XMLFlatNode& node, int64_t& value, bool use_stdattribute = true);
+	static bool ReadData(const XMLFlatNode& node, double& value, bool use_stdattribute = true);
+	static bool ReadData(const XMLFlatNode& node, bool& value, bool use_stdattribute = true);
+	static uint32_t ReadDataEnum(const XMLFlatNode& node, const char** sarray, uint32_t default_index, bool use_stdattribute = true);
+
+	static bool ReadAttribute(const XMLFlatNode& node, const cdstring& name, cdstring& value);
+	static bool ReadAttribute(const XMLFlatNode& node, const cdstring& name, uint32_t& value);
+	static bool ReadAttribute(const XMLFlatNode& node, const cdstring& name, int32_t& value);
+	static bool ReadAttribute(const XMLFlatNode& node, const cdstring& name, uint64_t& value);
+	static bool ReadAttribute(const XMLFlatNode& node, const cdstring& name, int64_t& value);
+	static bool ReadAttribute(const XMLFlatNode& node, const cdstring& name, double& value);
+	static bool ReadAttribute(const XMLFlatNode& node, const cdstring& name, bool& value);
+	static uint32_t ReadAttributeEnum(const XMLFlatNode& node, const cdstring& name, const char** sarray, uint32_t default_index);
 	
 	// Write
 	static void WriteData(XMLNode* node, const cdstring& value);
 	static void WriteData(XMLNode* node, uint32_t value, bool use_stdattribute = true);
 	static void WriteData(XMLNode* node, int32_t value, bool use_stdattribute = true);
+	static void WriteData(XMLNode* node, uint64_t value, bool use_stdattribute = true);
+	static void WriteData(XMLNode* node, int64_t value, bool use_stdattribute = true);
+	static void WriteData(XMLNode* node, double value, bool use_stdattribute = true);
 	static void WriteData(XMLNode* node, bool value, bool use_stdattribute = true);
 	static void WriteDataEnum(XMLNode* node, uint32_t index, const char** sarray, bool use_stdattribute = true);
 
 	static void WriteAttribute(XMLNode* node, const cdstring& name, const cdstring& value);
 	static void WriteAttribute(XMLNode* node, const cdstring& name, uint32_t value);
 	static void WriteAttribute(XMLNode* node, const cdstring& name, int32_t value);
+	static void WriteAttribute(XMLNode* node, const cdstring& name, uint64_t value);
+	static void WriteAttribute(XMLNode* node, const cdstring& name, int64_t value);
+	static void WriteAttribute(XMLNode* node, const cdstring& name, double value);
 	static void WriteAttribute(XMLNode* node, const cdstring& name, bool value);
 	static void WriteAttributeEnum(XMLNode* node, const cdstring& name, uint32_t index, const char** sarray);
 
@@ -104,6 +139,16 @@ template <typename T> bool XMLObject::ReadValue(const XMLNode* parent, const XML
 		return false;
 }
 
+template <typename T> bool XMLObject::ReadValue(const XMLFlatNode& parent, const XMLName& child_name, T& value)
+{
+	// Get single child node
+	XMLFlatNode child = parent.GetChild(child_name);
+	if (child.IsValid())
+		return ReadData(child, value);
+	else
+		return false;
+}
+
 template <typename T> void XMLObject::WriteValue(XMLDocument* doc, XMLNode* parent, const XMLName& child_name, const T& value)
 {
 	XMLNode* child = new XMLNode(doc, parent, child_name);
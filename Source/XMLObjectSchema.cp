@@ -0,0 +1,122 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Source for XMLObjectSchema class
+
+#include "XMLObjectSchema.h"
+
+#include "XMLHash.h"
+
+#include <cstring>
+
+using namespace xmllib;
+
+const uint32_t XMLObjectSchemaBase::cMaxDispatch;
+const uint32_t XMLObjectSchemaBase::cNoBit;
+
+XMLObjectSchemaBase::XMLObjectSchemaBase()
+{
+	mMask = 0;
+	mDispatched = 0;
+	mSlow = false;
+}
+
+void XMLObjectSchemaBase::AddField(EType type, bool element, const XMLName& name, const char** enums, uint32_t default_index)
+{
+	SField field;
+	field.mType = type;
+	field.mElement = element;
+	field.mName = name;
+	if (!element && (name.Name() != NULL))
+		field.mAttribute = name.Name();
+	field.mEnums = enums;
+	field.mDefault = default_index;
+	field.mHash = 0;
+	field.mBit = cNoBit;
+
+	if (element)
+	{
+		// Hashed the same way as the name table hashes the ids' names
+		const char* namespc = (name.Namespace() != NULL) ? name.Namespace() : "";
+		const char* local = (name.Name() != NULL) ? name.Name() : "";
+		field.mHash = Combine(XMLHash(namespc, ::strlen(namespc)), XMLHash(local, ::strlen(local)));
+		if (mDispatched < cMaxDispatch)
+			field.mBit = mDispatched++;
+		else
+			mSlow = true;
+	}
+
+	mFields.push_back(field);
+	if (field.mBit != cNoBit)
+		AddSlot(mFields.size() - 1);
+}
+
+// Keep the table at most half full, rebuilding it when it grows
+void XMLObjectSchemaBase::AddSlot(uint32_t index)
+{
+	if (mDispatched * 2 > mSlots.size())
+	{
+		mSlots.assign(mSlots.empty() ? 8 : mSlots.size() * 2, -1);
+		mMask = mSlots.size() - 1;
+		for(uint32_t i = 0; i < mFields.size(); i++)
+		{
+			if (mFields[i].mBit == cNoBit)
+				continue;
+			uint32_t slot = mFields[i].mHash & mMask;
+			while(mSlots[slot] != -1)
+				slot = (slot + 1) & mMask;
+			mSlots[slot] = i;
+		}
+		return;
+	}
+
+	uint32_t slot = mFields[index].mHash & mMask;
+	while(mSlots[slot] != -1)
+		slot = (slot + 1) & mMask;
+	mSlots[slot] = index;
+}
+
+// Only a field whose hash matches has its ids compared, its names being looked up in the
+// table the first time
+int32_t XMLObjectSchemaBase::Dispatch(const XMLNameTable& names, uint32_t name, uint32_t namespc, SNameIDs& ids) const
+{
+	if (mDispatched == 0)
+		return -1;
+
+	uint32_t hash = Combine(names.Hash(namespc), names.Hash(name));
+	for(uint32_t slot = hash & mMask; mSlots[slot] != -1; slot = (slot + 1) & mMask)
+	{
+		const SField& field = mFields[mSlots[slot]];
+		if (field.mHash != hash)
+			continue;
+
+		uint64_t bit = 1ULL << field.mBit;
+		if ((ids.mFound & bit) == 0)
+		{
+			const char* field_namespc = (field.mName.Namespace() != NULL) ? field.mName.Namespace() : "";
+			const char* field_local = (field.mName.Name() != NULL) ? field.mName.Name() : "";
+			if (!names.Find(field_local, ids.mName[field.mBit]))
+				ids.mName[field.mBit] = XMLNameTable::cNoName;
+			if (!names.Find(field_namespc, ids.mNamespace[field.mBit]))
+				ids.mNamespace[field.mBit] = XMLNameTable::cNoName;
+			ids.mFound |= bit;
+		}
+		if ((name == ids.mName[field.mBit]) && (namespc == ids.mNamespace[field.mBit]))
+			return mSlots[slot];
+	}
+
+	return -1;
+}
@@ -0,0 +1,441 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Header for XMLObjectSchema class
+
+#ifndef __XMLOBJECTSCHEMA__XMLLIB__
+#define __XMLOBJECTSCHEMA__XMLLIB__
+
+#include "XMLObject.h"
+
+#include "XMLDocument.h"
+#include "XMLNameTable.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace xmllib
+{
+
+// Fields of an object declared once for both reading and writing, rather than by hand in
+// ReadXML and WriteXML. Values are stored exactly as XMLObject's ReadValue/WriteValue and
+// ReadAttribute/WriteAttribute store them, so a class can move to a schema without its XML
+// changing. The usual way is a static schema built on first use by the class itself, so it
+// can name its private members:
+//
+//	const XMLObjectSchema<CFoo>& CFoo::Schema()
+//	{
+//		static XMLObjectSchema<CFoo> schema = XMLObjectSchema<CFoo>()
+//			.Attribute("id", &CFoo::mID)
+//			.Element(XMLName("name"), &CFoo::mName)
+//			.ElementEnum(XMLName("kind"), &CFoo::mKind, cKindNames, 0);
+//		return schema;
+//	}
+//
+//	void CFoo::ReadXML(const XMLNode* node)
+//		{ Schema().Read(node, *this); }
+//
+// Reading walks the children once, each going straight to its field through a hash table of
+// the fields' names built when they are declared. The hashes are those the document's name
+// table already keeps, and a field's names are only looked up in the table the first time a
+// child's hash matches it, after which children are matched on their ids. Attribute names
+// are kept as strings, so nothing is allocated per element or attribute. As with ReadValue
+// only the first child with a name is read. A schema is never changed by reading or writing,
+// so can be shared by any number of threads.
+
+class XMLObjectSchemaBase
+{
+protected:
+	enum EType
+	{
+		eString,
+		eUnsigned,
+		eSigned,
+		eBool,
+		eEnum
+	};
+
+	struct SField
+	{
+		EType			mType;
+		bool			mElement;
+		XMLName			mName;				// Element name, or attribute name with no namespace
+		cdstring		mAttribute;			// Attribute name as the attribute calls take it
+		const char**	mEnums;
+		uint32_t		mDefault;			// Enum index when the value is missing
+		uint32_t		mHash;				// Of the element's namespace and local name
+		uint32_t		mBit;				// In the set of elements seen while reading
+	};
+
+	static const uint32_t cMaxDispatch = 64;	// Elements in the hash table - the rest use GetChild
+	static const uint32_t cNoBit = 0xFFFFFFFF;
+
+	// Ids of the element fields' names in the table of the document being read, looked up
+	// when first needed
+	struct SNameIDs
+	{
+		uint64_t	mFound;					// Bits of the fields looked up so far
+		uint32_t	mName[cMaxDispatch];
+		uint32_t	mNamespace[cMaxDispatch];
+	};
+
+	std::vector<SField>		mFields;
+	std::vector<int32_t>	mSlots;				// Open addressing table of element fields, -1 when empty
+	uint32_t				mMask;
+	uint32_t				mDispatched;		// Element fields in the table
+	bool					mSlow;				// Some element fields are not in the table
+
+	XMLObjectSchemaBase();
+
+	void AddField(EType type, bool element, const XMLName& name, const char** enums = NULL, uint32_t default_index = 0);
+
+	// Field of a child element, or -1
+	int32_t Dispatch(const XMLNameTable& names, uint32_t name, uint32_t namespc, SNameIDs& ids) const;
+
+private:
+	void AddSlot(uint32_t index);
+
+	// Hash of a namespace and local name from their own hashes
+	static uint32_t Combine(uint32_t namespc, uint32_t name)
+	{
+		uint32_t hash = name * 0x9E3779B1U;
+		return hash ^ (namespc + 0x7F4A7C15U + (hash << 6) + (hash >> 2));
+	}
+};
+
+template <class T> class XMLObjectSchema : public XMLObjectSchemaBase
+{
+public:
+	XMLObjectSchema() {}
+
+	// Declaring fields - each returns the schema so they can be chained
+	XMLObjectSchema& Element(const XMLName& name, cdstring T::* field);
+	XMLObjectSchema& Element(const XMLName& name, uint32_t T::* field);
+	XMLObjectSchema& Element(const XMLName& name, int32_t T::* field);
+	XMLObjectSchema& Element(const XMLName& name, bool T::* field);
+	XMLObjectSchema& ElementEnum(const XMLName& name, uint32_t T::* field, const char** sarray, uint32_t default_index);
+
+	XMLObjectSchema& Attribute(const char* name, cdstring T::* field);
+	XMLObjectSchema& Attribute(const char* name, uint32_t T::* field);
+	XMLObjectSchema& Attribute(const char* name, int32_t T::* field);
+	XMLObjectSchema& Attribute(const char* name, bool T::* field);
+	XMLObjectSchema& AttributeEnum(const char* name, uint32_t T::* field, const char** sarray, uint32_t default_index);
+
+	// Fields with nothing to read are left alone, except enums which get their default
+	void Read(const XMLNode* node, T& object) const;
+	void Read(const XMLFlatNode& node, T& object) const;
+
+	void Write(XMLDocument* doc, XMLNode* node, const T& object) const;
+
+private:
+	// Member of each field - only the one for its type is set
+	struct SMember
+	{
+		cdstring T::*	mString;
+		uint32_t T::*	mUnsigned;
+		int32_t T::*	mSigned;
+		bool T::*		mBool;
+	};
+
+	std::vector<SMember>	mMembers;
+
+	XMLObjectSchema& Add(EType type, bool element, const XMLName& name, const SMember& member, const char** enums = NULL, uint32_t default_index = 0);
+	static SMember Member()
+	{
+		SMember member = { NULL, NULL, NULL, NULL };
+		return member;
+	}
+
+	template <class N> void ReadElement(N node, uint32_t index, T& object) const;
+	template <class N> void ReadAttribute(N node, uint32_t index, T& object) const;
+	void ReadDefaults(uint64_t seen, T& object) const;
+	void ReadDefault(uint32_t index, T& object) const;
+};
+
+template <class T> XMLObjectSchema<T>& XMLObjectSchema<T>::Element(const XMLName& name, cdstring T::* field)
+{
+	SMember member = Member();
+	member.mString = field;
+	return Add(eString, true, name, member);
+}
+
+template <class T> XMLObjectSchema<T>& XMLObjectSchema<T>::Element(const XMLName& name, uint32_t T::* field)
+{
+	SMember member = Member();
+	member.mUnsigned = field;
+	return Add(eUnsigned, true, name, member);
+}
+
+template <class T> XMLObjectSchema<T>& XMLObjectSchema<T>::Element(const XMLName& name, int32_t T::* field)
+{
+	SMember member = Member();
+	member.mSigned = field;
+	return Add(eSigned, true, name, member);
+}
+
+template <class T> XMLObjectSchema<T>& XMLObjectSchema<T>::Element(const XMLName& name, bool T::* field)
+{
+	SMember member = Member();
+	member.mBool = field;
+	return Add(eBool, true, name, member);
+}
+
+template <class T> XMLObjectSchema<T>& XMLObjectSchema<T>::ElementEnum(const XMLName& name, uint32_t T::* field, const char** sarray, uint32_t default_index)
+{
+	SMember member = Member();
+	member.mUnsigned = field;
+	return Add(eEnum, true, name, member, sarray, default_index);
+}
+
+template <class T> XMLObjectSchema<T>& XMLObjectSchema<T>::Attribute(const char* name, cdstring T::* field)
+{
+	SMember member = Member();
+	member.mString = field;
+	return Add(eString, false, XMLName(name), member);
+}
+
+template <class T> XMLObjectSchema<T>& XMLObjectSchema<T>::Attribute(const char* name, uint32_t T::* field)
+{
+	SMember member = Member();
+	member.mUnsigned = field;
+	return Add(eUnsigned, false, XMLName(name), member);
+}
+
+template <class T> XMLObjectSchema<T>& XMLObjectSchema<T>::Attribute(const char* name, int32_t T::* field)
+{
+	SMember member = Member();
+	member.mSigned = field;
+	return Add(eSigned, false, XMLName(name), member);
+}
+
+template <class T> XMLObjectSchema<T>& XMLObjectSchema<T>::Attribute(const char* name, bool T::* field)
+{
+	SMember member = Member();
+	member.mBool = field;
+	return Add(eBool, false, XMLName(name), member);
+}
+
+template <class T> XMLObjectSchema<T>& XMLObjectSchema<T>::AttributeEnum(const char* name, uint32_t T::* field, const char** sarray, uint32_t default_index)
+{
+	SMember member = Member();
+	member.mUnsigned = field;
+	return Add(eEnum, false, XMLName(name), member, sarray, default_index);
+}
+
+template <class T> XMLObjectSchema<T>& XMLObjectSchema<T>::Add(EType type, bool element, const XMLName& name, const SMember& member, const char** enums, uint32_t default_index)
+{
+	AddField(type, element, name, enums, default_index);
+	mMembers.push_back(member);
+	return *this;
+}
+
+template <class T> void XMLObjectSchema<T>::Read(const XMLNode* node, T& object) const
+{
+	for(uint32_t i = 0; i < mFields.size(); i++)
+	{
+		if (!mFields[i].mElement)
+			ReadAttribute(node, i, object);
+	}
+	if ((mDispatched == 0) && !mSlow)
+		return;
+
+	// One pass over the children
+	const XMLNameTable& names = node->Document()->Names();
+	uint64_t seen = 0;
+	SNameIDs ids;
+	ids.mFound = 0;
+	for(XMLNodeList::const_iterator iter = node->Children().begin(); iter != node->Children().end(); iter++)
+	{
+		int32_t index = Dispatch(names, (*iter)->NameID(), (*iter)->NamespaceNameID(), ids);
+		if ((index < 0) || ((seen & (1ULL << mFields[index].mBit)) != 0))
+			continue;
+		seen |= 1ULL << mFields[index].mBit;
+		ReadElement<const XMLNode*>(*iter, index, object);
+	}
+
+	// Elements not in the hash table are looked for one at a time
+	for(uint32_t i = 0; mSlow && (i < mFields.size()); i++)
+	{
+		if (!mFields[i].mElement || (mFields[i].mBit != cNoBit))
+			continue;
+		const XMLNode* child = node->GetChild(mFields[i].mName);
+		if (child != NULL)
+			ReadElement<const XMLNode*>(child, i, object);
+		else
+			ReadDefault(i, object);
+	}
+	ReadDefaults(seen, object);
+}
+
+template <class T> void XMLObjectSchema<T>::Read(const XMLFlatNode& node, T& object) const
+{
+	for(uint32_t i = 0; i < mFields.size(); i++)
+	{
+		if (!mFields[i].mElement)
+			ReadAttribute<const XMLFlatNode&>(node, i, object);
+	}
+	if ((mDispatched == 0) && !mSlow)
+		return;
+
+	// One pass over the children
+	const XMLNameTable& names = node.Document()->Names();
+	uint64_t seen = 0;
+	SNameIDs ids;
+	ids.mFound = 0;
+	for(XMLFlatNode child = node.FirstChild(); child.IsValid(); child = child.NextSibling())
+	{
+		int32_t index = Dispatch(names, child.NameID(), child.NamespaceNameID(), ids);
+		if ((index < 0) || ((seen & (1ULL << mFields[index].mBit)) != 0))
+			continue;
+		seen |= 1ULL << mFields[index].mBit;
+		ReadElement<const XMLFlatNode&>(child, index, object);
+	}
+
+	// Elements not in the hash table are looked for one at a time
+	for(uint32_t i = 0; mSlow && (i < mFields.size()); i++)
+	{
+		if (!mFields[i].mElement || (mFields[i].mBit != cNoBit))
+			continue;
+		XMLFlatNode child = node.GetChild(mFields[i].mName);
+		if (child.IsValid())
+			ReadElement<const XMLFlatNode&>(child, i, object);
+		else
+			ReadDefault(i, object);
+	}
+	ReadDefaults(seen, object);
+}
+
+template <class T> template <class N> void XMLObjectSchema<T>::ReadElement(N node, uint32_t index, T& object) const
+{
+	const SField& field = mFields[index];
+	const SMember& member = mMembers[index];
+	switch(field.mType)
+	{
+	case eString:
+		XMLObject::ReadData(node, object.*member.mString);
+		break;
+	case eUnsigned:
+		XMLObject::ReadData(node, object.*member.mUnsigned);
+		break;
+	case eSigned:
+		XMLObject::ReadData(node, object.*member.mSigned);
+		break;
+	case eBool:
+		XMLObject::ReadData(node, object.*member.mBool);
+		break;
+	case eEnum:
+		object.*member.mUnsigned = XMLObject::ReadDataEnum(node, field.mEnums, field.mDefault);
+		break;
+	}
+}
+
+template <class T> template <class N> void XMLObjectSchema<T>::ReadAttribute(N node, uint32_t index, T& object) const
+{
+	const SField& field = mFields[index];
+	const SMember& member = mMembers[index];
+	const cdstring& name = field.mAttribute;
+	switch(field.mType)
+	{
+	case eString:
+		XMLObject::ReadAttribute(node, name, object.*member.mString);
+		break;
+	case eUnsigned:
+		XMLObject::ReadAttribute(node, name, object.*member.mUnsigned);
+		break;
+	case eSigned:
+		XMLObject::ReadAttribute(node, name, object.*member.mSigned);
+		break;
+	case eBool:
+		XMLObject::ReadAttribute(node, name, object.*member.mBool);
+		break;
+	case eEnum:
+		object.*member.mUnsigned = XMLObject::ReadAttributeEnum(node, name, field.mEnums, field.mDefault);
+		break;
+	}
+}
+
+// Enums with no element get their default as ReadValueEnum would give them
+template <class T> void XMLObjectSchema<T>::ReadDefaults(uint64_t seen, T& object) const
+{
+	for(uint32_t i = 0; i < mFields.size(); i++)
+	{
+		const SField& field = mFields[i];
+		if (field.mElement && (field.mBit != cNoBit) && ((seen & (1ULL << field.mBit)) == 0))
+			ReadDefault(i, object);
+	}
+}
+
+template <class T> void XMLObjectSchema<T>::ReadDefault(uint32_t index, T& object) const
+{
+	if (mFields[index].mType == eEnum)
+		object.*mMembers[index].mUnsigned = mFields[index].mDefault;
+}
+
+template <class T> void XMLObjectSchema<T>::Write(XMLDocument* doc, XMLNode* node, const T& object) const
+{
+	for(uint32_t i = 0; i < mFields.size(); i++)
+	{
+		const SField& field = mFields[i];
+		const SMember& member = mMembers[i];
+		if (field.mElement)
+		{
+			XMLNode* child = new XMLNode(doc, node, field.mName);
+			switch(field.mType)
+			{
+			case eString:
+				XMLObject::WriteData(child, object.*member.mString);
+				break;
+			case eUnsigned:
+				XMLObject::WriteData(child, object.*member.mUnsigned);
+				break;
+			case eSigned:
+				XMLObject::WriteData(child, object.*member.mSigned);
+				break;
+			case eBool:
+				XMLObject::WriteData(child, object.*member.mBool);
+				break;
+			case eEnum:
+				XMLObject::WriteDataEnum(child, object.*member.mUnsigned, field.mEnums);
+				break;
+			}
+		}
+		else
+		{
+			const cdstring& name = field.mAttribute;
+			switch(field.mType)
+			{
+			case eString:
+				XMLObject::WriteAttribute(node, name, object.*member.mString);
+				break;
+			case eUnsigned:
+				XMLObject::WriteAttribute(node, name, object.*member.mUnsigned);
+				break;
+			case eSigned:
+				XMLObject::WriteAttribute(node, name, object.*member.mSigned);
+				break;
+			case eBool:
+				XMLObject::WriteAttribute(node, name, object.*member.mBool);
+				break;
+			case eEnum:
+				XMLObject::WriteAttributeEnum(node, name, object.*member.mUnsigned, field.mEnums);
+				break;
+			}
+		}
+	}
+}
+
+}
+#endif
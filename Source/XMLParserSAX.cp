@@ -19,18 +19,39 @@
 #include "XMLParserSAX.h"
 
 #include "XMLDocument.h"
+#include "XMLProjection.h"
 
 using namespace xmllib;
 
 XMLParserSAX::XMLParserSAX()
 {
 	mDocument = NULL;
+	mSpare = NULL;
 	mError = false;
+	mProjection = NULL;
+	mSkipDepth = 0;
+	mKeepDepth = 0;
 }
 
 XMLParserSAX::~XMLParserSAX()
 {
 	delete mDocument;
+	delete mSpare;
+}
+
+void XMLParserSAX::Reset()
+{
+	RecycleDocument();
+	mNodeList.clear();
+	mError = false;
+	mScratch.Reset();
+	mNamespaceScope.Reset();
+	mStats.Clear();
+
+	mSkipDepth = 0;
+	mKeepDepth = 0;
+	mLive.clear();
+	mLiveStart.clear();
 }
 
 void XMLParserSAX::HandleException(const std::exception& ex)
@@ -40,8 +61,18 @@ void XMLParserSAX::HandleException(const std::exception& ex)
 
 void XMLParserSAX::StartDocument()
 {
-	// Create the document with its root element
-	mDocument = new XMLDocument;
+	// Create the document with its root element, reusing the last one if it was not released
+	RecycleDocument();
+	if (mSpare != NULL)
+	{
+		mDocument = mSpare;
+		mSpare = NULL;
+	}
+	else
+		mDocument = new XMLDocument;
+	mNamespaceScope.Reset();
+	mSkipDepth = 0;
+	mKeepDepth = 0;
 }
 
 void XMLParserSAX::EndDocument()
@@ -50,10 +81,48 @@ void XMLParserSAX::EndDocument()
 }
 
 void XMLParserSAX::StartElement(const cdstring& name, const XMLAttributeList& attributes)
+{
+	BuildElement(XMLStringView(name), attributes);
+}
+
+void XMLParserSAX::EndElement(const cdstring& name)
+{
+	CloseElement();
+}
+
+void XMLParserSAX::Characters(const cdstring& data)
+{
+	AppendText(XMLStringView(data));
+}
+
+// Views are used as they are - names are interned and each attribute value copied once
+void XMLParserSAX::StartElementView(const XMLStringView& name, const XMLAttributeViewList& attributes)
+{
+	BuildElement(name, attributes);
+}
+
+void XMLParserSAX::EndElementView(const XMLStringView& name)
+{
+	CloseElement();
+}
+
+void XMLParserSAX::CharactersView(const XMLStringView& data)
+{
+	AppendText(data);
+}
+
+template <class T> void XMLParserSAX::BuildElement(const XMLStringView& name, const T& attributes)
 {
 	// Don't bother if on error state
 	if (mError)
 		return;
+
+	// Nothing inside a dropped element is built
+	if (mSkipDepth != 0)
+	{
+		mSkipDepth++;
+		return;
+	}
 	
 	// We always need a document
 	if (mDocument == NULL)
@@ -61,6 +130,26 @@ void XMLParserSAX::StartElement(const cdstring& name, const XMLAttributeList& at
 
 	try
 	{
+		// Drop the element before building anything if its name cannot match
+		bool projecting = (mProjection != NULL) && (mKeepDepth == 0);
+		bool need_node = false;
+		if (projecting)
+		{
+			if (mNodeList.size() == 0)
+				StartProjection();
+
+			uint32_t start = mLiveStart.back();
+			const uint32_t* live = mLive.empty() ? NULL : &mLive[0] + start;
+			mProjection->MatchName(live, mLive.size() - start, mLiveStart.size() - 1, name, mMatched, need_node);
+
+			// The root element is always built so the document still says what it is
+			if (mMatched.empty() && (mNodeList.size() != 0))
+			{
+				mSkipDepth = 1;
+				return;
+			}
+		}
+
 		// See if this is the first one
 		XMLNode* node;
 		if (mNodeList.size() == 0)
@@ -70,10 +159,40 @@ void XMLParserSAX::StartElement(const cdstring& name, const XMLAttributeList& at
 			node->SetName(name);
 		}
 		else
-			// Create a new node
-			node = new XMLNode(mDocument, mNodeList.back(), name);
+			// Create a new node in the document's arena
+			node = mDocument->CreateNode(mNodeList.back(), name);
 		node->SetAttributes(attributes);
-		node->DetermineNamespace();
+		mNamespaceScope.Push();
+		node->DetermineNamespace(&mNamespaceScope);
+
+		if (projecting)
+		{
+			// Namespaces can only be compared once the node has resolved its own
+			uint32_t level = mLiveStart.size() - 1;
+			if (mMatched.empty() || (need_node && !mProjection->MatchNode(mMatched, level, *node)))
+			{
+				mNamespaceScope.Pop();
+				if (mNodeList.size() != 0)
+				{
+					mNodeList.back()->RemoveChild(node);
+					XMLNode_Delete(node);
+				}
+				mSkipDepth = 1;
+				return;
+			}
+
+			// Everything inside a complete match is kept, otherwise the element is only on the
+			// way to one and its children are matched against the remaining paths
+			if (mProjection->Complete(&mMatched[0], mMatched.size(), level))
+				mKeepDepth = 1;
+			else
+			{
+				mLiveStart.push_back(mLive.size());
+				mLive.insert(mLive.end(), mMatched.begin(), mMatched.end());
+			}
+		}
+		else if (mKeepDepth != 0)
+			mKeepDepth++;
 		
 		// Push onto stack
 		mNodeList.push_back(node);
@@ -84,16 +203,32 @@ void XMLParserSAX::StartElement(const cdstring& name, const XMLAttributeList& at
 	}
 }
 
-void XMLParserSAX::EndElement(const cdstring& name)
+void XMLParserSAX::CloseElement()
 {
 	// Don't bother if on error state
 	if (mError)
 		return;
 
+	if (mSkipDepth != 0)
+	{
+		mSkipDepth--;
+		return;
+	}
+
 	try
 	{
+		// Leaving a complete match or an element on the way to one
+		if (mKeepDepth != 0)
+			mKeepDepth--;
+		else if ((mProjection != NULL) && (mLiveStart.size() > 1))
+		{
+			mLive.resize(mLiveStart.back());
+			mLiveStart.pop_back();
+		}
+
 		// Pop current item off the stack
 		mNodeList.pop_back();
+		mNamespaceScope.Pop();
 	}
 	catch(const std::exception& e)
 	{
@@ -101,10 +236,10 @@ void XMLParserSAX::EndElement(const cdstring& name)
 	}
 }
 
-void XMLParserSAX::Characters(const cdstring& data)
+void XMLParserSAX::AppendText(const XMLStringView& data)
 {
-	// Don't bother if on error state
-	if (mError)
+	// Don't bother if on error state or the text is not wanted
+	if (mError || DropText())
 		return;
 
 	try
@@ -119,6 +254,33 @@ void XMLParserSAX::Characters(const cdstring& data)
 	}
 }
 
+// All paths are live below the root
+void XMLParserSAX::StartProjection()
+{
+	mLive.clear();
+	for(uint32_t i = 0; i < mProjection->Count(); i++)
+		mLive.push_back(i);
+	mLiveStart.assign(1, 0);
+	mSkipDepth = 0;
+	mKeepDepth = 0;
+}
+
+// Only one document is kept for reuse
+void XMLParserSAX::RecycleDocument()
+{
+	if (mDocument == NULL)
+		return;
+
+	if (mSpare == NULL)
+	{
+		mDocument->Clear();
+		mSpare = mDocument;
+	}
+	else
+		delete mDocument;
+	mDocument = NULL;
+}
+
 void XMLParserSAX::Comment(const cdstring& text)
 {
 	// Nothing to do
@@ -20,13 +20,20 @@
 #define __XMLPARSERSAX__XMLLIB__
 
 #include "XMLParser.h"
+#include "XMLArena.h"
 #include "XMLAttribute.h"
+#include "XMLNamespace.h"
 #include "XMLNode.h"
+#include "XMLStats.h"
+#include "XMLStringView.h"
+
+#include <vector>
 
 namespace xmllib
 {
 
 class XMLDocument;
+class XMLProjection;
 
 class XMLParserSAX : public XMLParser
 {
@@ -47,16 +54,60 @@ public:
 		return temp;
 	}
 
+	bool Failed() const
+	{
+		return mError;
+	}
+
+	// Ready to parse another document - a document that has not been released is cleared and
+	// kept to build the next one in. Working storage is kept so parsing many documents with one
+	// parser does not allocate it each time. The projection is kept.
+	virtual void Reset();
+
+	// Only build the parts of the document on the projection's paths - NULL builds all of it.
+	// The projection is not copied so must outlive any parsing done with it.
+	void SetProjection(const XMLProjection* projection)
+	{
+		mProjection = projection;
+	}
+
+	// What parsing has done since the parser was made or last Reset - only counted when the
+	// library is built with XMLLIB_STATS
+	const XMLStats& Stats() const
+	{
+		return mStats;
+	}
+
 protected:
 	XMLDocument*	mDocument;
+	XMLDocument*	mSpare;				// Cleared document to reuse for the next one
 	XMLNodeList		mNodeList;
 	bool			mError;
+	XMLArena		mScratch;			// Per-element parser storage, reset by the parser for each tag
+	XMLNamespaceScope	mNamespaceScope;	// Prefixes declared by the open elements
+	XMLStats		mStats;				// Current for the thread while parsing
+
+	// Projection state
+	const XMLProjection*	mProjection;
+	uint32_t				mSkipDepth;			// Open elements being dropped
+	uint32_t				mKeepDepth;			// Open elements inside a complete match
+	std::vector<uint32_t>	mLive;				// Paths still matching, stacked by level
+	std::vector<uint32_t>	mLiveStart;			// Start of each level's paths in mLive
+	std::vector<uint32_t>	mMatched;			// Paths matching the current element
 
 	virtual void StartDocument();
 	virtual void EndDocument();
 	virtual void StartElement(const cdstring& name, const XMLAttributeList& attributes);
 	virtual void EndElement(const cdstring& name);
 	virtual void Characters(const cdstring& data);
+
+	// View based callbacks used by parsers that can hand out references into their input.
+	// The views are only valid until the call returns. The defaults convert to strings and
+	// call the regular callbacks above.
+	virtual void StartElementView(const XMLStringView& name, const XMLAttributeViewList& attributes);
+	virtual void EndElementView(const XMLStringView& name);
+	virtual void CharactersView(const XMLStringView& data);
+
 	virtual void Comment(const cdstring& text);
 	virtual void Warning(const cdstring& text);
 	virtual void Error(const cdstring& text);
@@ -64,6 +115,18 @@ protected:
 
 	virtual void HandleException(const std::exception& ex);
 
+	// Shared by the string and view callbacks
+	template <class T> void BuildElement(const XMLStringView& name, const T& attributes);
+	void CloseElement();
+	void AppendText(const XMLStringView& data);
+
+	void StartProjection();
+	void RecycleDocument();
+	bool DropText() const
+	{
+		return (mSkipDepth != 0) || ((mProjection != NULL) && (mKeepDepth == 0));
+	}
+
 private:
 	// SAX callbacks - these will actually appear in the OS-specific derived class
 };
@@ -0,0 +1,120 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Source for XMLProjection class
+
+#include "XMLProjection.h"
+
+#include "XMLNode.h"
+
+#include <cstring>
+
+using namespace xmllib;
+
+void XMLProjection::AddPath(const XMLNameList& path)
+{
+	if (path.empty())
+		return;
+
+	SPath steps;
+	for(XMLNameList::const_iterator iter = path.begin(); iter != path.end(); iter++)
+	{
+		SStep step;
+		step.mName = ((*iter).Name() != NULL) ? (*iter).Name() : "";
+		step.mNamespace = ((*iter).Namespace() != NULL) ? (*iter).Namespace() : "";
+		step.mAny = false;
+		step.mResolved = true;
+		steps.push_back(step);
+	}
+	mPaths.push_back(steps);
+}
+
+void XMLProjection::AddPath(const char* pattern)
+{
+	SPath steps;
+	const char* p = pattern;
+	while(*p != 0)
+	{
+		// Empty steps from leading or doubled slashes are ignored
+		const char* slash = ::strchr(p, '/');
+		size_t length = (slash != NULL) ? (size_t)(slash - p) : ::strlen(p);
+		if (length != 0)
+		{
+			SStep step;
+			step.mName.assign(p, length);
+			step.mAny = (step.mName == "*");
+			step.mResolved = false;
+			steps.push_back(step);
+		}
+		p += length;
+		if (*p == '/')
+			p++;
+	}
+
+	if (!steps.empty())
+		mPaths.push_back(steps);
+}
+
+void XMLProjection::MatchName(const uint32_t* live, uint32_t count, uint32_t level, const XMLStringView& qname,
+								std::vector<uint32_t>& matched, bool& need_node) const
+{
+	// Local part for comparing with resolved names
+	const char* colon = static_cast<const char*>(::memchr(qname.Data(), ':', qname.Length()));
+	XMLStringView local = (colon != NULL) ? XMLStringView(colon + 1, qname.Length() - (colon + 1 - qname.Data())) : qname;
+
+	matched.clear();
+	need_node = false;
+	for(uint32_t i = 0; i < count; i++)
+	{
+		const SPath& path = mPaths[live[i]];
+		if (level >= path.size())
+			continue;
+
+		const SStep& step = path[level];
+		if (step.mAny || (!step.mResolved && qname.Equals(step.mName.c_str(), step.mName.length())))
+			matched.push_back(live[i]);
+		else if (step.mResolved && local.Equals(step.mName.c_str(), step.mName.length()))
+		{
+			matched.push_back(live[i]);
+			need_node = true;
+		}
+	}
+}
+
+bool XMLProjection::MatchNode(std::vector<uint32_t>& matched, uint32_t level, const XMLNode& node) const
+{
+	std::vector<uint32_t>::iterator keep = matched.begin();
+	for(std::vector<uint32_t>::const_iterator iter = matched.begin(); iter != matched.end(); iter++)
+	{
+		const SStep& step = mPaths[*iter][level];
+		if (!step.mResolved || (step.mNamespace == node.Namespace()))
+			*keep++ = *iter;
+	}
+	matched.erase(keep, matched.end());
+
+	return !matched.empty();
+}
+
+bool XMLProjection::Complete(const uint32_t* matched, uint32_t count, uint32_t level) const
+{
+	for(uint32_t i = 0; i < count; i++)
+	{
+		if (mPaths[matched[i]].size() == level + 1)
+			return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,94 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Header for XMLProjection class
+
+#ifndef __XMLPROJECTION__XMLLIB__
+#define __XMLPROJECTION__XMLLIB__
+
+#include "XMLName.h"
+#include "XMLStringView.h"
+
+#include "cdstring.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace xmllib
+{
+
+class XMLNode;
+
+// Set of element paths used to build only part of a document. Paths start at the root
+// element. An element matching the whole of a path is kept with everything inside it, the
+// elements above it are kept with their attributes but without text, and anything else is
+// dropped while parsing. One projection can be shared by any number of parsers.
+
+class XMLProjection
+{
+public:
+	XMLProjection() {}
+	~XMLProjection() {}
+
+	// Each name must match both namespace and local name
+	void AddPath(const XMLNameList& path);
+
+	// Slash separated names as they appear in the document e.g. "/D:multistatus/D:response/*",
+	// where '*' matches any element
+	void AddPath(const char* pattern);
+
+	void Clear()
+	{
+		mPaths.clear();
+	}
+	bool Empty() const
+	{
+		return mPaths.empty();
+	}
+	uint32_t Count() const
+	{
+		return mPaths.size();
+	}
+
+	// Matching is done in two passes - names first and then namespaces once there is a node.
+	// Paths are referred to by index, level is the depth of the element below the root.
+
+	// Paths from live whose step at level matches the element name as written. Sets
+	// need_node if any of them still have to check the namespace.
+	void MatchName(const uint32_t* live, uint32_t count, uint32_t level, const XMLStringView& qname,
+					std::vector<uint32_t>& matched, bool& need_node) const;
+
+	// Remove paths whose namespace does not match the node - true if any remain
+	bool MatchNode(std::vector<uint32_t>& matched, uint32_t level, const XMLNode& node) const;
+
+	// Whether any of the paths end at level
+	bool Complete(const uint32_t* matched, uint32_t count, uint32_t level) const;
+
+private:
+	struct SStep
+	{
+		cdstring	mName;			// Qualified for patterns, local for names
+		cdstring	mNamespace;
+		bool		mAny;			// '*'
+		bool		mResolved;		// Compare namespace and local name
+	};
+	typedef std::vector<SStep> SPath;
+
+	std::vector<SPath>	mPaths;
+};
+
+}
+#endif
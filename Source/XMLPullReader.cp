@@ -0,0 +1,337 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Source for XMLPullReader class
+
+#include "XMLPullReader.h"
+
+using namespace xmllib;
+
+const XMLAttributeViewList cNoAttributes;
+
+XMLPullReader::XMLPullReader()
+{
+	mEvent = eNone;
+	mAttributes = NULL;
+	mDepth = 0;
+	mPopDepth = false;
+	mPendingEnd = false;
+}
+
+XMLPullReader::~XMLPullReader()
+{
+	mBuffer.Close();
+}
+
+void XMLPullReader::Reset()
+{
+	XMLSAXSimple::Reset();
+
+	if (mFile.is_open())
+		mFile.close();
+	mFile.clear();
+
+	ClearEvent();
+}
+
+void XMLPullReader::ParseData(const char* data)
+{
+	mBuffer.SetData(data);
+	Start();
+}
+
+void XMLPullReader::ParseFile(const char* file)
+{
+	// Regular files are read in place from mapped memory
+	if (mBuffer.SetFile(file))
+	{
+		Start();
+		return;
+	}
+
+	// Fall back to reading through a stream for anything that cannot be mapped
+	if (mFile.is_open())
+		mFile.close();
+	mFile.clear();
+	mFile.open(file);
+	if (mFile.fail())
+	{
+		mError = true;
+		mEvent = eError;
+		return;
+	}
+
+	mBuffer.SetStream(mFile);
+	Start();
+}
+
+void XMLPullReader::ParseStream(std::istream& is)
+{
+	if (is.fail())
+	{
+		mError = true;
+		mEvent = eError;
+		return;
+	}
+
+	mBuffer.SetStream(is);
+	Start();
+}
+
+void XMLPullReader::Start()
+{
+	mError = false;
+	ClearEvent();
+
+	// Always skip whitespace before the first real data
+	SkipWS();
+}
+
+void XMLPullReader::ClearEvent()
+{
+	mEvent = eNone;
+	mName = XMLStringView();
+	mText = XMLStringView();
+	mAttributes = NULL;
+	mDepth = 0;
+	mPopDepth = false;
+	mPendingEnd = false;
+}
+
+XMLPullReader::EEvent XMLPullReader::Next()
+{
+	// Nothing more once finished
+	if ((mEvent == eEndDocument) || (mEvent == eError))
+		return mEvent;
+
+	// The element just ended is no longer open
+	if (mPopDepth)
+	{
+		mDepth--;
+		mPopDepth = false;
+	}
+	mAttributes = NULL;
+
+	// An empty element ends straight after it starts
+	if (mPendingEnd)
+	{
+		mPendingEnd = false;
+		mPopDepth = true;
+		mEvent = eEndElement;
+		return mEvent;
+	}
+
+	// Tokens without anything to report (whitespace, comments etc) are passed over
+	mEvent = eNone;
+	while((mEvent == eNone) && !mError)
+	{
+		if (mBuffer.fail() || !ParseToken())
+		{
+			if (!mError && (mDepth != 0))
+				FatalError("Unexpected end of document");
+			mEvent = eEndDocument;
+		}
+	}
+	if (mError)
+		mEvent = eError;
+
+	return mEvent;
+}
+
+const XMLAttributeViewList& XMLPullReader::Attributes() const
+{
+	return (mAttributes != NULL) ? *mAttributes : cNoAttributes;
+}
+
+bool XMLPullReader::Attribute(const char* name, XMLStringView& value) const
+{
+	const XMLAttributeViewList& attributes = Attributes();
+	for(XMLAttributeViewList::const_iterator iter = attributes.begin(); iter != attributes.end(); iter++)
+	{
+		if ((*iter).mName.Equals(name))
+		{
+			value = (*iter).mValue;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool XMLPullReader::SkipSubtree()
+{
+	if (mEvent != eStartElement)
+		return false;
+	mAttributes = NULL;
+
+	// An empty element has nothing inside it
+	if (mPendingEnd)
+	{
+		mPendingEnd = false;
+		mPopDepth = true;
+		mEvent = eEndElement;
+		return true;
+	}
+
+	// Only tags change the depth - text in between is never looked at
+	uint32_t depth = 1;
+	while(depth != 0)
+	{
+		if (!mBuffer.SkipTo('<'))
+			break;
+
+		if (mBuffer.StartsWith("</", 2))
+		{
+			if (!SkipPast(">", 1))
+				break;
+			depth--;
+		}
+		else if (mBuffer.StartsWith("<!--", 4))
+		{
+			mBuffer += 4;
+			if (!SkipPast("-->", 3))
+				break;
+		}
+		else if (mBuffer.StartsWith("<![CDATA[", 9))
+		{
+			mBuffer += 9;
+			if (!SkipPast("]]>", 3))
+				break;
+		}
+		else if (mBuffer.StartsWith("<?", 2))
+		{
+			mBuffer += 2;
+			if (!SkipPast("?>", 2))
+				break;
+		}
+		else if (mBuffer.StartsWith("<!", 2))
+		{
+			if (!SkipPast(">", 1))
+				break;
+		}
+		else
+		{
+			mBuffer += 1;
+			bool empty = false;
+			if (!SkipTag(empty))
+				break;
+			if (!empty)
+				depth++;
+		}
+	}
+
+	if (depth != 0)
+	{
+		FatalError("Unexpected end of document");
+		mEvent = eError;
+		return false;
+	}
+
+	// Now at the end of the element - its name is still the one from the start
+	mPopDepth = true;
+	mEvent = eEndElement;
+	return true;
+}
+
+// Move to just after the next occurrence of the sequence
+bool XMLPullReader::SkipPast(const char* end, uint32_t length)
+{
+	while(mBuffer.SkipTo(end[0]))
+	{
+		if (mBuffer.StartsWith(end, length))
+		{
+			mBuffer += length;
+			return true;
+		}
+		mBuffer += 1;
+	}
+
+	return false;
+}
+
+// Move to just after the '>' ending a start tag, ignoring any in attribute values
+bool XMLPullReader::SkipTag(bool& empty)
+{
+	char quote = 0;
+	char last = 0;
+	while(mBuffer.Fill())
+	{
+		uint32_t span = (quote != 0) ? mBuffer.Span(quote) : mBuffer.Span('>', '"', '\'');
+		if (span != 0)
+			last = mBuffer.next()[span - 1];
+		if (span == mBuffer.Remaining())
+		{
+			mBuffer += span;
+			continue;
+		}
+
+		char c = mBuffer.next()[span];
+		mBuffer += span + 1;
+		if (quote != 0)
+		{
+			quote = 0;
+			last = c;
+		}
+		else if (c == '>')
+		{
+			empty = (last == '/');
+			return true;
+		}
+		else
+			quote = c;
+	}
+
+	return false;
+}
+
+void XMLPullReader::StartDocument()
+{
+	// Nothing to build
+}
+
+void XMLPullReader::StartElementView(const XMLStringView& name, const XMLAttributeViewList& attributes)
+{
+	mName = name;
+	mAttributes = &attributes;
+	mDepth++;
+	mEvent = eStartElement;
+}
+
+void XMLPullReader::EndElementView(const XMLStringView& name)
+{
+	// Empty element - report its end on the next call
+	if (mEvent == eStartElement)
+	{
+		mPendingEnd = true;
+		return;
+	}
+
+	if (mDepth == 0)
+	{
+		FatalError("Unexpected element end");
+		return;
+	}
+
+	mName = name;
+	mPopDepth = true;
+	mEvent = eEndElement;
+}
+
+void XMLPullReader::CharactersView(const XMLStringView& data)
+{
+	mText = data;
+	mEvent = eText;
+}
@@ -0,0 +1,108 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Header for XMLPullReader class
+
+#ifndef __XMLPULLREADER__XMLLIB__
+#define __XMLPULLREADER__XMLLIB__
+
+#include "XMLSAXSimple.h"
+
+#include <fstream>
+
+namespace xmllib
+{
+
+// Walks a document forward one event at a time instead of calling back or building a tree.
+// ParseData, ParseFile and ParseStream only select the input - events are then pulled with
+// Next() until it returns eEndDocument or eError. Views returned by the accessors are only
+// valid until the next call to Next() or SkipSubtree().
+
+class XMLPullReader : public XMLSAXSimple
+{
+public:
+	enum EEvent
+	{
+		eNone = 0,
+		eStartElement,
+		eEndElement,
+		eText,
+		eEndDocument,
+		eError
+	};
+
+	XMLPullReader();
+	virtual ~XMLPullReader();
+
+	virtual void ParseData(const char* data);
+	virtual void ParseFile(const char* filename);
+	virtual void ParseStream(std::istream& is);
+
+	virtual void Reset();
+
+	EEvent Next();
+	EEvent Event() const
+		{ return mEvent; }
+
+	// Element name for start and end events, text for text events
+	const XMLStringView& Name() const
+		{ return mName; }
+	const XMLStringView& Text() const
+		{ return mText; }
+
+	// Attributes of a start element, empty for anything else
+	const XMLAttributeViewList& Attributes() const;
+	bool Attribute(const char* name, XMLStringView& value) const;
+
+	// Elements open around the current event - start and end events count their own element
+	uint32_t Depth() const
+		{ return mDepth; }
+
+	// Jump from a start element to its end, which becomes the current event. Everything in
+	// between is passed over by looking only for tag delimiters - nothing is decoded.
+	bool SkipSubtree();
+
+protected:
+	virtual void StartDocument();
+	virtual void StartElementView(const XMLStringView& name, const XMLAttributeViewList& attributes);
+	virtual void EndElementView(const XMLStringView& name);
+	virtual void CharactersView(const XMLStringView& data);
+
+private:
+	EEvent						mEvent;
+	XMLStringView				mName;
+	XMLStringView				mText;
+	const XMLAttributeViewList*	mAttributes;		// Only set for a start element
+	uint32_t					mDepth;
+	bool						mPopDepth;			// Current event was an end element
+	bool						mPendingEnd;		// Current start element was empty
+	std::ifstream				mFile;				// Files that cannot be mapped
+
+	// Push and parallel parsing hand out events in bulk - only pulling is possible here
+	using XMLSAXSimple::Feed;
+	using XMLSAXSimple::Finish;
+	using XMLSAXSimple::ParseDataParallel;
+	using XMLSAXSimple::ParseFileParallel;
+
+	void Start();
+	void ClearEvent();
+
+	bool SkipPast(const char* end, uint32_t length);
+	bool SkipTag(bool& empty);
+};
+
+}
+#endif
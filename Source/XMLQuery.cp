@@ -0,0 +1,616 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Source for XMLQuery class
+
+#include "XMLQuery.h"
+
+#include "XMLDocument.h"
+
+#include <cstring>
+
+using namespace xmllib;
+
+// Characters that end a name in an expression
+static bool IsNameEnd(char c)
+{
+	return (c == 0) || (::strchr("/[]@=!'\" \t", c) != NULL);
+}
+
+static void SkipSpace(const char*& p)
+{
+	while((*p == ' ') || (*p == '\t'))
+		p++;
+}
+
+// Attributes in a node are always interned, so cNoName for an unknown name never matches
+static const XMLAttribute* FindAttribute(const XMLAttributeList& attributes, uint32_t id)
+{
+	for(XMLAttributeList::const_iterator iter = attributes.begin(); iter != attributes.end(); iter++)
+	{
+		if ((*iter)->NameID() == id)
+			return *iter;
+	}
+
+	return NULL;
+}
+
+static const XMLAttributeView* FindAttribute(const XMLAttributeViewList& attributes, const cdstring& name)
+{
+	for(XMLAttributeViewList::const_iterator iter = attributes.begin(); iter != attributes.end(); iter++)
+	{
+		const XMLStringView& attr_name = (*iter).mName;
+		if ((attr_name.Length() == name.length()) && (::memcmp(attr_name.Data(), name.c_str(), name.length()) == 0))
+			return &*iter;
+	}
+
+	return NULL;
+}
+
+XMLQuery::XMLQuery(const char* expression, const XMLNamespaceList* namespaces)
+{
+	mExpression = expression;
+	mAbsolute = false;
+	mSelect = eSelectElement;
+	mValid = Compile(expression, namespaces);
+	if (!mValid)
+	{
+		mSteps.clear();
+		mPredicates.clear();
+	}
+}
+
+bool XMLQuery::Compile(const char* expression, const XMLNamespaceList* namespaces)
+{
+	const char* p = expression;
+	bool descendant = false;
+	if (*p == '/')
+	{
+		mAbsolute = true;
+		p++;
+		if (*p == '/')
+		{
+			descendant = true;
+			p++;
+		}
+	}
+
+	while(true)
+	{
+		SStep step;
+		step.mDescendant = descendant;
+		step.mAnyName = false;
+		step.mAnyNamespace = false;
+		step.mPredicates = mPredicates.size();
+		step.mPredicateCount = 0;
+		step.mCounters = 0;
+
+		// Attributes and text can only be selected by the last step, which for '//' also needs any
+		// element to select them from
+		bool attribute = (*p == '@');
+		if (attribute || (::strncmp(p, "text()", 6) == 0))
+		{
+			if (attribute)
+			{
+				const char* name = ++p;
+				while(!IsNameEnd(*p))
+					p++;
+				if (p == name)
+					return false;
+				mSelect = eSelectAttribute;
+				mSelectAttribute.assign(name, p - name);
+			}
+			else
+			{
+				p += 6;
+				mSelect = eSelectText;
+			}
+			if (*p != 0)
+				return false;
+
+			if (descendant || (mAbsolute && mSteps.empty()))
+			{
+				if (!descendant)
+					return false;
+				step.mAnyName = true;
+				step.mAnyNamespace = true;
+				mSteps.push_back(step);
+			}
+			if (attribute && !mSteps.empty())
+				AddAttributePredicate(mSteps.back(), eHasAttribute, mSelectAttribute);
+			return true;
+		}
+
+		// Name test
+		const char* name = p;
+		while(!IsNameEnd(*p))
+			p++;
+		if (p == name)
+			return false;
+		cdstring qname(name, p - name);
+		if (qname == "*")
+		{
+			step.mAnyName = true;
+			step.mAnyNamespace = true;
+		}
+		else
+		{
+			cdstring prefix;
+			cdstring::size_type colon = qname.find(':');
+			if (colon != cdstring::npos)
+			{
+				prefix.assign(name, colon);
+				step.mName.assign(name + colon + 1, qname.length() - colon - 1);
+				if (prefix.empty() || step.mName.empty())
+					return false;
+			}
+			else
+				step.mName = qname;
+			step.mAnyName = (step.mName == "*");
+
+			// An undeclared prefix is an error, but no prefix just means no namespace
+			bool found = prefix.empty();
+			if (namespaces != NULL)
+			{
+				for(XMLNamespaceList::const_iterator iter = namespaces->begin(); iter != namespaces->end(); iter++)
+				{
+					if ((*iter).Prefix() == prefix)
+					{
+						step.mNamespace = (*iter).Name();
+						found = true;
+						break;
+					}
+				}
+			}
+			if (!found)
+				return false;
+		}
+
+		while(*p == '[')
+		{
+			if (!CompilePredicate(p, step))
+				return false;
+		}
+		mSteps.push_back(step);
+
+		if (*p == 0)
+			return true;
+		if (*p != '/')
+			return false;
+		p++;
+		descendant = (*p == '/');
+		if (descendant)
+			p++;
+	}
+}
+
+// At the '[' of a predicate, leaving p after its ']'
+bool XMLQuery::CompilePredicate(const char*& p, SStep& step)
+{
+	p++;
+	SkipSpace(p);
+
+	if ((*p >= '1') && (*p <= '9'))
+	{
+		SPredicate predicate;
+		predicate.mType = ePosition;
+		predicate.mPosition = 0;
+		while((*p >= '0') && (*p <= '9'))
+		{
+			predicate.mPosition = predicate.mPosition * 10 + (*p++ - '0');
+			if (predicate.mPosition > 0x0FFFFFFF)
+				return false;
+		}
+		mPredicates.push_back(predicate);
+		step.mPredicateCount++;
+		step.mCounters++;
+	}
+	else if (*p == '@')
+	{
+		const char* name = ++p;
+		while(!IsNameEnd(*p))
+			p++;
+		if (p == name)
+			return false;
+		cdstring attribute(name, p - name);
+		SkipSpace(p);
+
+		EPredicate type = eHasAttribute;
+		if (*p == '=')
+		{
+			type = eAttributeEquals;
+			p++;
+		}
+		else if ((p[0] == '!') && (p[1] == '='))
+		{
+			type = eAttributeNotEquals;
+			p += 2;
+		}
+		AddAttributePredicate(step, type, attribute);
+
+		if (type != eHasAttribute)
+		{
+			SkipSpace(p);
+			char quote = *p;
+			if ((quote != '\'') && (quote != '"'))
+				return false;
+			const char* value = ++p;
+			while((*p != 0) && (*p != quote))
+				p++;
+			if (*p == 0)
+				return false;
+			mPredicates.back().mValue.assign(value, p - value);
+			p++;
+		}
+	}
+	else
+		return false;
+
+	SkipSpace(p);
+	if (*p != ']')
+		return false;
+	p++;
+	return true;
+}
+
+// Predicates of a step are always added while it is the last one
+void XMLQuery::AddAttributePredicate(SStep& step, EPredicate type, const cdstring& attribute)
+{
+	SPredicate predicate;
+	predicate.mType = type;
+	predicate.mPosition = 0;
+	predicate.mAttribute = attribute;
+	mPredicates.push_back(predicate);
+	step.mPredicateCount++;
+}
+
+void XMLQuery::Select(const XMLNode* node, XMLConstNodeList& result) const
+{
+	result.clear();
+	Run(node, result, false);
+}
+
+const XMLNode* XMLQuery::SelectFirst(const XMLNode* node) const
+{
+	XMLConstNodeList result;
+	Run(node, result, true);
+	return result.empty() ? NULL : result.front();
+}
+
+void XMLQuery::SelectValues(const XMLNode* node, cdstrvect& result) const
+{
+	result.clear();
+	XMLConstNodeList nodes;
+	Run(node, nodes, false);
+	if (nodes.empty())
+		return;
+
+	SState state;
+	Begin(state, node->Document()->Names());
+	result.reserve(nodes.size());
+	for(XMLConstNodeList::const_iterator iter = nodes.begin(); iter != nodes.end(); iter++)
+	{
+		result.push_back(cdstring::null_str);
+		Value(state, *iter, result.back());
+	}
+}
+
+bool XMLQuery::SelectValue(const XMLNode* node, cdstring& result) const
+{
+	XMLConstNodeList nodes;
+	Run(node, nodes, true);
+	if (nodes.empty())
+		return false;
+
+	SState state;
+	Begin(state, node->Document()->Names());
+	return Value(state, nodes.front(), result);
+}
+
+void XMLQuery::Run(const XMLNode* node, XMLConstNodeList& result, bool first) const
+{
+	if (!mValid || (node == NULL))
+		return;
+
+	// Only an attribute or text() - selected from the node itself
+	if (mSteps.empty())
+	{
+		SState state;
+		Begin(state, node->Document()->Names());
+		cdstring value;
+		if (Value(state, node, value))
+			result.push_back(node);
+		return;
+	}
+
+	SState state;
+	Begin(state, node->Document()->Names());
+	if (mAbsolute)
+		Visit(state, node->Document()->GetRoot(), result, first);
+	else
+	{
+		const XMLNodeList& children = node->Children();
+		for(XMLNodeList::const_iterator iter = children.begin(); iter != children.end(); iter++)
+		{
+			Visit(state, *iter, result, first);
+			if (first && !result.empty())
+				break;
+		}
+	}
+}
+
+// Nothing below an element is looked at once no step can match there
+void XMLQuery::Visit(SState& state, const XMLNode* node, XMLConstNodeList& result, bool first) const
+{
+	// Elements without text have no text to select
+	bool selected = Enter(state, node->NameID(), node->NamespaceNameID(), node->Attributes());
+	if (selected && (mSelect == eSelectText) && node->Data().empty())
+		selected = false;
+	if (selected)
+	{
+		result.push_back(node);
+		if (first)
+		{
+			Leave(state);
+			return;
+		}
+	}
+
+	if (Active(state))
+	{
+		const XMLNodeList& children = node->Children();
+		for(XMLNodeList::const_iterator iter = children.begin(); iter != children.end(); iter++)
+		{
+			Visit(state, *iter, result, first);
+			if (first && !result.empty())
+				break;
+		}
+	}
+
+	Leave(state);
+}
+
+bool XMLQuery::Value(const SState& state, const XMLNode* node, cdstring& result) const
+{
+	if (mSelect != eSelectAttribute)
+	{
+		result = node->Data();
+		return (mSelect == eSelectElement) || !result.empty();
+	}
+
+	const XMLAttribute* attr = FindAttribute(node->Attributes(), state.mSelectName);
+	if (attr == NULL)
+		return false;
+	result = attr->Value();
+	return true;
+}
+
+// Names that were never interned cannot be in the document so are given an id nothing has
+void XMLQuery::Begin(SState& state, const XMLNameTable& names) const
+{
+	state.mNames = &names;
+	state.mStepNames.resize(mSteps.size());
+	state.mStepNamespaces.resize(mSteps.size());
+	for(uint32_t i = 0; i < mSteps.size(); i++)
+	{
+		const SStep& step = mSteps[i];
+		if (step.mAnyName || !names.Find(step.mName.c_str(), step.mName.length(), state.mStepNames[i]))
+			state.mStepNames[i] = XMLNameTable::cNoName;
+		if (step.mAnyNamespace || !names.Find(step.mNamespace.c_str(), step.mNamespace.length(), state.mStepNamespaces[i]))
+			state.mStepNamespaces[i] = XMLNameTable::cNoName;
+	}
+
+	state.mAttributeNames.resize(mPredicates.size());
+	for(uint32_t i = 0; i < mPredicates.size(); i++)
+	{
+		const SPredicate& predicate = mPredicates[i];
+		if ((predicate.mType == ePosition) || !names.Find(predicate.mAttribute.c_str(), predicate.mAttribute.length(), state.mAttributeNames[i]))
+			state.mAttributeNames[i] = XMLNameTable::cNoName;
+	}
+	if (!names.Find(mSelectAttribute.c_str(), mSelectAttribute.length(), state.mSelectName))
+		state.mSelectName = XMLNameTable::cNoName;
+
+	// The first step is matched against the top elements
+	state.mEntries.clear();
+	state.mLevels.assign(1, 0);
+	state.mCounters.clear();
+	state.mCounterLevels.assign(1, 0);
+	if (!mSteps.empty())
+		AddEntry(state, 0, 0);
+}
+
+bool XMLQuery::Enter(SState& state, uint32_t name, uint32_t namespc, const XMLAttributeList& attributes) const
+{
+	return EnterAny(state, name, namespc, attributes);
+}
+
+bool XMLQuery::Enter(SState& state, uint32_t name, uint32_t namespc, const XMLAttributeViewList& attributes) const
+{
+	return EnterAny(state, name, namespc, attributes);
+}
+
+// Opens a level for the element holding the steps its children are matched against - true
+// if the element is selected
+template <class T> bool XMLQuery::EnterAny(SState& state, uint32_t name, uint32_t namespc, const T& attributes) const
+{
+	uint32_t begin = state.mLevels.back();
+	uint32_t end = state.mEntries.size();
+	state.mLevels.push_back(end);
+	state.mCounterLevels.push_back(state.mCounters.size());
+
+	bool selected = false;
+	for(uint32_t i = begin; i < end; i++)
+	{
+		SEntry entry = state.mEntries[i];
+		const SStep& step = mSteps[entry.mStep];
+
+		// Descendant steps carry on being matched further down
+		if (step.mDescendant)
+			AddEntry(state, end, entry.mStep);
+
+		if ((!step.mAnyName && (state.mStepNames[entry.mStep] != name)) ||
+			(!step.mAnyNamespace && (state.mStepNamespaces[entry.mStep] != namespc)))
+			continue;
+
+		// Predicates in order, each position counting only the elements that got that far
+		bool matched = true;
+		uint32_t counter = entry.mCounters;
+		for(uint32_t j = step.mPredicates; matched && (j < step.mPredicates + step.mPredicateCount); j++)
+		{
+			const SPredicate& predicate = mPredicates[j];
+			if (predicate.mType == ePosition)
+				matched = (++state.mCounters[counter++] == predicate.mPosition);
+			else
+				matched = MatchAttribute(state, predicate, attributes);
+		}
+		if (!matched)
+			continue;
+
+		if (entry.mStep + 1 == mSteps.size())
+			selected = true;
+		else
+			AddEntry(state, end, entry.mStep + 1);
+	}
+
+	return selected;
+}
+
+// Opens a level for the node a relative expression is run on, without matching it, so its
+// children are matched against the first step
+void XMLQuery::EnterContext(SState& state) const
+{
+	state.mLevels.push_back(state.mEntries.size());
+	state.mCounterLevels.push_back(state.mCounters.size());
+	if (!mSteps.empty())
+		AddEntry(state, state.mLevels.back(), 0);
+}
+
+void XMLQuery::Leave(SState& state) const
+{
+	state.mEntries.resize(state.mLevels.back());
+	state.mLevels.pop_back();
+	state.mCounters.resize(state.mCounterLevels.back());
+	state.mCounterLevels.pop_back();
+}
+
+// A step reached by more than one route is only matched once
+void XMLQuery::AddEntry(SState& state, uint32_t begin, uint32_t step) const
+{
+	for(uint32_t i = begin; i < state.mEntries.size(); i++)
+	{
+		if (state.mEntries[i].mStep == step)
+			return;
+	}
+
+	SEntry entry;
+	entry.mStep = step;
+	entry.mCounters = state.mCounters.size();
+	state.mEntries.push_back(entry);
+	state.mCounters.insert(state.mCounters.end(), mSteps[step].mCounters, 0);
+}
+
+bool XMLQuery::MatchAttribute(const SState& state, const SPredicate& predicate, const XMLAttributeList& attributes) const
+{
+	const XMLAttribute* attr = FindAttribute(attributes, state.mAttributeNames[&predicate - &mPredicates[0]]);
+	if (attr == NULL)
+		return false;
+
+	switch(predicate.mType)
+	{
+	case eAttributeEquals:
+		return attr->Value() == predicate.mValue;
+	case eAttributeNotEquals:
+		return attr->Value() != predicate.mValue;
+	default:
+		return true;
+	}
+}
+
+bool XMLQuery::MatchAttribute(const SState& state, const SPredicate& predicate, const XMLAttributeViewList& attributes) const
+{
+	const XMLAttributeView* attr = FindAttribute(attributes, predicate.mAttribute);
+	if (attr == NULL)
+		return false;
+
+	bool equal = (attr->mValue.Length() == predicate.mValue.length()) &&
+					(::memcmp(attr->mValue.Data(), predicate.mValue.c_str(), predicate.mValue.length()) == 0);
+	switch(predicate.mType)
+	{
+	case eAttributeEquals:
+		return equal;
+	case eAttributeNotEquals:
+		return !equal;
+	default:
+		return true;
+	}
+}
+
+XMLQueryCache::XMLQueryCache(const XMLNamespaceList* namespaces)
+{
+	if (namespaces != NULL)
+		mNamespaces = *namespaces;
+}
+
+XMLQueryCache::~XMLQueryCache()
+{
+	Clear();
+}
+
+const XMLQuery& XMLQueryCache::Get(const char* expression)
+{
+	XMLMutexLock lock(mLock);
+
+	uint32_t id = mExpressions.Intern(expression);
+	if (id >= mQueries.size())
+		mQueries.resize(id + 1, NULL);
+	if (mQueries[id] == NULL)
+		mQueries[id] = new XMLQuery(expression, &mNamespaces);
+
+	return *mQueries[id];
+}
+
+void XMLQueryCache::SetNamespaces(const XMLNamespaceList& namespaces)
+{
+	Clear();
+
+	XMLMutexLock lock(mLock);
+	mNamespaces = namespaces;
+}
+
+// Expressions stay interned so they keep their slots
+void XMLQueryCache::Clear()
+{
+	XMLMutexLock lock(mLock);
+
+	for(std::vector<XMLQuery*>::iterator iter = mQueries.begin(); iter != mQueries.end(); iter++)
+	{
+		delete *iter;
+		*iter = NULL;
+	}
+}
+
+uint32_t XMLQueryCache::Count() const
+{
+	XMLMutexLock lock(mLock);
+
+	uint32_t count = 0;
+	for(std::vector<XMLQuery*>::const_iterator iter = mQueries.begin(); iter != mQueries.end(); iter++)
+	{
+		if (*iter != NULL)
+			count++;
+	}
+	return count;
+}
@@ -0,0 +1,202 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Header for XMLQuery class
+
+#ifndef __XMLQUERY__XMLLIB__
+#define __XMLQUERY__XMLLIB__
+
+#include "XMLAttribute.h"
+#include "XMLMutex.h"
+#include "XMLNameTable.h"
+#include "XMLNamespace.h"
+#include "XMLNode.h"
+#include "XMLStringView.h"
+
+#include "cdstring.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace xmllib
+{
+
+// Compiled query using a subset of XPath 1.0:
+//
+//   /a/b			children - an expression starting with '/' starts at the root element,
+//					anything else at the children of the node it is run on
+//   //a, a//b		descendants
+//   *, p:*, p:a		any element, any element in a namespace, a namespace qualified name
+//   [2]				position among the siblings that got that far
+//   [@x], [@x='v'], [@x!='v']	attribute present, equal or not equal to a quoted value
+//   @x, text()		last step only - select an attribute, or the text of elements with some
+//
+// Prefixes in the expression are looked up in the namespaces given when compiling, and a
+// namespace with an empty prefix applies to names without one. Otherwise names without a
+// prefix are in no namespace. Attribute names are compared as written in the document.
+//
+// Element names are matched by their interned ids in the document's name table, resolved
+// once for each run, so nothing is allocated per node. A compiled query is never changed
+// by running it, so can be shared by any number of threads.
+
+class XMLQuery
+{
+public:
+	explicit XMLQuery(const char* expression, const XMLNamespaceList* namespaces = NULL);
+	~XMLQuery() {}
+
+	// False if the expression could not be compiled, in which case nothing is ever selected
+	bool Valid() const
+	{
+		return mValid;
+	}
+	const cdstring& Expression() const
+	{
+		return mExpression;
+	}
+
+	// Elements selected below node in document order. For an attribute or text() these are the
+	// elements whose attribute or text is selected.
+	void Select(const XMLNode* node, XMLConstNodeList& result) const;
+	const XMLNode* SelectFirst(const XMLNode* node) const;
+
+	// Attribute values or element text selected below node in document order
+	void SelectValues(const XMLNode* node, cdstrvect& result) const;
+	bool SelectValue(const XMLNode* node, cdstring& result) const;
+
+private:
+	friend class XMLQueryParser;
+
+	enum ESelect
+	{
+		eSelectElement,
+		eSelectText,
+		eSelectAttribute
+	};
+
+	enum EPredicate
+	{
+		ePosition,
+		eHasAttribute,
+		eAttributeEquals,
+		eAttributeNotEquals
+	};
+
+	struct SPredicate
+	{
+		EPredicate	mType;
+		uint32_t	mPosition;			// 1 based, or index of the counter for ePosition
+		cdstring	mAttribute;
+		cdstring	mValue;
+	};
+
+	struct SStep
+	{
+		bool		mDescendant;		// Any depth below the previous step
+		bool		mAnyName;
+		bool		mAnyNamespace;
+		cdstring	mName;				// Local name
+		cdstring	mNamespace;
+		uint32_t	mPredicates;		// First in mPredicates
+		uint32_t	mPredicateCount;
+		uint32_t	mCounters;			// Positional predicates
+	};
+
+	// A step being matched against the children of an open element
+	struct SEntry
+	{
+		uint32_t	mStep;
+		uint32_t	mCounters;			// First in SState::mCounters
+	};
+
+	// Everything that changes during a run
+	struct SState
+	{
+		const XMLNameTable*		mNames;
+		std::vector<uint32_t>	mStepNames;			// Resolved ids of the steps' names
+		std::vector<uint32_t>	mStepNamespaces;
+		std::vector<uint32_t>	mAttributeNames;	// Resolved ids of the predicates' attributes
+		uint32_t				mSelectName;		// Resolved id of the selected attribute
+		std::vector<SEntry>		mEntries;			// Of all open elements, innermost last
+		std::vector<uint32_t>	mLevels;			// Start of each open element's entries
+		std::vector<uint32_t>	mCounters;
+		std::vector<uint32_t>	mCounterLevels;		// Start of each open element's counters
+	};
+
+	cdstring				mExpression;
+	bool					mValid;
+	bool					mAbsolute;
+	ESelect					mSelect;
+	cdstring				mSelectAttribute;
+	std::vector<SStep>		mSteps;
+	std::vector<SPredicate>	mPredicates;
+
+	bool Compile(const char* expression, const XMLNamespaceList* namespaces);
+	bool CompilePredicate(const char*& p, SStep& step);
+	void AddAttributePredicate(SStep& step, EPredicate type, const cdstring& attribute);
+
+	// Running - names are interned in names as they are in the elements matched
+	void Begin(SState& state, const XMLNameTable& names) const;
+	bool Enter(SState& state, uint32_t name, uint32_t namespc, const XMLAttributeList& attributes) const;
+	bool Enter(SState& state, uint32_t name, uint32_t namespc, const XMLAttributeViewList& attributes) const;
+	void EnterContext(SState& state) const;
+	void Leave(SState& state) const;
+	bool Active(const SState& state) const
+	{
+		return state.mEntries.size() > state.mLevels.back();
+	}
+
+	template <class T> bool EnterAny(SState& state, uint32_t name, uint32_t namespc, const T& attributes) const;
+	void AddEntry(SState& state, uint32_t begin, uint32_t step) const;
+	bool MatchAttribute(const SState& state, const SPredicate& predicate, const XMLAttributeList& attributes) const;
+	bool MatchAttribute(const SState& state, const SPredicate& predicate, const XMLAttributeViewList& attributes) const;
+
+	void Run(const XMLNode* node, XMLConstNodeList& result, bool first) const;
+	void Visit(SState& state, const XMLNode* node, XMLConstNodeList& result, bool first) const;
+	bool Value(const SState& state, const XMLNode* node, cdstring& result) const;
+};
+
+// Compiled queries shared by expression, each compiled the first time it is asked for. The
+// queries are owned by the cache and stay valid until it is cleared. Safe to use from any
+// number of threads.
+
+class XMLQueryCache
+{
+public:
+	explicit XMLQueryCache(const XMLNamespaceList* namespaces = NULL);
+	~XMLQueryCache();
+
+	const XMLQuery& Get(const char* expression);
+
+	// Changing the namespaces clears the cache
+	void SetNamespaces(const XMLNamespaceList& namespaces);
+	void Clear();
+
+	uint32_t Count() const;
+
+private:
+	XMLNameTable			mExpressions;		// Interned expressions index mQueries
+	std::vector<XMLQuery*>	mQueries;
+	XMLNamespaceList		mNamespaces;
+	mutable XMLMutex		mLock;
+
+	// Not copyable
+	XMLQueryCache(const XMLQueryCache& copy);
+	XMLQueryCache& operator=(const XMLQueryCache& copy);
+};
+
+}
+#endif
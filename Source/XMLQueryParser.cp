@@ -0,0 +1,216 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Source for XMLQueryParser class
+
+#include "XMLQueryParser.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace xmllib;
+
+XMLQueryParser::XMLQueryParser(const XMLQuery& query) :
+	mQuery(query)
+{
+	// Element names that are not in the query cannot match so are never interned
+	for(std::vector<XMLQuery::SStep>::const_iterator iter = mQuery.mSteps.begin(); iter != mQuery.mSteps.end(); iter++)
+	{
+		mNames.Intern((*iter).mName);
+		mNames.Intern((*iter).mNamespace);
+	}
+	mStarted = false;
+	mSkip = 0;
+}
+
+void XMLQueryParser::Reset()
+{
+	XMLSAXSimple::Reset();
+
+	mStarted = false;
+	mOpen.clear();
+	mSkip = 0;
+	mValues.clear();
+}
+
+void XMLQueryParser::StartDocument()
+{
+	mQuery.Begin(mState, mNames);
+	mStarted = true;
+	mOpen.clear();
+	mNamespaceScope.Reset();
+	mSkip = 0;
+	mValues.clear();
+}
+
+void XMLQueryParser::StartElementView(const XMLStringView& name, const XMLAttributeViewList& attributes)
+{
+	// Don't bother if on error state or nothing can match in here
+	if (mError || !mQuery.Valid())
+		return;
+	if (mSkip != 0)
+	{
+		mSkip++;
+		return;
+	}
+
+	// We always need a document
+	if (!mStarted)
+		StartDocument();
+
+	try
+	{
+		SScope scope;
+		scope.mDefault = mOpen.empty() ? XMLNameTable::cEmptyName : mOpen.back().mDefault;
+		scope.mValue = cNoValue;
+
+		mNamespaceScope.Push();
+		for(XMLAttributeViewList::const_iterator iter = attributes.begin(); iter != attributes.end(); iter++)
+		{
+			const XMLStringView& attr_name = (*iter).mName;
+			const XMLStringView& attr_value = (*iter).mValue;
+			if ((attr_name.Length() < 5) || (::memcmp(attr_name.Data(), "xmlns", 5) != 0))
+				continue;
+			if (attr_name.Length() == 5)
+				scope.mDefault = mNames.Intern(attr_value.Data(), attr_value.Length());
+			else if (attr_name[5] == ':')
+				mNamespaceScope.Bind(mNames.Intern(attr_name.Data() + 6, attr_name.Length() - 6), mNames.Intern(attr_value.Data(), attr_value.Length()));
+		}
+
+		// A prefix selects a declared namespace, otherwise the default one applies
+		uint32_t name_id;
+		uint32_t namespace_id;
+		const char* colon = static_cast<const char*>(::memchr(name.Data(), ':', name.Length()));
+		if (colon != NULL)
+		{
+			size_t prefix_length = colon - name.Data();
+			name_id = Find(colon + 1, name.Length() - prefix_length - 1);
+			namespace_id = ResolvePrefix(name.Data(), prefix_length);
+		}
+		else
+		{
+			name_id = Find(name.Data(), name.Length());
+			namespace_id = scope.mDefault;
+		}
+
+		// A relative expression starts at the children of the root element, or selects the
+		// root element itself if it has no steps
+		bool selected;
+		if (mOpen.empty() && !mQuery.mAbsolute)
+		{
+			mQuery.EnterContext(mState);
+			selected = mQuery.mSteps.empty();
+		}
+		else
+			selected = mQuery.Enter(mState, name_id, namespace_id, attributes);
+
+		if (selected)
+		{
+			if (mQuery.mSelect == XMLQuery::eSelectAttribute)
+			{
+				const XMLAttributeView* attr = NULL;
+				const cdstring& select = mQuery.mSelectAttribute;
+				for(XMLAttributeViewList::const_iterator iter = attributes.begin(); iter != attributes.end(); iter++)
+				{
+					if (((*iter).mName.Length() == select.length()) && (::memcmp((*iter).mName.Data(), select.c_str(), select.length()) == 0))
+					{
+						attr = &*iter;
+						break;
+					}
+				}
+				if (attr != NULL)
+					mValues.push_back(attr->mValue.ToString());
+			}
+			else
+			{
+				scope.mValue = mValues.size();
+				mValues.push_back(cdstring::null_str);
+			}
+		}
+
+		// Only the element's own text is wanted once nothing can match below it
+		if (!mQuery.Active(mState) && (scope.mValue == cNoValue))
+		{
+			mQuery.Leave(mState);
+			mNamespaceScope.Pop();
+			mSkip = 1;
+			return;
+		}
+
+		mOpen.push_back(scope);
+	}
+	catch (const std::exception& e)
+	{
+		HandleException(e);
+	}
+}
+
+void XMLQueryParser::EndElementView(const XMLStringView& name)
+{
+	// Don't bother if on error state
+	if (mError)
+		return;
+	if (mSkip != 0)
+	{
+		mSkip--;
+		return;
+	}
+	if (mOpen.empty())
+		return;
+
+	mQuery.Leave(mState);
+	mNamespaceScope.Pop();
+	mOpen.pop_back();
+
+	// Elements that turned out to have no text are only dropped once all are closed, as later
+	// values may have been added after theirs
+	if (mOpen.empty() && (mQuery.mSelect == XMLQuery::eSelectText))
+		mValues.erase(std::remove(mValues.begin(), mValues.end(), cdstring::null_str), mValues.end());
+}
+
+void XMLQueryParser::CharactersView(const XMLStringView& data)
+{
+	// Don't bother if on error state or the text is not selected
+	if (mError || (mSkip != 0) || mOpen.empty() || (mOpen.back().mValue == cNoValue))
+		return;
+
+	try
+	{
+		mValues[mOpen.back().mValue].append(data.Data(), data.Length());
+	}
+	catch (const std::exception& e)
+	{
+		HandleException(e);
+	}
+}
+
+// Names not in the table cannot be in the query
+uint32_t XMLQueryParser::Find(const char* name, size_t length) const
+{
+	uint32_t id;
+	return mNames.Find(name, length, id) ? id : XMLNameTable::cNoName;
+}
+
+// Undeclared prefixes are in no namespace
+uint32_t XMLQueryParser::ResolvePrefix(const char* prefix, size_t length) const
+{
+	uint32_t id;
+	uint32_t result;
+	if (mNames.Find(prefix, length, id) && mNamespaceScope.Lookup(id, result))
+		return result;
+
+	return XMLNameTable::cEmptyName;
+}
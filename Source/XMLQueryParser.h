@@ -0,0 +1,89 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Header for XMLQueryParser class
+
+#ifndef __XMLQUERYPARSER__XMLLIB__
+#define __XMLQUERYPARSER__XMLLIB__
+
+#include "XMLSAXSimple.h"
+
+#include "XMLNameTable.h"
+#include "XMLQuery.h"
+
+#include <vector>
+
+namespace xmllib
+{
+
+// Runs a query while parsing, so no document is built and Document() stays NULL. Only the
+// selected values are kept - attribute values, or the text directly inside each selected
+// element for text() or an element. Elements below which no step can match are skipped
+// without being looked at. A relative expression is run on the root element, giving the
+// values XMLQuery::SelectValues gives for the document's root. The query must outlive the
+// parser.
+
+class XMLQueryParser : public XMLSAXSimple
+{
+public:
+	explicit XMLQueryParser(const XMLQuery& query);
+	virtual ~XMLQueryParser() {}
+
+	// Selected values in document order
+	const cdstrvect& Values() const
+	{
+		return mValues;
+	}
+
+	virtual void Reset();
+
+protected:
+	virtual void StartDocument();
+	virtual void StartElementView(const XMLStringView& name, const XMLAttributeViewList& attributes);
+	virtual void EndElementView(const XMLStringView& name);
+	virtual void CharactersView(const XMLStringView& data);
+
+private:
+	static const uint32_t cNoValue = 0xFFFFFFFF;
+
+	// An open element
+	struct SScope
+	{
+		uint32_t	mDefault;			// Default namespace in scope inside it
+		uint32_t	mValue;				// Index of its text in mValues if selected
+	};
+
+	const XMLQuery&			mQuery;
+	XMLQuery::SState		mState;
+	XMLNameTable			mNames;				// The query's names and the namespaces seen
+	bool					mStarted;
+	std::vector<SScope>		mOpen;
+	uint32_t				mSkip;				// Depth inside an element nothing can match below
+	cdstrvect				mValues;
+
+	// Nothing is built so cannot be dropped
+	using XMLParserSAX::SetProjection;
+
+	uint32_t Find(const char* name, size_t length) const;
+	uint32_t ResolvePrefix(const char* prefix, size_t length) const;
+
+	// Not copyable
+	XMLQueryParser(const XMLQueryParser& copy);
+	XMLQueryParser& operator=(const XMLQueryParser& copy);
+};
+
+}
+#endif
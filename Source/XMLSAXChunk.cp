@@ -0,0 +1,153 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+// Source for XMLSAXChunk class
+
+#include "XMLSAXChunk.h"
+
+using namespace xmllib;
+
+XMLSAXChunk::XMLSAXChunk()
+{
+	mStart = mLimit = mDataEnd = mEnd = NULL;
+	mFirst = false;
+	mStopped = false;
+	mTokenised = false;
+}
+
+XMLSAXChunk::~XMLSAXChunk()
+{
+}
+
+void XMLSAXChunk::Set(const char* start, const char* limit, const char* end, bool first)
+{
+	mStart = start;
+	mLimit = limit;
+	mDataEnd = end;
+	mFirst = first;
+	mTokenised = false;
+}
+
+void XMLSAXChunk::Tokenise()
+{
+	mEvents.clear();
+	mAttributeViews.clear();
+	mStorage.Reset();
+	mError = false;
+	mStopped = false;
+	mTokenised = false;
+
+	// Counted by the chunk as it may be on a thread of its own, and added to the parser's
+	// stats when it is replayed
+	mStats.Clear();
+	XMLStatsScope stats(mStats);
+
+	// Exactly as ParseIt, but stopping at the first token past the limit
+	mBuffer.SetData(mStart, mDataEnd - mStart);
+	if (mFirst)
+		SkipWS();
+	while(!mBuffer.fail() && ((mLimit == NULL) || (mBuffer.next() < mLimit)))
+	{
+		if (!ParseToken())
+		{
+			// Only the end of the data stops parsing without an error
+			if (!mError)
+				Record(eEndDocument, XMLStringView());
+			mStopped = true;
+			break;
+		}
+	}
+	if (mBuffer.fail())
+		mStopped = true;
+	mEnd = mBuffer.next();
+
+	mTokenised = true;
+}
+
+void XMLSAXChunk::StartTokenise()
+{
+	Join();
+	mTokenised = false;
+	if (!mThread.Start(_Tokenise, this))
+		_Tokenise(this);
+}
+
+void XMLSAXChunk::Join()
+{
+	mThread.Join();
+}
+
+void XMLSAXChunk::_Tokenise(void* chunk)
+{
+	// Failures leave the chunk untokenised, to be tokenised again by the caller
+	try
+	{
+		static_cast<XMLSAXChunk*>(chunk)->Tokenise();
+	}
+	catch(...)
+	{
+	}
+}
+
+// The document state is only known when replaying so the declaration check is left to that
+void XMLSAXChunk::StartDocument()
+{
+	Record(eStartDocument, XMLStringView());
+}
+
+void XMLSAXChunk::StartElementView(const XMLStringView& name, const XMLAttributeViewList& attributes)
+{
+	Record(eStartElement, name);
+	mEvents.back().mAttributes = mAttributeViews.size();
+	mEvents.back().mCount = attributes.size();
+	for(XMLAttributeViewList::const_iterator iter = attributes.begin(); iter != attributes.end(); iter++)
+		mAttributeViews.push_back(XMLAttributeView(Keep((*iter).mName), Keep((*iter).mValue)));
+}
+
+void XMLSAXChunk::EndElementView(const XMLStringView& name)
+{
+	Record(eEndElement, name);
+}
+
+void XMLSAXChunk::CharactersView(const XMLStringView& data)
+{
+	Record(eCharacters, data);
+}
+
+void XMLSAXChunk::FatalError(const cdstring& text)
+{
+	Record(eFatalError, XMLStringView(text));
+	mError = true;
+}
+
+void XMLSAXChunk::Record(EEvent type, const XMLStringView& text)
+{
+	SEvent event;
+	event.mType = type;
+	event.mText = Keep(text);
+	event.mAttributes = 0;
+	event.mCount = 0;
+	mEvents.push_back(event);
+}
+
+// Decoded text and messages only live until the callback returns so need copying
+XMLStringView XMLSAXChunk::Keep(const XMLStringView& text)
+{
+	if (text.Empty() || ((text.Data() >= mStart) && (text.Data() + text.Length() <= mDataEnd)))
+		return text;
+	return XMLStringView(mStorage.Copy(text.Data(), text.Length()), text.Length());
+}
@@ -0,0 +1,133 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+// Header for XMLSAXChunk class
+
+#ifndef __XMLSAXCHUNK__XMLLIB__
+#define __XMLSAXCHUNK__XMLLIB__
+
+#include "XMLSAXSimple.h"
+
+#include "XMLThread.h"
+
+#include <vector>
+
+namespace xmllib
+{
+
+// One piece of a document being parsed in parallel by XMLSAXSimple. The tokens in the piece
+// are parsed with the regular parsing code and the callbacks they make are recorded rather
+// than acted on, so they can be replayed once the piece is known to start on a real token
+// boundary. The text of the callbacks points into the data or into the chunk's own storage.
+
+class XMLSAXChunk : public XMLSAXSimple
+{
+public:
+	enum EEvent
+	{
+		eStartDocument,
+		eEndDocument,
+		eStartElement,
+		eEndElement,
+		eCharacters,
+		eFatalError
+	};
+
+	struct SEvent
+	{
+		EEvent			mType;
+		XMLStringView	mText;				// Name, characters or error message
+		uint32_t		mAttributes;		// First of a start element's attributes
+		uint32_t		mCount;
+	};
+
+	XMLSAXChunk();
+	virtual ~XMLSAXChunk();
+
+	// Tokenise from start up to the first token at or after limit - NULL for all of it. The
+	// data runs on to end so tokens crossing the limit are still complete. Only the first
+	// chunk of a document skips leading whitespace.
+	void Set(const char* start, const char* limit, const char* end, bool first);
+
+	void Tokenise();				// On the calling thread
+	void StartTokenise();			// On a thread of its own - Join before using the results
+	void Join();
+
+	bool Tokenised() const
+	{
+		return mTokenised;
+	}
+	const char* Start() const
+	{
+		return mStart;
+	}
+	const char* Limit() const
+	{
+		return mLimit;
+	}
+	const char* End() const			// Where the next token starts
+	{
+		return mEnd;
+	}
+	bool Stopped() const			// Parsing ended in this chunk
+	{
+		return mStopped;
+	}
+
+	const std::vector<SEvent>& Events() const
+	{
+		return mEvents;
+	}
+	const XMLAttributeView* Attributes(const SEvent& event) const
+	{
+		return (event.mCount != 0) ? &mAttributeViews[event.mAttributes] : NULL;
+	}
+
+protected:
+	virtual void StartDocument();
+	virtual void StartElementView(const XMLStringView& name, const XMLAttributeViewList& attributes);
+	virtual void EndElementView(const XMLStringView& name);
+	virtual void CharactersView(const XMLStringView& data);
+	virtual void FatalError(const cdstring& text);
+
+private:
+	const char*						mStart;
+	const char*						mLimit;
+	const char*						mDataEnd;
+	bool							mFirst;
+	const char*						mEnd;
+	bool							mStopped;
+	bool							mTokenised;
+
+	std::vector<SEvent>				mEvents;
+	std::vector<XMLAttributeView>	mAttributeViews;
+	XMLArena						mStorage;			// Text that is not in the data itself
+
+	XMLThread						mThread;			// Last so it is joined first
+
+	static void _Tokenise(void* chunk);
+
+	void Record(EEvent type, const XMLStringView& text);
+	XMLStringView Keep(const XMLStringView& text);
+
+	// Not copyable
+	XMLSAXChunk(const XMLSAXChunk& copy);
+	XMLSAXChunk& operator=(const XMLSAXChunk& copy);
+};
+
+}
+#endif
@@ -18,28 +18,67 @@
 
 #include "XMLSAXSimple.h"
 
-#include <cstdlib>
+#include "XMLEntities.h"
+#include "XMLSAXChunk.h"
+#include "XMLThread.h"
+
+#include <cstring>
 #include <fstream>
-#include <strstream>
 
 using namespace xmllib;
 
 XMLSAXSimple::XMLSAXSimple()
 {
+	mPushing = false;
+	mPushStarted = false;
+	mPushScanned = 0;
+	mPushQuote = 0;
 }
 
 XMLSAXSimple::~XMLSAXSimple()
 {
+	for(std::vector<XMLSAXChunk*>::iterator iter = mChunks.begin(); iter != mChunks.end(); iter++)
+		delete *iter;
+}
+
+void XMLSAXSimple::Reset()
+{
+	XMLParserSAX::Reset();
+
+	mBuffer.Reset();
+	mAttributes.clear();
+	mToken.clear();
+	mText.clear();
+
+	mPushing = false;
+	mPushStarted = false;
+	mPushScanned = 0;
+	mPushQuote = 0;
 }
 
 void XMLSAXSimple::ParseData(const char* data)
 {
+	XMLStatsScope stats(mStats);
+	XMLLIB_STATS_TIMER(eTimerParse);
+
 	mBuffer.SetData(data);
 	ParseIt();
 }
 
 void XMLSAXSimple::ParseFile(const char* file)
 {
+	XMLStatsScope stats(mStats);
+	XMLLIB_STATS_TIMER(eTimerParse);
+
+	// Regular files are parsed in place from mapped memory
+	if (mBuffer.SetFile(file))
+	{
+		ParseIt();
+		mBuffer.Close();
+		return;
+	}
+
+	// Fall back to reading through a stream for anything that cannot be mapped
 	std::ifstream fin(file);
 	if (fin.fail())
 		return;
@@ -53,6 +92,9 @@ void XMLSAXSimple::ParseStream(std::istream& is)
 	if (is.fail())
 		return;
 
+	XMLStatsScope stats(mStats);
+	XMLLIB_STATS_TIMER(eTimerParse);
+
 	mBuffer.SetStream(is);
 	ParseIt();
 }
@@ -62,126 +104,314 @@ void XMLSAXSimple::ParseIt()
 	// Always skip whitespace before the first real data
 	SkipWS();
 
-	while(!mBuffer.fail())
+	while(!mBuffer.fail() && ParseToken())
 	{
-		EXMLTag tag = GetCurrentTag();
-		
-		// If error then end document
-		if (mBuffer.fail())
+	}
+}
+
+bool XMLSAXSimple::ParseToken()
+{
+	EXMLTag tag = GetCurrentTag();
+	
+	// If error then end document
+	if (mBuffer.fail())
+	{
+		// End document if it was started
+		if (mDocument != NULL)
+			EndDocument();
+		return false;
+	}
+
+	switch(tag)
+	{
+	case TAG_NONE:
+		// Have character data - parse as much as possible
+		ParseCharacters();
+		break;
+	
+	case TAG_CDATA:
+		// Have character data - parse into character buffer
+		ParseCDATA();
+		break;
+	
+	case TAG_DOCTYPE:
+		if (!ParseDoctype())
 		{
-			// End document if it was started
-			if (mDocument != NULL)
-				EndDocument();
-			return;
+			FatalError("Could not parse <!DOCTYPE ... >");
+			return false;
 		}
-
-		switch(tag)
+		break;
+	
+	case TAG_DECLARATION:
+		if (!ParseDeclaration())
 		{
-		case TAG_NONE:
-			// Have character data - parse as much as possible
-			ParseCharacters();
-			break;
-		
-		case TAG_CDATA:
-			// Have character data - parse into character buffer
-			ParseCDATA();
-			break;
+			FatalError("Could not parse <?xml ... ?>");
+			return false;
+		}
 		
-		case TAG_DOCTYPE:
-			if (!ParseDoctype())
-			{
-				FatalError("Could not parse <!DOCTYPE ... >");
-				return;
-			}
-			break;
+		// If we have a declaration we are at the start of the document - but check we
+		// only do this once
+		if (mDocument != NULL)
+		{
+			FatalError("Multiple declarations");
+			return false;
+		}
 		
-		case TAG_DECLARATION:
-			if (!ParseDeclaration())
-			{
-				FatalError("Could not parse <?xml ... ?>");
-				return;
-			}
-			
-			// If we have a declaration we are at the start of the document - but check we
-			// only do this once
-			if (mDocument != NULL)
-			{
-				FatalError("Multiple declarations");
-				return;
-			}
-			
-			// Now do start callback
-			StartDocument();
-			break;
+		// Now do start callback
+		StartDocument();
+		break;
 
-		case TAG_COMMENT:
-			if (!ParseComment())
-			{
-				FatalError("Could not parse comment");
-				return;
-			}
+	case TAG_COMMENT:
+		if (!ParseComment())
+		{
+			FatalError("Could not parse comment");
+			return false;
+		}
+		break;
+
+	case TAG_PROCESSING:
+		if (!ParseProcessing())
+		{
+			FatalError("Could not parse processing");
+			return false;
+		}
+		break;
+
+	case TAG_ELEMENT_END:
+		if (!ParseElementEnd())
+		{
+			FatalError("Could not parse element");
+			return false;
+		}
+		break;
+
+	case TAG_ELEMENT:
+		if (!ParseElement())
+		{
+			FatalError("Could not parse element");
+			return false;
+		}
+		break;
+	}
+
+	return true;
+}
+
+bool XMLSAXSimple::Feed(const char* data, size_t length)
+{
+	XMLStatsScope stats(mStats);
+	XMLLIB_STATS_TIMER(eTimerParse);
+
+	// First piece of a new document
+	if (!mPushing)
+	{
+		mBuffer.SetPush();
+		mPushing = true;
+		mPushStarted = false;
+		mPushScanned = 0;
+		mPushQuote = 0;
+	}
+
+	// Pieces too large for the buffer's 32-bit offsets are pushed in parts
+	while(length != 0)
+	{
+		uint32_t piece = (length > 0x40000000) ? 0x40000000 : (uint32_t)length;
+		if (!mBuffer.Push(data, piece))
+		{
+			FatalError("Unparsed data too large");
 			break;
+		}
+		data += piece;
+		length -= piece;
 
-		case TAG_PROCESSING:
-			if (!ParseProcessing())
-			{
-				FatalError("Could not parse processing");
-				return;
-			}
+		ParsePushed(false);
+	}
+
+	return !mError;
+}
+
+bool XMLSAXSimple::Finish()
+{
+	// Whatever is left is parsed as it is, just as at the end of fixed data
+	if (mPushing)
+	{
+		XMLStatsScope stats(mStats);
+		XMLLIB_STATS_TIMER(eTimerParse);
+
+		ParsePushed(true);
+		mPushing = false;
+	}
+
+	return !mError;
+}
+
+// Only complete tokens are handed to the regular parsing code, which then never reaches the
+// end of the buffer part way through a token
+void XMLSAXSimple::ParsePushed(bool final)
+{
+	while(!mError && (mBuffer.Remaining() != 0))
+	{
+		// Skip whitespace before the first real data, as ParseIt does
+		if (!mPushStarted)
+		{
+			while((mBuffer.Remaining() != 0) && isspace(*mBuffer.next()))
+				mBuffer += 1;
+			if (mBuffer.Remaining() == 0)
+				break;
+			mPushStarted = true;
+		}
+
+		if (!PushTokenComplete() && !final)
 			break;
+		mPushScanned = 0;
+		mPushQuote = 0;
 
-		case TAG_ELEMENT_END:
-			if (!ParseElementEnd())
-			{
-				FatalError("Could not parse element");
-				return;
-			}
+		if (!ParseToken() || mBuffer.fail())
 			break;
+	}
+}
 
-		case TAG_ELEMENT:
-			if (!ParseElement())
-			{
-				FatalError("Could not parse element");
-				return;
-			}
+// Whether all of the token at the front of the buffer has been fed. The scan resumes where
+// the previous one stopped, so each byte is only looked at once however it is split.
+bool XMLSAXSimple::PushTokenComplete()
+{
+	const char* p = mBuffer.next();
+	uint32_t length = mBuffer.Remaining();
+
+	// Character data runs up to the next tag
+	if (*p != '<')
+		return PushFind(p, length, 1, "<", 1);
+
+	// Need enough to tell which kind of tag this is - in the order GetCurrentTag tests them
+	struct STagStart
+	{
+		const char*		mStart;
+		uint32_t		mLength;
+		EXMLTag			mTag;
+	};
+	static const STagStart cTagStart[] =
+	{
+		{ "<![CDATA[", 9, TAG_CDATA },
+		{ "<!DOCTYPE", 9, TAG_DOCTYPE },
+		{ "<?xml", 5, TAG_DECLARATION },
+		{ "<!--", 4, TAG_COMMENT },
+		{ "<?", 2, TAG_PROCESSING },
+		{ "</", 2, TAG_ELEMENT_END }
+	};
+	EXMLTag tag = TAG_ELEMENT;
+	uint32_t start = 1;
+	for(uint32_t i = 0; i < sizeof(cTagStart) / sizeof(cTagStart[0]); i++)
+	{
+		uint32_t compare = (length < cTagStart[i].mLength) ? length : cTagStart[i].mLength;
+		if (::memcmp(p, cTagStart[i].mStart, compare) == 0)
+		{
+			if (compare < cTagStart[i].mLength)
+				return false;
+			tag = cTagStart[i].mTag;
+			start = cTagStart[i].mLength;
 			break;
 		}
 	}
+
+	switch(tag)
+	{
+	case TAG_CDATA:
+		return PushFind(p, length, start, "]]>", 3);
+	case TAG_COMMENT:
+		return PushFind(p, length, start, "-->", 3);
+	case TAG_DECLARATION:
+	case TAG_PROCESSING:
+		// Ends with '?' and the character after it
+		return PushFind(p, length, start, "?", 2);
+	case TAG_DOCTYPE:
+	case TAG_ELEMENT_END:
+		return PushFind(p, length, start, ">", 1);
+	default:
+		break;
+	}
+
+	// Element start ends at the first '>' outside an attribute value
+	const char* q = p + ((mPushScanned > start) ? mPushScanned : start);
+	const char* end = p + length;
+	while(q < end)
+	{
+		if (mPushQuote != 0)
+		{
+			q = XMLScan(q, end, mPushQuote);
+			if (q == end)
+				break;
+			mPushQuote = 0;
+			q++;
+		}
+		else
+		{
+			q = XMLScan(q, end, '>', '"', '\'');
+			if (q == end)
+				break;
+			if (*q == '>')
+				return true;
+			mPushQuote = *q++;
+		}
+	}
+
+	mPushScanned = length;
+	return false;
+}
+
+// Look for the terminating sequence from start - only its first character is compared
+// when the sequence is shorter than end_length, which then just needs that many bytes
+bool XMLSAXSimple::PushFind(const char* p, uint32_t length, uint32_t start, const char* end, uint32_t end_length)
+{
+	uint32_t compare = ::strlen(end);
+	const char* q = p + ((mPushScanned > start) ? mPushScanned : start);
+	const char* last = p + length;
+	for(q = XMLScan(q, last, end[0]); q != last; q = XMLScan(q + 1, last, end[0]))
+	{
+		// Not enough yet to tell - check again from here next time
+		if ((uint32_t)(last - q) < end_length)
+		{
+			mPushScanned = q - p;
+			return false;
+		}
+		if (::memcmp(q, end, compare) == 0)
+			return true;
+	}
+
+	mPushScanned = length;
+	return false;
 }
 
 XMLSAXSimple::EXMLTag XMLSAXSimple::GetCurrentTag()
 {
 	EXMLTag tag = TAG_NONE;
 
-	// Need up to 9 characters worth in the buffer
-	mBuffer.NeedData(9);
-
-	if (::strncmp(mBuffer.next(), "<![CDATA[", 9) == 0)
+	// Compare without reading past the end of the data - mapped files are not NUL terminated
+	if (mBuffer.StartsWith("<![CDATA[", 9))
 	{
 		tag = TAG_CDATA;
 		mBuffer += 9;
 	}
-	else if (::strncmp(mBuffer.next(), "<!DOCTYPE", 9) == 0)
+	else if (mBuffer.StartsWith("<!DOCTYPE", 9))
 	{
 		tag = TAG_DOCTYPE;
 		mBuffer += 9;
 	}
-	else if (::strncmp(mBuffer.next(), "<?xml", 5) == 0)
+	else if (mBuffer.StartsWith("<?xml", 5))
 	{
 		tag = TAG_DECLARATION;
 		mBuffer += 5;
 	}
-	else if (::strncmp(mBuffer.next(), "<!--", 4) == 0)
+	else if (mBuffer.StartsWith("<!--", 4))
 	{
 		tag = TAG_COMMENT;
 		mBuffer += 4;
 	}
-	else if (::strncmp(mBuffer.next(), "<?", 2) == 0)
+	else if (mBuffer.StartsWith("<?", 2))
 	{
 		tag = TAG_PROCESSING;
 		mBuffer += 2;
 	}
-	else if (::strncmp(mBuffer.next(), "</", 2) == 0)
+	else if (mBuffer.StartsWith("</", 2))
 	{
 		tag = TAG_ELEMENT_END;
 		mBuffer += 2;
@@ -194,22 +424,35 @@ XMLSAXSimple::EXMLTag XMLSAXSimple::GetCurrentTag()
 	return tag;
 }
 
+// Whitespace test table
+static inline bool IsXMLSpace(char c)
+{
+	return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r');
+}
+
 void XMLSAXSimple::SkipWS()
 {
-	// Skip over each whitespace character
-	while(!mBuffer.fail() && isspace(*mBuffer))
-		mBuffer++;
+	// Skip over whitespace directly in the buffer, refilling as needed
+	while(mBuffer.Fill())
+	{
+		const char* p = mBuffer.next();
+		const char* end = p + mBuffer.Remaining();
+		const char* q = p;
+		while((q < end) && isspace(*q))
+			q++;
+		mBuffer += q - p;
+		if (q < end)
+			break;
+	}
 }
 
 bool XMLSAXSimple::ParseDoctype()
 {
 	// Look for ending '>'
-	while(!mBuffer.fail() && (*mBuffer != '>'))
-		mBuffer++;
+	if (!mBuffer.SkipTo('>'))
+		return false;
 	
 	// Punt over '>'
-	if (mBuffer.fail())
-		return false;
 	mBuffer++;
 
 	return true;
@@ -218,12 +461,10 @@ bool XMLSAXSimple::ParseDoctype()
 bool XMLSAXSimple::ParseDeclaration()
 {
 	// Get first '?'
-	while(!mBuffer.fail() && (*mBuffer != '?'))
-		mBuffer++;
+	if (!mBuffer.SkipTo('?'))
+		return false;
 	
 	// Punt over '?'
-	if (mBuffer.fail())
-		return false;
 	mBuffer++;
 
 	// Punt over '>'
@@ -236,35 +477,19 @@ bool XMLSAXSimple::ParseDeclaration()
 
 bool XMLSAXSimple::ParseComment()
 {
-	while(!mBuffer.fail())
+	// Look for each '-' and test for "-->"
+	while(mBuffer.SkipTo('-'))
 	{
-		// Get first '-'
-		while(!mBuffer.fail() && (*mBuffer != '-'))
-			mBuffer++;
-		
-		// Punt over '-'
-		if (mBuffer.fail())
-			return false;
-		mBuffer++;
-
-		// Punt over '-'
-		if (mBuffer.fail())
-			return false;
-
-		// Look for second '-'
-		if (*mBuffer == '-')
+		mBuffer.NeedData(3);
+		if ((mBuffer.Remaining() >= 3) && (mBuffer.next()[1] == '-') && (mBuffer.next()[2] == '>'))
 		{
-			// Punt over '-'
-			mBuffer++;
-
-			// Punt over '-'
-			if (mBuffer.fail())
-				return false;
-
-			// Look for second '>'
-			if (*mBuffer == '>')
-				return true;
+			// Punt over "-->"
+			mBuffer += 3;
+			return true;
 		}
+
+		// Punt over '-'
+		mBuffer += 1;
 	}
 	
 	return false;
@@ -273,12 +498,10 @@ bool XMLSAXSimple::ParseComment()
 bool XMLSAXSimple::ParseProcessing()
 {
 	// Get first '?'
-	while(!mBuffer.fail() && (*mBuffer != '?'))
-		mBuffer++;
+	if (!mBuffer.SkipTo('?'))
+		return false;
 	
 	// Punt over '?'
-	if (mBuffer.fail())
-		return false;
 	mBuffer++;
 
 	// Punt over '>'
@@ -305,70 +528,97 @@ char cValidElementName[256] =
 	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 	// 0xF0 - 0xFF 
 };
 
-const size_t cBufSize = 256;
-
-bool XMLSAXSimple::ParseName(cdstring& name)
+bool XMLSAXSimple::ParseName(XMLStringView& name)
 {
-	// Get element name
-	cdstring buffer;
-	buffer.reserve(cBufSize);
-	char* p = buffer.c_str_mod();
-	unsigned long ctr = 0;
-	while(!mBuffer.fail() && (cValidElementName[(unsigned char)*mBuffer] == 0x01))
-	{
-		*p++ = *mBuffer++;
-		if (++ctr == cBufSize)
-		{
-			name.append(buffer, 0, ctr);
-			p = buffer.c_str_mod();
-			ctr = 0;
-		}
+	// Scan name characters directly in the buffer
+	bool fixed = mBuffer.IsFixed();
+	const char* start = mBuffer.next();
+	if (!fixed)
+		mToken.clear();
+	while(mBuffer.Fill())
+	{
+		const char* p = mBuffer.next();
+		const char* end = p + mBuffer.Remaining();
+		const char* q = p;
+		while((q < end) && (cValidElementName[(unsigned char)*q] == 0x01))
+			q++;
+
+		// Copy out when the buffer may be refilled under us
+		if (!fixed)
+			mToken.append(p, q - p);
+		mBuffer += q - p;
+		if (q < end)
+			break;
 	}
 
-	// Write remainder from buffer
-	name.append(buffer, 0, ctr);
+	// Fixed buffers are referenced directly, otherwise use scratch storage
+	if (fixed)
+		name = XMLStringView(start, mBuffer.next() - start);
+	else
+		name = XMLStringView(mScratch.Copy(mToken.c_str(), mToken.length()), mToken.length());
 	
 	return !mBuffer.fail();
 }
 
-bool XMLSAXSimple::ParseAttributeValue(cdstring& value)
+bool XMLSAXSimple::ParseAttributeValue(XMLStringView& value)
 {
 	// Character to match at the end
 	char match = *mBuffer++;
 
-	// Get attribute text
-	cdstring buffer;
-	buffer.reserve(cBufSize);
-	char* p = buffer.c_str_mod();
-	unsigned long ctr = 0;
-	while(!mBuffer.fail() && (*mBuffer != match))
+	// Get attribute text - stopping at entities just to note them
+	bool fixed = mBuffer.IsFixed();
+	const char* start = mBuffer.next();
+	bool has_entity = false;
+	if (!fixed)
+		mToken.clear();
+	while(mBuffer.Fill())
 	{
-		*p++ = *mBuffer++;
-		if (++ctr == cBufSize)
+		uint32_t span = mBuffer.Span(match, '&');
+		bool found = (span < mBuffer.Remaining());
+		if (found && (mBuffer.next()[span] == '&'))
 		{
-			value.append(buffer, 0, ctr);
-			p = buffer.c_str_mod();
-			ctr = 0;
+			has_entity = true;
+			span++;
+			found = false;
 		}
+
+		if (!fixed)
+			mToken.append(mBuffer.next(), span);
+		mBuffer += span;
+		if (found)
+			break;
 	}
-	
-	// Write remainder from buffer
-	value.append(buffer, 0, ctr);
-	
+	size_t length = fixed ? (size_t)(mBuffer.next() - start) : mToken.length();
+	if (!fixed)
+		start = mToken.c_str();
+
 	// Punt over matching end character
 	if (!mBuffer.fail())
 		mBuffer++;
 	
-	// Must decode common entities
-	XMLDecode(value);
+	// Must decode common entities - decoded straight into storage owned by the parser
+	if (has_entity)
+	{
+		char* decoded = static_cast<char*>(mScratch.Allocate(length + 1));
+		size_t decoded_length = XMLDecodeEntities(start, length, decoded);
+		decoded[decoded_length] = 0;
+		value = XMLStringView(decoded, decoded_length);
+	}
+	else if (fixed)
+		value = XMLStringView(start, length);
+	else
+		value = XMLStringView(mScratch.Copy(start, length), length);
 
 	return !mBuffer.fail();
 }
 
 bool XMLSAXSimple::ParseElement()
 {
+	// Names and attributes from the previous tag are no longer needed
+	ClearAttributes();
+
 	// Get element name
-	cdstring name;
+	XMLStringView name;
 	if (!ParseName(name))
 	{
 		FatalError("Could not parse element name");
@@ -379,11 +629,10 @@ bool XMLSAXSimple::ParseElement()
 	SkipWS();
 	
 	// Look for attribute or end of tag
-	XMLAttributeList attribs;
 	while(!mBuffer.fail() && (*mBuffer != '/') && (*mBuffer != '>'))
 	{
 		// Get attribute name
-		cdstring aname;
+		XMLStringView aname;
 		if (!ParseName(aname))
 		{
 			FatalError("Could not parse attribute name");
@@ -398,7 +647,7 @@ bool XMLSAXSimple::ParseElement()
 		}
 
 		// Get attribute value
-		cdstring avalue;
+		XMLStringView avalue;
 		if (!ParseAttributeValue(avalue))
 		{
 			FatalError("Could not parse attribute name");
@@ -406,12 +655,15 @@ bool XMLSAXSimple::ParseElement()
 		}
 
 		// Now add attribute to list
-		attribs.push_back(new XMLAttribute(aname, avalue));
+		mAttributes.push_back(XMLAttributeView(aname, avalue));
 
 		// Skip ws
 		SkipWS();
 	}
 	
+	XMLLIB_STATS_COUNT(eElements, 1);
+	XMLLIB_STATS_COUNT(eAttributes, mAttributes.size());
+
 	// See what is next
 	if (*mBuffer == '/')
 	{
@@ -421,8 +673,8 @@ bool XMLSAXSimple::ParseElement()
 
 		if (!mBuffer.fail() && *mBuffer++ == '>')
 		{
-			StartElement(name, attribs);
-			EndElement(name);
+			StartElementView(name, mAttributes);
+			EndElementView(name);
 			return true;
 		}
 		else
@@ -438,7 +690,7 @@ bool XMLSAXSimple::ParseElement()
 			mBuffer++;
 
 		// We have an element
-		StartElement(name, attribs);
+		StartElementView(name, mAttributes);
 		return true;
 	}
 	
@@ -449,8 +701,10 @@ bool XMLSAXSimple::ParseElement()
 
 bool XMLSAXSimple::ParseElementEnd()
 {	
+	ClearAttributes();
+
 	// Get element name
-	cdstring name;
+	XMLStringView name;
 	if (!ParseName(name))
 	{
 		FatalError("Could not parse element name");
@@ -461,7 +715,7 @@ bool XMLSAXSimple::ParseElementEnd()
 	SkipWS();
 	
 	// Check for and punt '>'
-	if(mBuffer.fail() && (*mBuffer != '>'))
+	if (mBuffer.fail() || (*mBuffer != '>'))
 	{
 		FatalError("Could not parse element end");
 		return false;
@@ -469,152 +723,274 @@ bool XMLSAXSimple::ParseElementEnd()
 	mBuffer++;
 
 	// We have an element end
-	EndElement(name);
+	EndElementView(name);
 	return true;
 }
 
 bool XMLSAXSimple::ParseCharacters()
 {
-	// Read legal characters
-	std::ostrstream data;
+	// Read legal characters in bulk up to the next tag, stopping at entities just to note them
+	bool fixed = mBuffer.IsFixed();
+	const char* start = mBuffer.next();
 	bool only_whitespace = true;
-	while(!mBuffer.fail() && (*mBuffer != '<'))
+	bool has_entity = false;
+	if (!fixed)
+		mText.clear();
+	while(mBuffer.Fill())
 	{
-		// Look for entity
-		if (*mBuffer == '&')
+		const char* p = mBuffer.next();
+		uint32_t span = mBuffer.Span('<', '&');
+		bool found = (span < mBuffer.Remaining());
+
+		// Do whitespace test only if still required
+		for(const char* q = p; only_whitespace && (q < p + span); q++)
+			only_whitespace = IsXMLSpace(*q);
+
+		if (found && (p[span] == '&'))
 		{
 			only_whitespace = false;
-			mBuffer++;
-			cdstring amp;
-			while(!mBuffer.fail() && (*mBuffer != ';'))
-			{
-				amp += *mBuffer++;
-			}
-			if (!mBuffer.fail())
-				mBuffer++;
-			if (amp[(cdstring::size_type)0] == '#')
-			{
-				unsigned long decoded = 0;
-				if (amp[(cdstring::size_type)1] == 'x')
-				{
-					decoded = std::strtoul(&amp[(cdstring::size_type)2], NULL, 16);
-				}
-				else
-				{
-					decoded = std::strtoul(&amp[(cdstring::size_type)1], NULL, 10);
-				}
-				
-				// Must be less than or equal to 0xFF for utf8
-				if (decoded < 0x100)
-					data.put((char)decoded);
-			}
-			else if (amp.compare("amp", true) == 0)
-				data.put('&');
-			else if (amp.compare("lt", true) == 0)
-				data.put('<');
-			else if (amp.compare("gt", true) == 0)
-				data.put('>');
-			else if (amp.compare("apos", true) == 0)
-				data.put('\'');
-			else if (amp.compare("quote", true) == 0)
-				data.put('"');
-		}
-		else
-		{
-			char c = *mBuffer++;
-			
-			// Do whitespace test only if still required
-			if (only_whitespace)
-			{
-				switch(c)
-				{
-				case '\t':
-				case '\r':
-				case '\n':
-				case ' ':
-					break;
-				default:
-					only_whitespace = false;
-					break;
-				}
-			}
-			
-			// Write data
-			data.put(c);
+			has_entity = true;
+			span++;
+			found = false;
 		}
+		
+		// Copy data when the buffer may be refilled
+		if (!fixed)
+			mText.insert(mText.end(), p, p + span);
+		mBuffer += span;
+		if (found)
+			break;
 	}
-	
-	// Grab the data
-	data << std::ends;
-	cdstring temp;
-	temp.steal(data.str());
 
 	// Now do callback if data contains more than just whitespace
 	if (!only_whitespace)
-		Characters(temp);
+	{
+		XMLLIB_STATS_COUNT(eTextRuns, 1);
+		size_t length = fixed ? (size_t)(mBuffer.next() - start) : mText.size();
+		if (has_entity)
+		{
+			// Fixed data is decoded into a copy, text already copied is decoded where it is
+			if (fixed)
+				mText.resize(length);
+			length = XMLDecodeEntities(fixed ? start : &mText[0], length, &mText[0]);
+			CharactersView(XMLStringView(&mText[0], length));
+		}
+		else
+			CharactersView(XMLStringView(fixed ? start : &mText[0], length));
+	}
 
 	return !mBuffer.fail();
 }
 
 bool XMLSAXSimple::ParseCDATA()
 {
-	// Read legal characters
-	std::ostrstream data;
-	while(!mBuffer.fail())
+	// Read legal characters in bulk up to each ']'
+	bool fixed = mBuffer.IsFixed();
+	const char* start = mBuffer.next();
+	const char* end = NULL;
+	if (!fixed)
+		mToken.clear();
+	while(mBuffer.Fill())
 	{
-		// Look for entity
-		if (*mBuffer == ']')
+		uint32_t span = mBuffer.Span(']');
+		if (!fixed)
+			mToken.append(mBuffer.next(), span);
+		mBuffer += span;
+		if (mBuffer.Remaining() == 0)
+			continue;
+
+		// Look for ']]>' termination
+		mBuffer.NeedData(3);
+		if ((mBuffer.Remaining() >= 3) && (mBuffer.next()[1] == ']') && (mBuffer.next()[2] == '>'))
 		{
-			// Look for ']]>' termination
-			mBuffer.NeedData(3);
-			if ((mBuffer.next()[1] == ']') && (mBuffer.next()[2] == '>'))
-			{
-				mBuffer += 3;
-				break;				
-			}
+			end = mBuffer.next();
+			mBuffer += 3;
+			break;
 		}
 
-		data.put(*mBuffer++);
+		// Plain ']'
+		if (!fixed)
+			mToken += ']';
+		mBuffer += 1;
 	}
-	
-	// Grab the data
-	data << std::ends;
-	cdstring temp;
-	temp.steal(data.str());
+	if (end == NULL)
+		end = mBuffer.next();
 
 	// Now do callback
-	Characters(temp);
+	XMLLIB_STATS_COUNT(eTextRuns, 1);
+	if (fixed)
+		CharactersView(XMLStringView(start, end - start));
+	else
+		CharactersView(XMLStringView(mToken));
 	
 	// Punt oive
 	return !mBuffer.fail();
 }
 
-void XMLSAXSimple::XMLDecode(cdstring& value)
+void XMLSAXSimple::ClearAttributes()
 {
-	// Look for any entities
-	if (value.find('&') == std::string::npos)
+	// Views into the scratch arena are dead once the next tag starts
+	mAttributes.clear();
+	mScratch.Reset();
+}
+
+// Large enough that starting a thread for each chunk costs next to nothing
+const uint32_t cParallelChunkSize = 4 * 1024 * 1024;
+
+void XMLSAXSimple::ParseDataParallel(const char* data, uint32_t threads)
+{
+	XMLStatsScope stats(mStats);
+	XMLLIB_STATS_TIMER(eTimerParse);
+
+	mBuffer.SetData(data);
+	ParseParallel(threads);
+}
+
+void XMLSAXSimple::ParseFileParallel(const char* file, uint32_t threads)
+{
+	// Only mapped files can be split up
+	if (!mBuffer.SetFile(file))
+	{
+		ParseFile(file);
 		return;
-	
-	std::ostrstream data;
-	std::string::size_type start_pos = 0;
-	std::string::size_type end_pos = value.find('&', start_pos);
-	while(end_pos != std::string::npos)
+	}
+
+	XMLStatsScope stats(mStats);
+	XMLLIB_STATS_TIMER(eTimerParse);
+
+	ParseParallel(threads);
+	mBuffer.Close();
+}
+
+// The first '<' that could start a tag - one inside a comment, CDATA or attribute value is
+// only found out when the chunk before it ends somewhere else
+static const char* FindTagStart(const char* p, const char* end)
+{
+	for(p = XMLScan(p, end, '<'); p != end; p = XMLScan(p + 1, end, '<'))
 	{
-		// Copy up to the current position
-		data.write(value.c_str() + start_pos, end_pos - start_pos);
-		
-		// Now do entity lookup
-		
-		// Adjust pointers and do another search
-		start_pos = end_pos;
-		end_pos = value.find('&', start_pos);
+		if (p + 1 == end)
+			break;
+		char c = p[1];
+		if ((cValidElementName[(unsigned char)c] == 0x01) || (c == '/') || (c == '!') || (c == '?'))
+			return p;
 	}
-	
-	// Write out the remainder
-	if (start_pos < value.length())
-		data.write(value.c_str() + start_pos, value.length() - start_pos);
-	
-	// Grab the data
-	data << std::ends;
-	value.steal(data.str());
+
+	return end;
+}
+
+// Chunks are tokenised by as many threads at a time as asked for, each chunk starting as
+// soon as the one that was using its slot has been replayed
+void XMLSAXSimple::ParseParallel(uint32_t threads)
+{
+	if (threads == 0)
+		threads = XMLThread::Processors();
+
+	// Not worth splitting up
+	const char* data = mBuffer.next();
+	uint32_t length = mBuffer.Remaining();
+	uint32_t count = length / cParallelChunkSize + ((length % cParallelChunkSize) ? 1 : 0);
+	if ((threads < 2) || (count < 2))
+	{
+		ParseIt();
+		return;
+	}
+
+	if (threads > count)
+		threads = count;
+	while(mChunks.size() < threads)
+		mChunks.push_back(new XMLSAXChunk);
+
+	const char* end = data + length;
+	const char* expected = data;
+	uint32_t started = 0;
+	try
+	{
+		for(uint32_t replayed = 0; replayed < count; replayed++)
+		{
+			for(; (started < count) && (started < replayed + threads); started++)
+			{
+				const char* start = data + started * cParallelChunkSize;
+				const char* limit = (started + 1 < count) ? start + cParallelChunkSize : NULL;
+				if (started != 0)
+					start = FindTagStart(start, (limit != NULL) ? limit : end);
+				mChunks[started % threads]->Set(start, limit, end, started == 0);
+				mChunks[started % threads]->StartTokenise();
+			}
+
+			// Tokenise again from where the previous chunk really ended if the guess was wrong
+			XMLSAXChunk& chunk = *mChunks[replayed % threads];
+			chunk.Join();
+			if (!chunk.Tokenised() || (chunk.Start() != expected))
+			{
+				chunk.Set(expected, chunk.Limit(), end, replayed == 0);
+				chunk.Tokenise();
+			}
+
+			// What tokenising counted on the chunk's thread
+			mStats.Add(chunk.Stats());
+
+			if (!Replay(chunk))
+				break;
+			expected = chunk.End();
+		}
+	}
+	catch(...)
+	{
+		for(uint32_t i = 0; i < threads; i++)
+			mChunks[i]->Join();
+		throw;
+	}
+
+	// Chunks after the end of parsing may still be running
+	for(uint32_t i = 0; i < threads; i++)
+		mChunks[i]->Join();
+}
+
+// Make the recorded callbacks, with the checks that need the document state done as
+// ParseToken does them. Returns false once parsing has ended.
+bool XMLSAXSimple::Replay(const XMLSAXChunk& chunk)
+{
+	const std::vector<XMLSAXChunk::SEvent>& events = chunk.Events();
+	for(std::vector<XMLSAXChunk::SEvent>::const_iterator iter = events.begin(); iter != events.end(); iter++)
+	{
+		switch((*iter).mType)
+		{
+		case XMLSAXChunk::eStartDocument:
+			if (mDocument != NULL)
+			{
+				FatalError("Multiple declarations");
+				return false;
+			}
+			StartDocument();
+			break;
+
+		case XMLSAXChunk::eEndDocument:
+			if (mDocument != NULL)
+				EndDocument();
+			break;
+
+		case XMLSAXChunk::eStartElement:
+		{
+			ClearAttributes();
+			const XMLAttributeView* attributes = chunk.Attributes(*iter);
+			mAttributes.assign(attributes, attributes + (*iter).mCount);
+			StartElementView((*iter).mText, mAttributes);
+			break;
+		}
+
+		case XMLSAXChunk::eEndElement:
+			EndElementView((*iter).mText);
+			break;
+
+		case XMLSAXChunk::eCharacters:
+			CharactersView((*iter).mText);
+			break;
+
+		case XMLSAXChunk::eFatalError:
+			FatalError((*iter).mText.ToString());
+			break;
+		}
+	}
+
+	return !chunk.Stopped();
 }
@@ -23,11 +23,13 @@
 
 #include "CStreamBuffer.h"
 
-#include <sstream>
+#include <vector>
 
 namespace xmllib
 {
 
+class XMLSAXChunk;
+
 class XMLSAXSimple : public XMLParserSAX
 {
 public:
@@ -38,9 +40,40 @@ public:
 	virtual void ParseFile(const char* filename);
 	virtual void ParseStream(std::istream& is);
 
+	// Incremental parsing - feed the document in pieces of any size as they arrive, then call
+	// Finish once at the end. Each token is parsed as soon as all of it has been fed, so only
+	// the incomplete token at the end is held back. Both return false once there is an error.
+	bool Feed(const char* data, size_t length);
+	bool Finish();
+
+	// Starting and largest sizes of the buffer for streams and fed data - a buffer only grows
+	// when a token needs more of it at once, and fed data fails to parse if a token needs more
+	// than the largest size. Kept across Reset.
+	void SetBufferSize(uint32_t initial, uint32_t maximum)
+	{
+		mBuffer.SetBufferSize(initial, maximum);
+	}
+
+	// Parallel parsing of a document in memory or a file that can be mapped. The data is cut
+	// into chunks, each tokenised on its own thread from the first likely tag in it. The chunks
+	// are then replayed in order, and a chunk that did not start where the one before it
+	// really ended is tokenised again first, so the callbacks and document are exactly those
+	// of ParseData. Defaults to one thread per processor. Buffer offsets are 32-bit, so files
+	// of 4GB or more cannot be mapped and are parsed from a stream on one thread, as are
+	// files that are not regular files.
+	void ParseDataParallel(const char* data, uint32_t threads = 0);
+	void ParseFileParallel(const char* filename, uint32_t threads = 0);
+
+	virtual void Reset();
+
 protected:
 	CStreamBuffer	mBuffer;
 
+	// Parse the token at the current position - false at the end or on error
+	bool ParseToken();
+
+	void SkipWS();
+
 private:
 	enum EXMLTag
 	{
@@ -54,10 +87,27 @@ private:
 		TAG_ELEMENT
 	};
 
-	std::ostringstream	mChars;
+	XMLAttributeViewList	mAttributes;		// Attributes of the current tag
+	cdstring				mToken;				// Raw token copied out of a refillable buffer
+	std::vector<char>		mText;				// Text copied out of a refillable buffer or decoded
+
+	// Push parsing state for the token at the front of the buffer
+	bool					mPushing;
+	bool					mPushStarted;		// Leading whitespace has been skipped
+	uint32_t				mPushScanned;		// Bytes of the token already scanned for its end
+	char					mPushQuote;			// Quote open at the end of the scan in a tag
+
+	std::vector<XMLSAXChunk*>	mChunks;			// Kept for reuse by parallel parsing
 
 	// Actually parsing
 	void ParseIt();
+
+	void ParsePushed(bool final);
+	bool PushTokenComplete();
+	bool PushFind(const char* p, uint32_t length, uint32_t start, const char* end, uint32_t end_length);
+
+	void ParseParallel(uint32_t threads);
+	bool Replay(const XMLSAXChunk& chunk);
 	
 	bool ParseDoctype();
 	bool ParseDeclaration();
@@ -69,14 +119,12 @@ private:
 	bool ParseCharacters();
 	bool ParseCDATA();
 
-	bool ParseName(cdstring& name);
-	bool ParseAttributeValue(cdstring& value);
+	bool ParseName(XMLStringView& name);
+	bool ParseAttributeValue(XMLStringView& value);
 
-	void XMLDecode(cdstring& value);
+	void ClearAttributes();
 
 	EXMLTag GetCurrentTag();
-	
-	void SkipWS();
 };
 
 }
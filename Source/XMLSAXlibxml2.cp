@@ -18,16 +18,27 @@
 
 #include "XMLSAXlibxml2.h"
 
+#include "XMLEntities.h"
+
 #include <libxml/parserInternals.h>
 
+#include <climits>
 #include <cstdarg>
+#include <cstring>
 #include <strstream>
 
 using namespace xmllib;
 
+// Blank text is dropped as xmlKeepBlanksDefault(0) used to do
+const int cParseOptions = XML_PARSE_NOBLANKS;
+
+// Largest piece libxml2 takes at once
+const size_t cMaxChunk = 1024 * 1024 * 1024;
+
 XMLSAXlibxml2::XMLSAXlibxml2()
 {
 	mParseContext = NULL;
+	mPushing = false;
 
 	xmlSAXHandler handlers =
 	{
@@ -45,8 +56,8 @@ XMLSAXlibxml2::XMLSAXlibxml2()
 		NULL,						// setDocumentLocator
 		_StartDocument,				// startDocument
 		_EndDocument,				// endDocument
-		_StartElement,				// startElement
-		_EndElement,				// endElement
+		NULL,						// startElement
+		NULL,						// endElement
 		NULL,						// reference
 		_Characters,				// characters
 		NULL,						// ignorableWhitespace
@@ -57,7 +68,12 @@ XMLSAXlibxml2::XMLSAXlibxml2()
 		_FatalError,				// fatalError
 		NULL,						// getParameterEntity
 		NULL,						// cdataBlock
-		NULL						// externalSubset
+		NULL,						// externalSubset
+		XML_SAX2_MAGIC,				// initialized
+		NULL,						// _private
+		_StartElementNs,			// startElementNs
+		_EndElementNs,				// endElementNs
+		NULL						// serror
 	};
 	mSAXHandler = handlers;
 	
@@ -72,34 +88,134 @@ XMLSAXlibxml2::~XMLSAXlibxml2()
 
 void XMLSAXlibxml2::ParseData(const char* data)
 {
-	mParseContext = ::xmlCreateFileParserCtxt("test.xml");
-
-	mParseContext->sax = &mSAXHandler;
-	mParseContext->userData = this;
+	ParseData(data, ::strlen(data));
+}
 
-	::xmlKeepBlanksDefault(0);
+// Nothing is built by libxml2 so there is never a document to free
+void XMLSAXlibxml2::ParseData(const char* data, size_t length)
+{
+	if (length > INT_MAX)
+	{
+		mError = true;
+		return;
+	}
 
-	::xmlParseDocument(mParseContext);
+	XMLStatsScope stats(mStats);
+	XMLLIB_STATS_TIMER(eTimerParse);
 
-	mParseContext->sax = NULL;
-	::xmlFreeParserCtxt(mParseContext);
-	mParseContext = NULL;
+	if (MakeContext())
+		::xmlCtxtReadMemory(mParseContext, data, length, NULL, NULL, cParseOptions);
 }
 
 void XMLSAXlibxml2::ParseFile(const char* file)
 {
-	mParseContext = ::xmlCreateFileParserCtxt(file);
+	XMLStatsScope stats(mStats);
+	XMLLIB_STATS_TIMER(eTimerParse);
 
-	mParseContext->sax = &mSAXHandler;
-	mParseContext->userData = this;
+	if (MakeContext())
+		::xmlCtxtReadFile(mParseContext, file, NULL, cParseOptions);
+}
 
-	::xmlKeepBlanksDefault(0);
+// The first piece after a Reset or Finish starts a new document
+bool XMLSAXlibxml2::Feed(const char* data, size_t length)
+{
+	XMLStatsScope stats(mStats);
+	XMLLIB_STATS_TIMER(eTimerParse);
 
-	::xmlParseDocument(mParseContext);
+	if (!mPushing)
+	{
+		if (!MakeContext())
+			return false;
+		::xmlCtxtResetPush(mParseContext, NULL, 0, NULL, NULL);
+		::xmlCtxtUseOptions(mParseContext, cParseOptions);
+		mPushing = true;
+	}
 
-	mParseContext->sax = NULL;
-	::xmlFreeParserCtxt(mParseContext);
-	mParseContext = NULL;
+	while((length != 0) && !mError)
+	{
+		size_t piece = (length < cMaxChunk) ? length : cMaxChunk;
+		::xmlParseChunk(mParseContext, data, piece, 0);
+		data += piece;
+		length -= piece;
+	}
+
+	return !mError;
+}
+
+bool XMLSAXlibxml2::Finish()
+{
+	// Nothing fed is still an empty document
+	if (!Feed(NULL, 0))
+		return false;
+
+	XMLStatsScope stats(mStats);
+	XMLLIB_STATS_TIMER(eTimerParse);
+
+	::xmlParseChunk(mParseContext, NULL, 0, 1);
+	mPushing = false;
+
+	return !mError;
+}
+
+void XMLSAXlibxml2::Reset()
+{
+	XMLParserSAX::Reset();
+
+	mAttributes.clear();
+	mPushing = false;
+	if (mParseContext != NULL)
+		::xmlCtxtReset(mParseContext);
+}
+
+// One context does every parse - libxml2 resets it at the start of each document, keeping
+// its dictionary so names stay interned from one document to the next
+bool XMLSAXlibxml2::MakeContext()
+{
+	if (mParseContext == NULL)
+	{
+		mParseContext = ::xmlNewParserCtxt();
+		if (mParseContext == NULL)
+		{
+			mError = true;
+			return false;
+		}
+
+		// The context owns its handler so gets a copy of ours
+		*mParseContext->sax = mSAXHandler;
+		mParseContext->userData = this;
+	}
+
+	return true;
+}
+
+// Names come from libxml2's dictionary - a prefixed one is joined up in scratch storage
+XMLStringView XMLSAXlibxml2::QualifiedName(const xmlChar* prefix, const xmlChar* localname)
+{
+	const char* local = reinterpret_cast<const char*>(localname);
+	size_t local_length = ::strlen(local);
+	if (prefix == NULL)
+		return XMLStringView(local, local_length);
+
+	size_t prefix_length = ::strlen(reinterpret_cast<const char*>(prefix));
+	char* name = static_cast<char*>(mScratch.Allocate(prefix_length + local_length + 2));
+	::memcpy(name, prefix, prefix_length);
+	name[prefix_length] = ':';
+	::memcpy(name + prefix_length + 1, local, local_length + 1);
+	return XMLStringView(name, prefix_length + local_length + 1);
+}
+
+// Without entity replacement libxml2 hands over '&' in attribute values as "&#38;" and leaves
+// other references as they are, so values with any '&' are decoded into scratch storage to
+// give what XMLSAXSimple does
+XMLStringView XMLSAXlibxml2::AttributeValue(const xmlChar* value, const xmlChar* end)
+{
+	const char* p = reinterpret_cast<const char*>(value);
+	size_t length = end - value;
+	if (::memchr(p, '&', length) == NULL)
+		return XMLStringView(p, length);
+
+	char* decoded = static_cast<char*>(mScratch.Allocate(length));
+	return XMLStringView(decoded, XMLDecodeEntities(p, length, decoded));
 }
 
 void XMLSAXlibxml2::HandleException(const std::exception& ex)
@@ -146,39 +262,49 @@ void XMLSAXlibxml2::_EndDocument(void* parser)
 	}
 };
 
-void XMLSAXlibxml2::_StartElement(void* parser, const xmlChar* name, const xmlChar** p)
+void XMLSAXlibxml2::_StartElementNs(void* parser, const xmlChar* localname, const xmlChar* prefix, const xmlChar* uri,
+									int nb_namespaces, const xmlChar** namespaces,
+									int nb_attributes, int nb_defaulted, const xmlChar** attributes)
 {
 	// Get parser object
 	XMLSAXlibxml2* xmlparser = static_cast<XMLSAXlibxml2*>(parser);
 
-	// Get attributes
-	XMLAttributeList attrs;
-	if (p)
+	// Do callback method
+	try
 	{
-		for(const xmlChar** item = p; item && *item; item++)
+		// Views of the previous element are finished with
+		xmlparser->mScratch.Reset();
+		xmlparser->mAttributes.clear();
+
+		// libxml2 takes out the namespace declarations but the tree resolves prefixes from them
+		// so they are put back as attributes, ahead of the others
+		for(int i = 0; i < nb_namespaces; i++)
 		{
-			std::string name = (const char *) *item++;
-			std::string value = (const char *) *item;
+			const xmlChar* ns_prefix = namespaces[2 * i];
+			const char* ns_uri = reinterpret_cast<const char*>(namespaces[2 * i + 1]);
+			XMLStringView name = (ns_prefix != NULL) ? xmlparser->QualifiedName(BAD_CAST "xmlns", ns_prefix) : XMLStringView("xmlns", 5);
+			XMLStringView value = (ns_uri != NULL) ? XMLStringView(ns_uri, ::strlen(ns_uri)) : XMLStringView();
+			xmlparser->mAttributes.push_back(XMLAttributeView(name, value));
+		}
 
-			attrs.push_back(new XMLAttribute(name, value));
+		// Each attribute is localname, prefix, URI, value and end of value
+		for(int i = 0; i < nb_attributes; i++)
+		{
+			const xmlChar** attr = attributes + 5 * i;
+			xmlparser->mAttributes.push_back(XMLAttributeView(xmlparser->QualifiedName(attr[1], attr[0]), xmlparser->AttributeValue(attr[3], attr[4])));
 		}
-	}
 
-	// Do callback method
-	try
-	{
-		xmlparser->StartElement(std::string((const char *) name), attrs);
+		XMLLIB_STATS_COUNT(eElements, 1);
+		XMLLIB_STATS_COUNT(eAttributes, xmlparser->mAttributes.size());
+		xmlparser->StartElementView(xmlparser->QualifiedName(prefix, localname), xmlparser->mAttributes);
 	}
 	catch (const std::exception& e)
 	{
 		xmlparser->HandleException(e);
 	}
-
-	// Clean-up
-	XMLAttributeList_DeleteItems(attrs);
 };
 
-void XMLSAXlibxml2::_EndElement(void* parser, const xmlChar* name) 
+void XMLSAXlibxml2::_EndElementNs(void* parser, const xmlChar* localname, const xmlChar* prefix, const xmlChar* uri)
 {
 	// Get parser object
 	XMLSAXlibxml2* xmlparser = static_cast<XMLSAXlibxml2*>(parser);
@@ -186,7 +312,8 @@ void XMLSAXlibxml2::_EndElement(void* parser, const xmlChar* name)
 	// Do callback method
 	try
 	{
-		xmlparser->EndElement(std::string((const char *) name));
+		xmlparser->mScratch.Reset();
+		xmlparser->EndElementView(xmlparser->QualifiedName(prefix, localname));
 	}
 	catch(const std::exception& e)
 	{
@@ -202,7 +329,8 @@ void XMLSAXlibxml2::_Characters(void* parser, const xmlChar* ch, int len)
 	// Do callback method
 	try
 	{
-		xmlparser->Characters(std::string((const char *) ch, len));
+		XMLLIB_STATS_COUNT(eTextRuns, 1);
+		xmlparser->CharactersView(XMLStringView(reinterpret_cast<const char*>(ch), len));
 	}
 	catch(const std::exception& e)
 	{
@@ -35,18 +35,37 @@ public:
 	virtual void ParseData(const char* data);
 	virtual void ParseFile(const char* filename);
 
+	// Data in memory that need not be NUL terminated
+	void ParseData(const char* data, size_t length);
+
+	// Incremental parsing - feed the document in pieces of any size as they arrive, then call
+	// Finish once at the end. Both return false once there is an error.
+	bool Feed(const char* data, size_t length);
+	bool Finish();
+
+	// The parser context is kept for the next document too
+	virtual void Reset();
+
 protected:
 	virtual void HandleException(const std::exception& ex);
 
 private:
-	xmlParserCtxtPtr 	mParseContext;
+	xmlParserCtxtPtr 	mParseContext;		// Created on first use and reused after that
 	xmlSAXHandler		mSAXHandler;
+	XMLAttributeViewList	mAttributes;	// Attributes of the current element
+	bool				mPushing;
+
+	bool MakeContext();
+	XMLStringView QualifiedName(const xmlChar* prefix, const xmlChar* localname);
+	XMLStringView AttributeValue(const xmlChar* value, const xmlChar* end);
 
 	// Callbacks
 	static void _StartDocument(void* parser);
 	static void _EndDocument(void* parser);
-	static void _StartElement(void* parser, const xmlChar* name, const xmlChar** p);
-	static void _EndElement(void* parser, const xmlChar* name);
+	static void _StartElementNs(void* parser, const xmlChar* localname, const xmlChar* prefix, const xmlChar* uri,
+								int nb_namespaces, const xmlChar** namespaces,
+								int nb_attributes, int nb_defaulted, const xmlChar** attributes);
+	static void _EndElementNs(void* parser, const xmlChar* localname, const xmlChar* prefix, const xmlChar* uri);
 	static void _Characters(void* parser, const xmlChar* ch, int len);
 	static void _Comment(void* parser, const xmlChar* value);
 	static void _Warning(void* parser, const char* fmt, ...);
@@ -0,0 +1,223 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Source for delimiter scanning kernels
+
+#include "XMLScan.h"
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define XMLSCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace xmllib
+{
+
+// Scalar versions
+
+// memchr is already well optimised by the C library
+static const char* Scan1_Scalar(const char* p, const char* end, char c1)
+{
+	const char* found = static_cast<const char*>(::memchr(p, c1, end - p));
+	return (found != NULL) ? found : end;
+}
+
+static const char* Scan2_Scalar(const char* p, const char* end, char c1, char c2)
+{
+	while((p < end) && (*p != c1) && (*p != c2))
+		p++;
+	return p;
+}
+
+static const char* Scan3_Scalar(const char* p, const char* end, char c1, char c2, char c3)
+{
+	while((p < end) && (*p != c1) && (*p != c2) && (*p != c3))
+		p++;
+	return p;
+}
+
+#ifdef XMLSCAN_X86
+
+// SSE2 versions
+
+// Unaligned loads are only done when a full vector lies inside [p, end) so we never read
+// past the end of the caller's data. The remainder is handled with the scalar code.
+
+__attribute__((target("sse2")))
+static const char* Scan1_SSE2(const char* p, const char* end, char c1)
+{
+	const __m128i v1 = _mm_set1_epi8(c1);
+	while(end - p >= 16)
+	{
+		__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, v1));
+		if (mask != 0)
+			return p + __builtin_ctz(mask);
+		p += 16;
+	}
+	return Scan1_Scalar(p, end, c1);
+}
+
+__attribute__((target("sse2")))
+static const char* Scan2_SSE2(const char* p, const char* end, char c1, char c2)
+{
+	const __m128i v1 = _mm_set1_epi8(c1);
+	const __m128i v2 = _mm_set1_epi8(c2);
+	while(end - p >= 16)
+	{
+		__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		__m128i match = _mm_or_si128(_mm_cmpeq_epi8(chunk, v1), _mm_cmpeq_epi8(chunk, v2));
+		int mask = _mm_movemask_epi8(match);
+		if (mask != 0)
+			return p + __builtin_ctz(mask);
+		p += 16;
+	}
+	return Scan2_Scalar(p, end, c1, c2);
+}
+
+__attribute__((target("sse2")))
+static const char* Scan3_SSE2(const char* p, const char* end, char c1, char c2, char c3)
+{
+	const __m128i v1 = _mm_set1_epi8(c1);
+	const __m128i v2 = _mm_set1_epi8(c2);
+	const __m128i v3 = _mm_set1_epi8(c3);
+	while(end - p >= 16)
+	{
+		__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		__m128i match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, v1), _mm_cmpeq_epi8(chunk, v2)), _mm_cmpeq_epi8(chunk, v3));
+		int mask = _mm_movemask_epi8(match);
+		if (mask != 0)
+			return p + __builtin_ctz(mask);
+		p += 16;
+	}
+	return Scan3_Scalar(p, end, c1, c2, c3);
+}
+
+// AVX2 versions
+
+__attribute__((target("avx2")))
+static const char* Scan1_AVX2(const char* p, const char* end, char c1)
+{
+	const __m256i v1 = _mm256_set1_epi8(c1);
+	while(end - p >= 32)
+	{
+		__m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+		unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, v1));
+		if (mask != 0)
+			return p + __builtin_ctz(mask);
+		p += 32;
+	}
+	return Scan1_SSE2(p, end, c1);
+}
+
+__attribute__((target("avx2")))
+static const char* Scan2_AVX2(const char* p, const char* end, char c1, char c2)
+{
+	const __m256i v1 = _mm256_set1_epi8(c1);
+	const __m256i v2 = _mm256_set1_epi8(c2);
+	while(end - p >= 32)
+	{
+		__m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+		__m256i match = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, v1), _mm256_cmpeq_epi8(chunk, v2));
+		unsigned int mask = (unsigned int)_mm256_movemask_epi8(match);
+		if (mask != 0)
+			return p + __builtin_ctz(mask);
+		p += 32;
+	}
+	return Scan2_SSE2(p, end, c1, c2);
+}
+
+__attribute__((target("avx2")))
+static const char* Scan3_AVX2(const char* p, const char* end, char c1, char c2, char c3)
+{
+	const __m256i v1 = _mm256_set1_epi8(c1);
+	const __m256i v2 = _mm256_set1_epi8(c2);
+	const __m256i v3 = _mm256_set1_epi8(c3);
+	while(end - p >= 32)
+	{
+		__m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+		__m256i match = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, v1), _mm256_cmpeq_epi8(chunk, v2)), _mm256_cmpeq_epi8(chunk, v3));
+		unsigned int mask = (unsigned int)_mm256_movemask_epi8(match);
+		if (mask != 0)
+			return p + __builtin_ctz(mask);
+		p += 32;
+	}
+	return Scan3_SSE2(p, end, c1, c2, c3);
+}
+
+#endif
+
+// Runtime selection
+
+struct SScanKernels
+{
+	const char* (*mScan1)(const char*, const char*, char);
+	const char* (*mScan2)(const char*, const char*, char, char);
+	const char* (*mScan3)(const char*, const char*, char, char, char);
+	const char* mName;
+};
+
+static SScanKernels SelectKernels()
+{
+	SScanKernels result = { Scan1_Scalar, Scan2_Scalar, Scan3_Scalar, "scalar" };
+
+#ifdef XMLSCAN_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+	{
+		SScanKernels avx2 = { Scan1_AVX2, Scan2_AVX2, Scan3_AVX2, "avx2" };
+		result = avx2;
+	}
+	else if (__builtin_cpu_supports("sse2"))
+	{
+		SScanKernels sse2 = { Scan1_SSE2, Scan2_SSE2, Scan3_SSE2, "sse2" };
+		result = sse2;
+	}
+#endif
+
+	return result;
+}
+
+// Selected on first use
+static const SScanKernels& Kernels()
+{
+	static const SScanKernels sKernels = SelectKernels();
+	return sKernels;
+}
+
+const char* XMLScan(const char* p, const char* end, char c1)
+{
+	return Kernels().mScan1(p, end, c1);
+}
+
+const char* XMLScan(const char* p, const char* end, char c1, char c2)
+{
+	return Kernels().mScan2(p, end, c1, c2);
+}
+
+const char* XMLScan(const char* p, const char* end, char c1, char c2, char c3)
+{
+	return Kernels().mScan3(p, end, c1, c2, c3);
+}
+
+const char* XMLScanKernel()
+{
+	return Kernels().mName;
+}
+
+}
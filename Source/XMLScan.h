@@ -0,0 +1,37 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Header for delimiter scanning kernels
+
+#ifndef __XMLSCAN__XMLLIB__
+#define __XMLSCAN__XMLLIB__
+
+namespace xmllib
+{
+
+// Each of these returns a pointer to the first byte in [p, end) that matches one of the
+// given bytes, or end if there is no match. The implementation (AVX2, SSE2 or scalar) is
+// chosen once at runtime based on what the CPU supports.
+
+const char* XMLScan(const char* p, const char* end, char c1);
+const char* XMLScan(const char* p, const char* end, char c1, char c2);
+const char* XMLScan(const char* p, const char* end, char c1, char c2, char c3);
+
+// Name of the kernel set in use ("avx2", "sse2" or "scalar")
+const char* XMLScanKernel();
+
+}
+#endif
@@ -0,0 +1,568 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+// Source for XMLSnapshot class
+
+#include "XMLSnapshot.h"
+
+#include "XMLDocument.h"
+#include "XMLName.h"
+#include "XMLNameTable.h"
+#include "XMLNode.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define XMLSNAPSHOT_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace xmllib;
+
+// Layout - a header, the tables in the order of the header's fields, then the strings. Every
+// table entry is a multiple of 4 bytes so all of them stay aligned.
+
+static const char cMagic[4] = { 'X', 'M', 'L', 'S' };
+static const uint32_t cByteOrder = 0x01020304;
+
+struct XMLSnapshot::SHeader
+{
+	char		mMagic[4];
+	uint32_t	mVersion;
+	uint32_t	mByteOrder;
+	uint32_t	mSize;
+	uint32_t	mNames;				// Offset and count of each table
+	uint32_t	mNameCount;
+	uint32_t	mNamespaces;
+	uint32_t	mNamespaceCount;
+	uint32_t	mNodes;
+	uint32_t	mNodeCount;
+	uint32_t	mAttributes;
+	uint32_t	mAttributeCount;
+	uint32_t	mStrings;
+	uint32_t	mStringsSize;
+};
+
+// Offset in the strings, each of which is followed by a NUL
+struct XMLSnapshot::SString
+{
+	uint32_t	mOffset;
+	uint32_t	mLength;
+};
+
+struct XMLSnapshot::SNamespace
+{
+	SString		mName;
+	SString		mPrefix;
+};
+
+// Nodes are in document order, so the first child of a node is always the one after it
+struct XMLSnapshot::SNode
+{
+	uint32_t	mName;				// Index in the names
+	uint32_t	mNamespace;			// Index in the namespaces, as in the document
+	uint32_t	mDefaultNamespace;	// Likewise, for the default in scope inside the node
+	uint32_t	mFlags;
+	uint32_t	mParent;
+	uint32_t	mNext;				// Next sibling
+	uint32_t	mAttributes;		// First attribute and count
+	uint32_t	mAttributeCount;
+	SString		mData;
+};
+
+static const uint32_t cNodeChildren = 0x02;
+
+struct XMLSnapshot::SAttribute
+{
+	uint32_t	mName;
+	SString		mValue;
+};
+
+// Collects the tables for writing - names are interned so each is stored once
+struct XMLSnapshot::SBuilder
+{
+	XMLNameTable				mNames;
+	std::vector<SNamespace>		mNamespaces;
+	std::vector<SNode>			mNodes;
+	std::vector<SAttribute>		mAttributes;
+	std::vector<char>			mStrings;
+
+	SBuilder()
+	{
+		// Empty strings all share the first NUL
+		mStrings.push_back(0);
+	}
+
+	SString AddString(const cdstring& str)
+	{
+		SString result;
+		result.mOffset = 0;
+		result.mLength = str.length();
+		if (result.mLength != 0)
+		{
+			result.mOffset = mStrings.size();
+			mStrings.insert(mStrings.end(), str.c_str(), str.c_str() + str.length());
+			mStrings.push_back(0);
+		}
+		return result;
+	}
+
+	void AddNode(const XMLNode& node, uint32_t parent)
+	{
+		uint32_t index = mNodes.size();
+		SNode item;
+		item.mName = mNames.Intern(node.Name());
+		item.mNamespace = node.mNamespaceIndex;
+		item.mDefaultNamespace = node.mDefaultNamespace;
+		item.mFlags = node.mChildren.empty() ? 0 : cNodeChildren;
+		item.mParent = parent;
+		item.mNext = cNoNode;
+		item.mAttributes = mAttributes.size();
+		item.mAttributeCount = node.mAttributeList.size();
+		item.mData = AddString(node.mData);
+		mNodes.push_back(item);
+
+		for(XMLAttributeList::const_iterator iter = node.mAttributeList.begin(); iter != node.mAttributeList.end(); iter++)
+		{
+			SAttribute attr;
+			attr.mName = mNames.Intern((*iter)->Name());
+			attr.mValue = AddString((*iter)->Value());
+			mAttributes.push_back(attr);
+		}
+
+		// Each child's subtree follows it directly
+		uint32_t previous = cNoNode;
+		for(XMLNodeList::const_iterator iter = node.mChildren.begin(); iter != node.mChildren.end(); iter++)
+		{
+			if (previous != cNoNode)
+				mNodes[previous].mNext = mNodes.size();
+			previous = mNodes.size();
+			AddNode(**iter, index);
+		}
+	}
+};
+
+template<class T> static void WriteTable(std::ostream& os, const std::vector<T>& table)
+{
+	if (!table.empty())
+		os.write(reinterpret_cast<const char*>(&table[0]), table.size() * sizeof(T));
+}
+
+bool XMLSnapshot::Write(const XMLDocument& doc, std::ostream& os)
+{
+	SBuilder builder;
+	for(XMLNamespaceList::const_iterator iter = doc.mNamespaces.begin(); iter != doc.mNamespaces.end(); iter++)
+	{
+		SNamespace namespc;
+		namespc.mName = builder.AddString((*iter).Name());
+		namespc.mPrefix = builder.AddString((*iter).Prefix());
+		builder.mNamespaces.push_back(namespc);
+	}
+	builder.AddNode(*doc.mRoot, cNoNode);
+
+	// Names are only known once all the nodes are in
+	std::vector<SString> names;
+	for(uint32_t i = 0; i < builder.mNames.Count(); i++)
+		names.push_back(builder.AddString(builder.mNames.Name(i)));
+
+	SHeader header;
+	::memcpy(header.mMagic, cMagic, sizeof(cMagic));
+	header.mVersion = cVersion;
+	header.mByteOrder = cByteOrder;
+	uint64_t offset = sizeof(SHeader);
+	header.mNames = offset;
+	header.mNameCount = names.size();
+	offset += names.size() * sizeof(SString);
+	header.mNamespaces = offset;
+	header.mNamespaceCount = builder.mNamespaces.size();
+	offset += builder.mNamespaces.size() * sizeof(SNamespace);
+	header.mNodes = offset;
+	header.mNodeCount = builder.mNodes.size();
+	offset += builder.mNodes.size() * sizeof(SNode);
+	header.mAttributes = offset;
+	header.mAttributeCount = builder.mAttributes.size();
+	offset += builder.mAttributes.size() * sizeof(SAttribute);
+	header.mStrings = offset;
+	header.mStringsSize = builder.mStrings.size();
+	offset += builder.mStrings.size();
+
+	// Offsets are 32 bits
+	if (offset > 0xFFFFFFFFULL)
+		return false;
+	header.mSize = offset;
+
+	os.write(reinterpret_cast<const char*>(&header), sizeof(SHeader));
+	WriteTable(os, names);
+	WriteTable(os, builder.mNamespaces);
+	WriteTable(os, builder.mNodes);
+	WriteTable(os, builder.mAttributes);
+	WriteTable(os, builder.mStrings);
+
+	return !os.fail();
+}
+
+bool XMLSnapshot::WriteFile(const XMLDocument& doc, const char* path)
+{
+	std::ofstream fout(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (fout.fail())
+		return false;
+
+	bool result = Write(doc, fout);
+	fout.close();
+	return result && !fout.fail();
+}
+
+XMLSnapshot::XMLSnapshot()
+{
+	mData = NULL;
+	mLength = 0;
+	mHeader = NULL;
+	mMapped = NULL;
+	mMappedSize = 0;
+	mOwned = NULL;
+}
+
+XMLSnapshot::~XMLSnapshot()
+{
+	Close();
+}
+
+bool XMLSnapshot::Open(const char* data, size_t length)
+{
+	Close();
+
+	if ((data == NULL) || ((reinterpret_cast<uintptr_t>(data) & 3) != 0))
+		return false;
+
+	mData = data;
+	mLength = length;
+	if (!Check())
+	{
+		Close();
+		return false;
+	}
+
+	mHeader = reinterpret_cast<const SHeader*>(mData);
+	return true;
+}
+
+bool XMLSnapshot::OpenFile(const char* path)
+{
+	Close();
+
+#ifdef XMLSNAPSHOT_MMAP
+	int fd = ::open(path, O_RDONLY);
+	if (fd == -1)
+		return false;
+
+	struct stat st;
+	if ((::fstat(fd, &st) != 0) || !S_ISREG(st.st_mode) || (st.st_size < (off_t)sizeof(SHeader)))
+	{
+		::close(fd);
+		return false;
+	}
+
+	void* mapped = ::mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapped == MAP_FAILED)
+		return false;
+
+	if (!Open(static_cast<const char*>(mapped), st.st_size))
+	{
+		::munmap(mapped, st.st_size);
+		return false;
+	}
+	mMapped = mapped;
+	mMappedSize = st.st_size;
+	return true;
+#else
+	std::ifstream fin(path, std::ios::in | std::ios::binary);
+	if (fin.fail())
+		return false;
+	fin.seekg(0, std::ios::end);
+	std::streamoff size = fin.tellg();
+	fin.seekg(0, std::ios::beg);
+	if (size < (std::streamoff)sizeof(SHeader))
+		return false;
+
+	char* data = new char[size];
+	fin.read(data, size);
+	if (fin.fail() || !Open(data, size))
+	{
+		delete[] data;
+		return false;
+	}
+	mOwned = data;
+	return true;
+#endif
+}
+
+void XMLSnapshot::Close()
+{
+#ifdef XMLSNAPSHOT_MMAP
+	if (mMapped != NULL)
+		::munmap(mMapped, mMappedSize);
+#endif
+	delete[] mOwned;
+
+	mData = NULL;
+	mLength = 0;
+	mHeader = NULL;
+	mMapped = NULL;
+	mMappedSize = 0;
+	mOwned = NULL;
+}
+
+// A table of count entries at offset must be aligned and inside the snapshot
+static bool CheckTable(uint32_t offset, uint32_t count, size_t entry, uint32_t size)
+{
+	return ((offset & 3) == 0) && (offset <= size) && ((uint64_t)count * entry <= size - offset);
+}
+
+bool XMLSnapshot::Check() const
+{
+	if (mLength < sizeof(SHeader))
+		return false;
+
+	const SHeader& header = *reinterpret_cast<const SHeader*>(mData);
+	if ((::memcmp(header.mMagic, cMagic, sizeof(cMagic)) != 0) || (header.mVersion != cVersion) ||
+		(header.mByteOrder != cByteOrder) || (header.mSize > mLength) || (header.mSize < sizeof(SHeader)))
+		return false;
+
+	if (!CheckTable(header.mNames, header.mNameCount, sizeof(SString), header.mSize) ||
+		!CheckTable(header.mNamespaces, header.mNamespaceCount, sizeof(SNamespace), header.mSize) ||
+		!CheckTable(header.mNodes, header.mNodeCount, sizeof(SNode), header.mSize) ||
+		!CheckTable(header.mAttributes, header.mAttributeCount, sizeof(SAttribute), header.mSize) ||
+		(header.mStrings > header.mSize) || (header.mStringsSize > header.mSize - header.mStrings) ||
+		(header.mStringsSize == 0) || (mData[header.mStrings] != 0))
+		return false;
+
+	const SString* names = reinterpret_cast<const SString*>(mData + header.mNames);
+	for(uint32_t i = 0; i < header.mNameCount; i++)
+	{
+		if (!CheckString(names[i]))
+			return false;
+	}
+
+	// The first namespace is always the empty one as in a document
+	const SNamespace* namespaces = reinterpret_cast<const SNamespace*>(mData + header.mNamespaces);
+	if ((header.mNamespaceCount == 0) || (namespaces[0].mName.mLength != 0))
+		return false;
+	for(uint32_t i = 0; i < header.mNamespaceCount; i++)
+	{
+		if (!CheckString(namespaces[i].mName) || !CheckString(namespaces[i].mPrefix))
+			return false;
+	}
+
+	// Every node's parent comes before it, and its first child and next sibling after it with
+	// the right parent
+	const SNode* nodes = reinterpret_cast<const SNode*>(mData + header.mNodes);
+	if ((header.mNodeCount == 0) || (nodes[0].mParent != cNoNode) || (nodes[0].mNext != cNoNode))
+		return false;
+	for(uint32_t i = 0; i < header.mNodeCount; i++)
+	{
+		const SNode& node = nodes[i];
+		if ((node.mName >= header.mNameCount) || (node.mNamespace >= header.mNamespaceCount) ||
+			(node.mDefaultNamespace >= header.mNamespaceCount) ||
+			((i != 0) && (node.mParent >= i)) ||
+			(((node.mFlags & cNodeChildren) != 0) && ((i + 1 >= header.mNodeCount) || (nodes[i + 1].mParent != i))) ||
+			((node.mNext != cNoNode) && ((node.mNext <= i) || (node.mNext >= header.mNodeCount) || (nodes[node.mNext].mParent != node.mParent))) ||
+			(node.mAttributes > header.mAttributeCount) || (node.mAttributeCount > header.mAttributeCount - node.mAttributes) ||
+			!CheckString(node.mData))
+			return false;
+	}
+
+	const SAttribute* attributes = reinterpret_cast<const SAttribute*>(mData + header.mAttributes);
+	for(uint32_t i = 0; i < header.mAttributeCount; i++)
+	{
+		if ((attributes[i].mName >= header.mNameCount) || !CheckString(attributes[i].mValue))
+			return false;
+	}
+
+	return true;
+}
+
+// Only used while checking, before mHeader is set
+bool XMLSnapshot::CheckString(const SString& str) const
+{
+	const SHeader& header = *reinterpret_cast<const SHeader*>(mData);
+	return (str.mOffset < header.mStringsSize) && (str.mLength < header.mStringsSize - str.mOffset) &&
+			(mData[header.mStrings + str.mOffset + str.mLength] == 0);
+}
+
+XMLDocument* XMLSnapshot::Materialize(XMLNameTable* names) const
+{
+	if (mHeader == NULL)
+		return NULL;
+
+	XMLDocument* doc = new XMLDocument(names);
+	try
+	{
+		// Namespaces keep their indices so the nodes can use them as they are
+		const SNamespace* namespaces = reinterpret_cast<const SNamespace*>(mData + mHeader->mNamespaces);
+		for(uint32_t i = 1; i < mHeader->mNamespaceCount; i++)
+		{
+			XMLNamespace namespc(String(namespaces[i].mName).ToString(), String(namespaces[i].mPrefix).ToString());
+			namespc.SetIndex(i);
+			doc->AppendNamespace(namespc, doc->mNames->Intern(namespc.Name()), doc->mNames->Intern(namespc.Prefix()));
+		}
+
+		// Each distinct name is only interned once
+		std::vector<uint32_t> ids;
+		ids.reserve(mHeader->mNameCount);
+		for(uint32_t i = 0; i < mHeader->mNameCount; i++)
+		{
+			XMLStringView name = NameString(i);
+			ids.push_back(doc->mNames->Intern(name.Data(), name.Length()));
+		}
+
+		// Parents always come before their children
+		std::vector<XMLNode*> nodes;
+		nodes.reserve(mHeader->mNodeCount);
+		for(uint32_t i = 0; i < mHeader->mNodeCount; i++)
+		{
+			const SNode& item = Node(i);
+			XMLNode* node = (i == 0) ? doc->mRoot : doc->CreateNode(nodes[item.mParent], cdstring::null_str);
+			nodes.push_back(node);
+
+			node->mNameID = ids[item.mName];
+			node->mNamespaceIndex = item.mNamespace;
+			node->mDefaultNamespace = item.mDefaultNamespace;
+			if (item.mData.mLength != 0)
+				node->mData.append(String(item.mData).Data(), item.mData.mLength);
+
+			for(uint32_t j = 0; j < item.mAttributeCount; j++)
+			{
+				const SAttribute& attr = Attribute(i, j);
+				XMLAttribute* created = XMLAttribute::Create(doc->Arena(), cdstring::null_str, String(attr.mValue).ToString());
+				created->Attach(*doc->mNames, ids[attr.mName]);
+				node->mAttributeList.push_back(created);
+			}
+		}
+	}
+	catch(...)
+	{
+		delete doc;
+		throw;
+	}
+
+	return doc;
+}
+
+uint32_t XMLSnapshot::CountNodes() const
+{
+	return (mHeader != NULL) ? mHeader->mNodeCount : 0;
+}
+
+uint32_t XMLSnapshot::Parent(uint32_t node) const
+{
+	return Node(node).mParent;
+}
+
+uint32_t XMLSnapshot::FirstChild(uint32_t node) const
+{
+	return ((Node(node).mFlags & cNodeChildren) != 0) ? node + 1 : cNoNode;
+}
+
+uint32_t XMLSnapshot::NextSibling(uint32_t node) const
+{
+	return Node(node).mNext;
+}
+
+// Compares names as strings as the snapshot has no name table to look them up in
+uint32_t XMLSnapshot::GetChild(uint32_t node, const XMLName& name) const
+{
+	const char* local = (name.Name() != NULL) ? name.Name() : "";
+	const char* namespc = (name.Namespace() != NULL) ? name.Namespace() : "";
+	for(uint32_t child = FirstChild(node); child != cNoNode; child = NextSibling(child))
+	{
+		if (Name(child).Equals(local) && Namespace(child).Equals(namespc))
+			return child;
+	}
+
+	return cNoNode;
+}
+
+XMLStringView XMLSnapshot::Name(uint32_t node) const
+{
+	return NameString(Node(node).mName);
+}
+
+XMLStringView XMLSnapshot::Namespace(uint32_t node) const
+{
+	const SNamespace* namespaces = reinterpret_cast<const SNamespace*>(mData + mHeader->mNamespaces);
+	return String(namespaces[Node(node).mNamespace].mName);
+}
+
+XMLStringView XMLSnapshot::Data(uint32_t node) const
+{
+	return String(Node(node).mData);
+}
+
+uint32_t XMLSnapshot::CountAttributes(uint32_t node) const
+{
+	return Node(node).mAttributeCount;
+}
+
+XMLStringView XMLSnapshot::AttributeName(uint32_t node, uint32_t index) const
+{
+	return NameString(Attribute(node, index).mName);
+}
+
+XMLStringView XMLSnapshot::AttributeValue(uint32_t node, uint32_t index) const
+{
+	return String(Attribute(node, index).mValue);
+}
+
+bool XMLSnapshot::AttributeValue(uint32_t node, const char* name, XMLStringView& value) const
+{
+	for(uint32_t i = 0; i < Node(node).mAttributeCount; i++)
+	{
+		if (AttributeName(node, i).Equals(name))
+		{
+			value = AttributeValue(node, i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+const XMLSnapshot::SNode& XMLSnapshot::Node(uint32_t node) const
+{
+	return reinterpret_cast<const SNode*>(mData + mHeader->mNodes)[node];
+}
+
+const XMLSnapshot::SAttribute& XMLSnapshot::Attribute(uint32_t node, uint32_t index) const
+{
+	return reinterpret_cast<const SAttribute*>(mData + mHeader->mAttributes)[Node(node).mAttributes + index];
+}
+
+XMLStringView XMLSnapshot::String(const SString& str) const
+{
+	return XMLStringView(mData + mHeader->mStrings + str.mOffset, str.mLength);
+}
+
+XMLStringView XMLSnapshot::NameString(uint32_t name) const
+{
+	return String(reinterpret_cast<const SString*>(mData + mHeader->mNames)[name]);
+}
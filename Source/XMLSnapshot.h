@@ -0,0 +1,121 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+// Header for XMLSnapshot class
+
+#ifndef __XMLSNAPSHOT__XMLLIB__
+#define __XMLSNAPSHOT__XMLLIB__
+
+#include "XMLStringView.h"
+
+#include <stdint.h>
+#include <ostream>
+
+namespace xmllib
+{
+
+class XMLDocument;
+class XMLName;
+class XMLNameTable;
+class XMLNode;
+
+// A compact binary form of a whole document - names, namespaces, attributes, data and
+// structure - for documents that are loaded over and over. Everything in it is addressed
+// by offsets, so a snapshot can be mapped straight from a file. It can then either be turned
+// back into a document without any parsing or namespace processing, or read in place.
+// In-place reading refers to nodes by their index in document order, the root being 0.
+// Snapshots are in the byte order of the machine that wrote them and are rejected by a
+// machine with a different order or by a different version of the format.
+
+class XMLSnapshot
+{
+public:
+	static const uint32_t cVersion = 2;
+	static const uint32_t cNoNode = 0xFFFFFFFF;
+
+	static bool Write(const XMLDocument& doc, std::ostream& os);
+	static bool WriteFile(const XMLDocument& doc, const char* path);
+
+	XMLSnapshot();
+	~XMLSnapshot();
+
+	// Checks the whole snapshot so nothing read from it afterwards can be out of bounds. The
+	// data is not copied so must outlive the snapshot, and must be 4 byte aligned.
+	bool Open(const char* data, size_t length);
+	bool OpenFile(const char* path);
+	void Close();
+
+	bool IsOpen() const
+	{
+		return mHeader != NULL;
+	}
+
+	// A new document belonging to the caller - names are interned as for XMLDocument's
+	// constructor. NULL if the snapshot is not open.
+	XMLDocument* Materialize(XMLNameTable* names = NULL) const;
+
+	// Reading in place - nodes must be valid indices, and views stay valid until the snapshot
+	// is closed
+	uint32_t CountNodes() const;
+	uint32_t Root() const
+	{
+		return IsOpen() ? 0 : cNoNode;
+	}
+	uint32_t Parent(uint32_t node) const;
+	uint32_t FirstChild(uint32_t node) const;
+	uint32_t NextSibling(uint32_t node) const;
+	uint32_t GetChild(uint32_t node, const XMLName& name) const;
+
+	XMLStringView Name(uint32_t node) const;
+	XMLStringView Namespace(uint32_t node) const;
+	XMLStringView Data(uint32_t node) const;
+
+	uint32_t CountAttributes(uint32_t node) const;
+	XMLStringView AttributeName(uint32_t node, uint32_t index) const;
+	XMLStringView AttributeValue(uint32_t node, uint32_t index) const;
+	bool AttributeValue(uint32_t node, const char* name, XMLStringView& value) const;
+
+private:
+	struct SHeader;
+	struct SString;
+	struct SNamespace;
+	struct SNode;
+	struct SAttribute;
+	struct SBuilder;
+
+	const char*			mData;
+	size_t				mLength;
+	const SHeader*		mHeader;			// Only set once checked
+	void*				mMapped;
+	size_t				mMappedSize;
+	char*				mOwned;				// File read in where it cannot be mapped
+
+	bool Check() const;
+	bool CheckString(const SString& str) const;
+
+	const SNode& Node(uint32_t node) const;
+	const SAttribute& Attribute(uint32_t node, uint32_t index) const;
+	XMLStringView String(const SString& str) const;
+	XMLStringView NameString(uint32_t name) const;
+
+	// Not copyable
+	XMLSnapshot(const XMLSnapshot& copy);
+	XMLSnapshot& operator=(const XMLSnapshot& copy);
+};
+
+}
+#endif
@@ -0,0 +1,210 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Source for XMLStats class
+
+#include "XMLStats.h"
+
+#include "XMLMutex.h"
+
+#include <cstring>
+#include <ostream>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#if defined(_WIN32)
+#define XMLSTATS_THREAD __declspec(thread)
+#else
+#define XMLSTATS_THREAD __thread
+#endif
+
+using namespace xmllib;
+
+static const char* cCounterNames[XMLStats::eCounterCount] =
+{
+	"buffer_refills",
+	"bytes_read",
+	"bytes_moved",
+	"buffer_growths",
+	"elements",
+	"attributes",
+	"text_runs",
+	"entity_decodes",
+	"namespaces",
+	"namespace_table_growths",
+	"nodes_created",
+	"bytes_generated"
+};
+
+static const char* cTimerNames[XMLStats::eTimerCount] =
+{
+	"parse",
+	"generate"
+};
+
+#ifdef XMLLIB_STATS
+static XMLSTATS_THREAD XMLStats* sCurrent = NULL;
+#endif
+
+// Process totals are made on first use so they are there whatever the order of static
+// construction
+static XMLMutex& ProcessLock()
+{
+	static XMLMutex lock;
+	return lock;
+}
+
+static XMLStats& ProcessStats()
+{
+	static XMLStats stats;
+	return stats;
+}
+
+void XMLStats::Clear()
+{
+	::memset(mCounters, 0, sizeof(mCounters));
+	::memset(mTimes, 0, sizeof(mTimes));
+	::memset(mCalls, 0, sizeof(mCalls));
+}
+
+void XMLStats::Add(const XMLStats& stats)
+{
+	for(uint32_t i = 0; i < eCounterCount; i++)
+		mCounters[i] += stats.mCounters[i];
+	for(uint32_t i = 0; i < eTimerCount; i++)
+	{
+		mTimes[i] += stats.mTimes[i];
+		mCalls[i] += stats.mCalls[i];
+	}
+}
+
+const char* XMLStats::Name(ECounter counter)
+{
+	return (counter < eCounterCount) ? cCounterNames[counter] : "";
+}
+
+const char* XMLStats::Name(ETimer timer)
+{
+	return (timer < eTimerCount) ? cTimerNames[timer] : "";
+}
+
+// Names need no escaping and all values are integers
+void XMLStats::WriteJSON(std::ostream& os) const
+{
+	os << "{\"enabled\": ";
+#ifdef XMLLIB_STATS
+	os << "true";
+#else
+	os << "false";
+#endif
+	os << ", \"counters\": {";
+	for(uint32_t i = 0; i < eCounterCount; i++)
+		os << ((i != 0) ? ", \"" : "\"") << cCounterNames[i] << "\": " << mCounters[i];
+	os << "}, \"timers\": {";
+	for(uint32_t i = 0; i < eTimerCount; i++)
+		os << ((i != 0) ? ", \"" : "\"") << cTimerNames[i] << "\": {\"calls\": " << mCalls[i] << ", \"ns\": " << mTimes[i] << "}";
+	os << "}}";
+}
+
+XMLStats* XMLStats::Current()
+{
+#ifdef XMLLIB_STATS
+	return sCurrent;
+#else
+	return NULL;
+#endif
+}
+
+void XMLStats::SetCurrent(XMLStats* stats)
+{
+#ifdef XMLLIB_STATS
+	sCurrent = stats;
+#endif
+}
+
+void XMLStats::Count(ECounter counter, uint64_t n)
+{
+#ifdef XMLLIB_STATS
+	if (sCurrent != NULL)
+		sCurrent->mCounters[counter] += n;
+#endif
+}
+
+void XMLStats::AddToProcess(const XMLStats& stats)
+{
+	XMLMutexLock lock(ProcessLock());
+	ProcessStats().Add(stats);
+}
+
+void XMLStats::GetProcess(XMLStats& stats)
+{
+	XMLMutexLock lock(ProcessLock());
+	stats = ProcessStats();
+}
+
+void XMLStats::ClearProcess()
+{
+	XMLMutexLock lock(ProcessLock());
+	ProcessStats().Clear();
+}
+
+// Monotonic nanoseconds
+uint64_t XMLStats::Now()
+{
+#if defined(_WIN32)
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER count;
+	::QueryPerformanceFrequency(&frequency);
+	::QueryPerformanceCounter(&count);
+	return (uint64_t)(count.QuadPart / frequency.QuadPart) * 1000000000ULL +
+			(uint64_t)(count.QuadPart % frequency.QuadPart) * 1000000000ULL / frequency.QuadPart;
+#else
+	struct timespec now;
+	::clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+#endif
+}
+
+XMLStatsScope::XMLStatsScope(XMLStats& stats)
+{
+	mPrevious = XMLStats::Current();
+	XMLStats::SetCurrent(&stats);
+}
+
+XMLStatsScope::~XMLStatsScope()
+{
+	XMLStats::SetCurrent(mPrevious);
+}
+
+XMLStatsTimer::XMLStatsTimer(XMLStats::ETimer timer)
+{
+	mStats = XMLStats::Current();
+	mTimer = timer;
+	mStart = (mStats != NULL) ? XMLStats::Now() : 0;
+}
+
+XMLStatsTimer::~XMLStatsTimer()
+{
+	if (mStats != NULL)
+	{
+		mStats->mTimes[mTimer] += XMLStats::Now() - mStart;
+		mStats->mCalls[mTimer]++;
+	}
+}
@@ -0,0 +1,149 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Header for XMLStats class
+
+#ifndef __XMLSTATS__XMLLIB__
+#define __XMLSTATS__XMLLIB__
+
+#include <stdint.h>
+#include <iosfwd>
+
+// Statistics are only collected when the library is built with XMLLIB_STATS defined. Without
+// it the hooks compile to nothing and every count stays zero, but the API is still there so
+// code using it builds either way.
+#ifdef XMLLIB_STATS
+#define XMLLIB_STATS_COUNT(counter, n)	xmllib::XMLStats::Count(xmllib::XMLStats::counter, n)
+#define XMLLIB_STATS_TIMER(timer)		xmllib::XMLStatsTimer _stats_timer(xmllib::XMLStats::timer)
+#else
+#define XMLLIB_STATS_COUNT(counter, n)
+#define XMLLIB_STATS_TIMER(timer)
+#endif
+
+namespace xmllib
+{
+
+// Counters and timers for the work done while parsing and generating. Each thread has at
+// most one collector at a time, set with XMLStatsScope, and the library's hooks add to it.
+// Parsers put their own in place for the duration of each parse, so their stats cover
+// everything done for it on that thread, including building the document. Anything else,
+// such as generating, is only counted when the caller has set a collector. Work done on
+// other threads is only counted if those threads have a collector, as the chunks of a
+// parallel parse do. Collectors can be added together, and there is a process wide total
+// that any thread can add to.
+
+class XMLStats
+{
+public:
+	enum ECounter
+	{
+		eBufferRefills,				// Reads into a stream buffer
+		eBytesRead,					// Read from streams
+		eBytesMoved,				// Unconsumed data moved down a buffer
+		eBufferGrowths,
+		eElements,
+		eAttributes,
+		eTextRuns,					// Character data and CDATA callbacks
+		eEntityDecodes,				// Entity and character references decoded
+		eNamespaces,				// Added to documents
+		eNamespaceTableGrowths,
+		eNodesCreated,
+		eBytesGenerated,			// Written out by XMLWriter
+		eCounterCount
+	};
+
+	enum ETimer
+	{
+		eTimerParse,
+		eTimerGenerate,
+		eTimerCount
+	};
+
+	XMLStats()
+		{ Clear(); }
+
+	void Clear();
+	void Add(const XMLStats& stats);
+
+	uint64_t Counter(ECounter counter) const
+		{ return mCounters[counter]; }
+	uint64_t Time(ETimer timer) const			// Nanoseconds
+		{ return mTimes[timer]; }
+	uint64_t Calls(ETimer timer) const
+		{ return mCalls[timer]; }
+
+	static const char* Name(ECounter counter);
+	static const char* Name(ETimer timer);
+
+	// One object with a member for each counter and timer
+	void WriteJSON(std::ostream& os) const;
+
+	// Collector for the current thread, or NULL
+	static XMLStats* Current();
+	static void Count(ECounter counter, uint64_t n);
+
+	// Totals for the whole process
+	static void AddToProcess(const XMLStats& stats);
+	static void GetProcess(XMLStats& stats);
+	static void ClearProcess();
+
+private:
+	friend class XMLStatsScope;
+	friend class XMLStatsTimer;
+
+	uint64_t	mCounters[eCounterCount];
+	uint64_t	mTimes[eTimerCount];
+	uint64_t	mCalls[eTimerCount];
+
+	static void SetCurrent(XMLStats* stats);
+	static uint64_t Now();
+};
+
+// Makes stats the current thread's collector for the lifetime of the object
+class XMLStatsScope
+{
+public:
+	explicit XMLStatsScope(XMLStats& stats);
+	~XMLStatsScope();
+
+private:
+	XMLStats*	mPrevious;
+
+	// Not copyable
+	XMLStatsScope(const XMLStatsScope& copy);
+	XMLStatsScope& operator=(const XMLStatsScope& copy);
+};
+
+// Adds the time until it is destroyed to the current collector, if there was one when it
+// was created
+class XMLStatsTimer
+{
+public:
+	explicit XMLStatsTimer(XMLStats::ETimer timer);
+	~XMLStatsTimer();
+
+private:
+	XMLStats*			mStats;
+	XMLStats::ETimer	mTimer;
+	uint64_t			mStart;
+
+	// Not copyable
+	XMLStatsTimer(const XMLStatsTimer& copy);
+	XMLStatsTimer& operator=(const XMLStatsTimer& copy);
+};
+
+}
+#endif
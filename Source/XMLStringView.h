@@ -0,0 +1,83 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Header for XMLStringView class
+
+#ifndef __XMLSTRINGVIEW__XMLLIB__
+#define __XMLSTRINGVIEW__XMLLIB__
+
+#include <stddef.h>
+#include <cstring>
+#include <vector>
+
+#include "cdstring.h"
+
+namespace xmllib
+{
+
+// Non-owning pointer+length reference to character data. Views handed out by the parser
+// point either directly into the source buffer or into parser owned storage, and are only
+// valid until the callback they were passed to returns.
+
+class XMLStringView
+{
+public:
+	XMLStringView()
+		{ mData = ""; mLength = 0; }
+	XMLStringView(const char* data, size_t length)
+		{ mData = data; mLength = length; }
+	explicit XMLStringView(const char* data)
+		{ mData = data; mLength = ::strlen(data); }
+	explicit XMLStringView(const cdstring& data)
+		{ mData = data.c_str(); mLength = data.length(); }
+
+	const char* Data() const
+		{ return mData; }
+	size_t Length() const
+		{ return mLength; }
+	bool Empty() const
+		{ return mLength == 0; }
+
+	char operator[](size_t pos) const
+		{ return mData[pos]; }
+
+	bool Equals(const char* str, size_t length) const
+		{ return (mLength == length) && (::memcmp(mData, str, length) == 0); }
+	bool Equals(const char* str) const
+		{ return Equals(str, ::strlen(str)); }
+	bool Equals(const XMLStringView& comp) const
+		{ return Equals(comp.mData, comp.mLength); }
+
+	cdstring ToString() const
+		{ return cdstring(mData, mLength); }
+
+private:
+	const char*		mData;
+	size_t			mLength;
+};
+
+struct XMLAttributeView
+{
+	XMLStringView	mName;
+	XMLStringView	mValue;
+
+	XMLAttributeView(const XMLStringView& name, const XMLStringView& value)
+		: mName(name), mValue(value) {}
+};
+typedef std::vector<XMLAttributeView> XMLAttributeViewList;
+
+}
+#endif
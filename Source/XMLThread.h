@@ -0,0 +1,129 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Header for XMLThread class
+
+#ifndef __XMLTHREAD__XMLLIB__
+#define __XMLTHREAD__XMLLIB__
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+namespace xmllib
+{
+
+// Runs a function on its own thread - joined at the latest when destroyed
+
+class XMLThread
+{
+public:
+	typedef void (*Proc)(void* arg);
+
+	XMLThread()
+	{
+		mProc = NULL;
+		mArg = NULL;
+		mRunning = false;
+	}
+	~XMLThread()
+	{
+		Join();
+	}
+
+#if defined(_WIN32)
+	bool Start(Proc proc, void* arg)
+	{
+		mProc = proc;
+		mArg = arg;
+		mThread = ::CreateThread(NULL, 0, _Run, this, 0, NULL);
+		mRunning = (mThread != NULL);
+		return mRunning;
+	}
+	void Join()
+	{
+		if (mRunning)
+		{
+			::WaitForSingleObject(mThread, INFINITE);
+			::CloseHandle(mThread);
+			mRunning = false;
+		}
+	}
+
+	static uint32_t Processors()
+	{
+		SYSTEM_INFO info;
+		::GetSystemInfo(&info);
+		return (info.dwNumberOfProcessors > 0) ? info.dwNumberOfProcessors : 1;
+	}
+#else
+	bool Start(Proc proc, void* arg)
+	{
+		mProc = proc;
+		mArg = arg;
+		mRunning = (::pthread_create(&mThread, NULL, _Run, this) == 0);
+		return mRunning;
+	}
+	void Join()
+	{
+		if (mRunning)
+		{
+			::pthread_join(mThread, NULL);
+			mRunning = false;
+		}
+	}
+
+	static uint32_t Processors()
+	{
+		long count = ::sysconf(_SC_NPROCESSORS_ONLN);
+		return (count > 0) ? count : 1;
+	}
+#endif
+
+private:
+	Proc		mProc;
+	void*		mArg;
+	bool		mRunning;
+#if defined(_WIN32)
+	HANDLE		mThread;
+
+	static DWORD WINAPI _Run(LPVOID thread)
+	{
+		static_cast<XMLThread*>(thread)->mProc(static_cast<XMLThread*>(thread)->mArg);
+		return 0;
+	}
+#else
+	pthread_t	mThread;
+
+	static void* _Run(void* thread)
+	{
+		static_cast<XMLThread*>(thread)->mProc(static_cast<XMLThread*>(thread)->mArg);
+		return NULL;
+	}
+#endif
+
+	// Not copyable
+	XMLThread(const XMLThread& copy);
+	XMLThread& operator=(const XMLThread& copy);
+};
+
+}
+#endif
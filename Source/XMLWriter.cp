@@ -0,0 +1,449 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Source for XMLWriter class
+
+#include "XMLWriter.h"
+
+#include "XMLConvert.h"
+#include "XMLName.h"
+#include "XMLNode.h"
+#include "XMLStats.h"
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace xmllib;
+
+const size_t XMLWriter::cDefaultBufferSize;
+
+// Depth of namespace declarations waiting for their element
+const uint32_t cPendingDepth = 0xFFFFFFFF;
+
+XMLWriter::XMLWriter(std::ostream& os, bool indent, size_t buffer_size)
+{
+	mStream = &os;
+	mFD = -1;
+	_init(indent, buffer_size);
+}
+
+XMLWriter::XMLWriter(int fd, bool indent, size_t buffer_size)
+{
+	mStream = NULL;
+	mFD = fd;
+	_init(indent, buffer_size);
+}
+
+XMLWriter::~XMLWriter()
+{
+	Flush();
+	delete [] mBuffer;
+}
+
+void XMLWriter::_init(bool indent, size_t buffer_size)
+{
+	mIndent = indent;
+	mFailed = false;
+	mSize = (buffer_size > 0) ? buffer_size : cDefaultBufferSize;
+	mBuffer = new char[mSize];
+	mUsed = 0;
+	mDepth = 0;
+	mBaseLevel = 0;
+	mStartOpen = false;
+	mUnwritten = 0;
+	mAutoPrefix = 0;
+}
+
+const char* xmllib::cXMLDeclaration = "<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n";
+
+void XMLWriter::StartDocument()
+{
+	Write(cXMLDeclaration, ::strlen(cXMLDeclaration));
+}
+
+void XMLWriter::EndDocument()
+{
+	while(mDepth != 0)
+		EndElement();
+	Flush();
+}
+
+void XMLWriter::StartElement(const cdstring& name)
+{
+	StartElement(name, cdstring::null_str);
+}
+
+void XMLWriter::StartElement(const XMLName& name)
+{
+	StartElement(cdstring(name.Name()), (name.Namespace() != NULL) ? cdstring(name.Namespace()) : cdstring::null_str);
+}
+
+void XMLWriter::StartElement(const cdstring& name, const cdstring& namespc)
+{
+	SElement& element = OpenElement();
+
+	// Namespaces not yet declared are declared on this element with a made up prefix
+	const cdstring* prefix = NULL;
+	if (!namespc.empty())
+	{
+		prefix = FindPrefix(namespc);
+		if (prefix == NULL)
+		{
+			cdstring auto_prefix = "ns";
+			auto_prefix += cdstring(++mAutoPrefix);
+			DeclareNamespace(XMLNamespace(namespc, auto_prefix));
+			mNamespaces.back().mDepth = mDepth;
+			prefix = &mNamespaces.back().mPrefix;
+		}
+	}
+
+	element.mName.clear();
+	if ((prefix != NULL) && !prefix->empty())
+	{
+		element.mName += *prefix;
+		element.mName += ":";
+	}
+	element.mName += name;
+
+	Write('<');
+	Write(element.mName);
+	mStartOpen = true;
+}
+
+void XMLWriter::StartPrefixedElement(const cdstring& prefix, const cdstring& name)
+{
+	SElement& element = OpenElement();
+
+	// Assign rather than build a new string so the slot's storage is reused
+	if (prefix.empty())
+		element.mName = name;
+	else
+	{
+		element.mName = prefix;
+		element.mName += ":";
+		element.mName += name;
+	}
+
+	Write('<');
+	Write(element.mName);
+	mStartOpen = true;
+}
+
+// Finish off the parent's start tag and indent ready for a new element
+XMLWriter::SElement& XMLWriter::OpenElement()
+{
+	// Parent now has children
+	if (mDepth != 0)
+	{
+		SElement& parent = mElements[mDepth - 1];
+		if (mStartOpen)
+			CloseStart(">", 1);
+		if (!parent.mHasChildren)
+		{
+			Write('\n');
+			parent.mHasChildren = true;
+		}
+	}
+
+	if (mIndent)
+		WriteIndent(mDepth);
+
+	// Reuse the slot for this depth
+	if (mElements.size() == mDepth)
+		mElements.push_back(SElement());
+	SElement& element = mElements[mDepth++];
+	element.mHasChildren = false;
+
+	// Pending declarations now belong to this element
+	mUnwritten = mNamespaces.size();
+	while((mUnwritten != 0) && (mNamespaces[mUnwritten - 1].mDepth == cPendingDepth))
+		mNamespaces[--mUnwritten].mDepth = mDepth;
+
+	return element;
+}
+
+void XMLWriter::EndElement()
+{
+	if (mDepth == 0)
+		return;
+
+	SElement& element = mElements[--mDepth];
+
+	// Nothing written since the start tag so it is an empty element
+	if (mStartOpen)
+		CloseStart("/>\n", 3);
+	else
+	{
+		if (mIndent && element.mHasChildren)
+			WriteIndent(mDepth);
+
+		Write("</", 2);
+		Write(element.mName);
+		Write(">\n", 2);
+	}
+
+	// Namespaces declared on this element go out of scope
+	while(!mNamespaces.empty() && (mNamespaces.back().mDepth > mDepth))
+		mNamespaces.pop_back();
+}
+
+// Declarations are held until the next StartElement, and written after its other attributes
+void XMLWriter::DeclareNamespace(const XMLNamespace& namespc)
+{
+	SNamespaceScope scope;
+	scope.mNamespace = namespc.Name();
+	scope.mPrefix = namespc.Prefix();
+	scope.mDepth = cPendingDepth;
+	mNamespaces.push_back(scope);
+}
+
+void XMLWriter::Attribute(const cdstring& name, const char* value, size_t length)
+{
+	if (!mStartOpen)
+		return;
+
+	Write(' ');
+	Write(name);
+	Write("=\"", 2);
+	WriteEscaped(value, length);
+	Write('"');
+}
+
+// Numbers are formatted on the stack rather than into a string
+void XMLWriter::Attribute(const cdstring& name, uint32_t value)
+{
+	char buffer[cXMLMaxValueLength];
+	Attribute(name, buffer, XMLFormatValue(value, buffer));
+}
+
+void XMLWriter::Attribute(const cdstring& name, int32_t value)
+{
+	char buffer[cXMLMaxValueLength];
+	Attribute(name, buffer, XMLFormatValue(value, buffer));
+}
+
+void XMLWriter::Attribute(const cdstring& name, uint64_t value)
+{
+	char buffer[cXMLMaxValueLength];
+	Attribute(name, buffer, XMLFormatValue(value, buffer));
+}
+
+void XMLWriter::Attribute(const cdstring& name, int64_t value)
+{
+	char buffer[cXMLMaxValueLength];
+	Attribute(name, buffer, XMLFormatValue(value, buffer));
+}
+
+void XMLWriter::Attribute(const cdstring& name, double value)
+{
+	char buffer[cXMLMaxValueLength];
+	Attribute(name, buffer, XMLFormatValue(value, buffer));
+}
+
+void XMLWriter::Attribute(const cdstring& name, bool value)
+{
+	Attribute(name, value ? cXMLValueTrue : cXMLValueFalse);
+}
+
+void XMLWriter::Text(const char* text, size_t length)
+{
+	if ((mDepth == 0) || (length == 0))
+		return;
+
+	if (mStartOpen)
+		CloseStart(">", 1);
+
+	WriteEscaped(text, length);
+}
+
+bool XMLWriter::Flush()
+{
+	FlushBuffer();
+	if ((mStream != NULL) && !mFailed)
+		mStream->flush();
+
+	return !mFailed;
+}
+
+void XMLWriter::Reserve(size_t size)
+{
+	if (size <= mSize)
+		return;
+
+	char* buffer = new char[size];
+	::memcpy(buffer, mBuffer, mUsed);
+	delete [] mBuffer;
+	mBuffer = buffer;
+	mSize = size;
+}
+
+void XMLWriter::FlushBuffer()
+{
+	if (mUsed != 0)
+	{
+		WriteOut(mBuffer, mUsed);
+		mUsed = 0;
+	}
+}
+
+void XMLWriter::Write(const char* data, size_t length)
+{
+	// Copy into the buffer, writing large blocks straight through
+	if (length > mSize - mUsed)
+	{
+		FlushBuffer();
+		if (length >= mSize)
+		{
+			WriteOut(data, length);
+			return;
+		}
+	}
+
+	::memcpy(mBuffer + mUsed, data, length);
+	mUsed += length;
+}
+
+// Runs of characters that need no escaping are copied in one go
+void XMLWriter::WriteEscaped(const char* data, size_t length)
+{
+	const char* p = data;
+	const char* end = data + length;
+	const char* q = p;
+	while(q < end)
+	{
+		if (cXMLReserved[(unsigned char) *q] == 1)
+		{
+			if (q > p)
+				Write(p, q - p);
+
+			switch(*q)
+			{
+			case '"':
+				Write("&quot;", 6);
+				break;
+			case '&':
+				Write("&amp;", 5);
+				break;
+			case '\'':
+				Write("&apos;", 6);
+				break;
+			case '<':
+				Write("&lt;", 4);
+				break;
+			case '>':
+				Write("&gt;", 4);
+				break;
+			}
+			p = ++q;
+		}
+		else
+			q++;
+	}
+
+	if (q > p)
+		Write(p, q - p);
+}
+
+// Finish the start tag with its namespace declarations
+void XMLWriter::CloseStart(const char* close, size_t length)
+{
+	// Stop at declarations made for the next element
+	for(; (mUnwritten < mNamespaces.size()) && (mNamespaces[mUnwritten].mDepth != cPendingDepth); mUnwritten++)
+	{
+		const SNamespaceScope& scope = mNamespaces[mUnwritten];
+
+		// An empty prefix declares the default namespace
+		Write(" xmlns", 6);
+		if (!scope.mPrefix.empty())
+		{
+			Write(':');
+			Write(scope.mPrefix);
+		}
+		Write("=\"", 2);
+		WriteEscaped(scope.mNamespace.c_str(), scope.mNamespace.length());
+		Write('"');
+	}
+
+	Write(close, length);
+	mStartOpen = false;
+}
+
+const char cTabs[] = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+const uint32_t cTabsLength = sizeof(cTabs) - 1;
+
+// Indent in runs of tabs rather than one at a time
+void XMLWriter::WriteIndent(uint32_t level)
+{
+	level += mBaseLevel;
+	while(level > cTabsLength)
+	{
+		Write(cTabs, cTabsLength);
+		level -= cTabsLength;
+	}
+	Write(cTabs, level);
+}
+
+bool XMLWriter::WriteOut(const char* data, size_t length)
+{
+	if (mFailed)
+		return false;
+
+	XMLLIB_STATS_COUNT(eBytesGenerated, length);
+	if (mStream != NULL)
+	{
+		mStream->write(data, length);
+		mFailed = !mStream->good();
+		return !mFailed;
+	}
+
+	while(length != 0)
+	{
+#if defined(_WIN32)
+		int written = ::_write(mFD, data, length);
+#else
+		ssize_t written = ::write(mFD, data, length);
+#endif
+		if (written < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			mFailed = true;
+			return false;
+		}
+		data += written;
+		length -= written;
+	}
+
+	return true;
+}
+
+const cdstring* XMLWriter::FindPrefix(const cdstring& namespc) const
+{
+	// Innermost declaration wins
+	for(std::vector<SNamespaceScope>::const_reverse_iterator iter = mNamespaces.rbegin(); iter != mNamespaces.rend(); iter++)
+	{
+		if ((*iter).mNamespace == namespc)
+			return &(*iter).mPrefix;
+	}
+
+	return NULL;
+}
@@ -0,0 +1,159 @@
+/*
+    Copyright (c) 2007 Cyrus Daboo. All rights reserved.
+    
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Header for XMLWriter class
+
+#ifndef __XMLWRITER__XMLLIB__
+#define __XMLWRITER__XMLLIB__
+
+#include "XMLNamespace.h"
+
+#include <stdint.h>
+#include <ostream>
+#include <vector>
+
+#include "cdstring.h"
+
+namespace xmllib
+{
+
+class XMLName;
+
+extern const char* cXMLDeclaration;
+
+// Writes XML directly to a file descriptor or stream without building a document. Output is
+// collected in a large buffer and written out in big chunks. The layout matches
+// XMLDocument::Generate when text is written after an element's children, as Generate does.
+//
+// Attributes must directly follow the StartElement they belong to, whereas namespace
+// declarations come just before it.
+
+class XMLWriter
+{
+public:
+	static const size_t cDefaultBufferSize = 64 * 1024;
+
+	XMLWriter(std::ostream& os, bool indent = true, size_t buffer_size = cDefaultBufferSize);
+	XMLWriter(int fd, bool indent = true, size_t buffer_size = cDefaultBufferSize);
+	~XMLWriter();
+
+	void StartDocument();
+	void EndDocument();							// Closes open elements and flushes
+
+	void StartElement(const char* name)
+		{ StartElement(cdstring(name)); }
+	void StartElement(const cdstring& name);
+	void StartElement(const cdstring& name, const cdstring& namespc);
+	void StartElement(const XMLName& name);
+	void EndElement();
+
+	// Writes prefix:name as given, for callers that manage namespace prefixes themselves
+	void StartPrefixedElement(const cdstring& prefix, const cdstring& name);
+
+	// Declares xmlns:prefix (or xmlns for an empty prefix) on the next element to be started,
+	// in scope until that element ends
+	void DeclareNamespace(const XMLNamespace& namespc);
+
+	void Attribute(const cdstring& name, const cdstring& value)
+		{ Attribute(name, value.c_str(), value.length()); }
+	void Attribute(const cdstring& name, const char* value)
+		{ Attribute(name, value, (value != NULL) ? ::strlen(value) : 0); }
+	void Attribute(const cdstring& name, const char* value, size_t length);
+	void Attribute(const cdstring& name, uint32_t value);
+	void Attribute(const cdstring& name, int32_t value);
+	void Attribute(const cdstring& name, uint64_t value);
+	void Attribute(const cdstring& name, int64_t value);
+	void Attribute(const cdstring& name, double value);
+	void Attribute(const cdstring& name, bool value);
+
+	void Text(const cdstring& text)
+		{ Text(text.c_str(), text.length()); }
+	void Text(const char* text, size_t length);
+
+	// False once any write to the output has failed
+	bool Flush();
+	bool Good() const
+		{ return !mFailed; }
+
+	// Grow the buffer so that this much output is held before anything is written out
+	void Reserve(size_t size);
+
+	uint32_t Depth() const
+		{ return mDepth; }
+
+	// Indent as if nested this deep, for writing a fragment of a larger document
+	void SetBaseLevel(uint32_t level)
+		{ mBaseLevel = level; }
+
+private:
+	struct SElement
+	{
+		cdstring		mName;				// Name as written, including any prefix
+		bool			mHasChildren;
+	};
+
+	struct SNamespaceScope
+	{
+		cdstring		mNamespace;
+		cdstring		mPrefix;
+		uint32_t		mDepth;				// Depth of the element declaring it
+	};
+
+	std::ostream*		mStream;
+	int					mFD;
+	bool				mIndent;
+	bool				mFailed;
+
+	char*				mBuffer;
+	size_t				mSize;
+	size_t				mUsed;
+
+	std::vector<SElement>	mElements;		// Never shrunk so names are reused
+	uint32_t			mDepth;
+	uint32_t			mBaseLevel;
+	bool				mStartOpen;			// Start tag still waiting for '>' or '/>'
+	std::vector<SNamespaceScope>	mNamespaces;
+	size_t				mUnwritten;			// First declaration not yet written out
+	uint32_t			mAutoPrefix;
+
+	void _init(bool indent, size_t buffer_size);
+
+	void FlushBuffer();
+
+	void Write(const char* data, size_t length);
+	void Write(char c)
+	{
+		if (mUsed == mSize)
+			FlushBuffer();
+		mBuffer[mUsed++] = c;
+	}
+	void Write(const cdstring& data)
+		{ Write(data.c_str(), data.length()); }
+	void WriteEscaped(const char* data, size_t length);
+	void WriteIndent(uint32_t level);
+	bool WriteOut(const char* data, size_t length);
+
+	SElement& OpenElement();
+	void CloseStart(const char* close, size_t length);
+	const cdstring* FindPrefix(const cdstring& namespc) const;
+
+	// Not copyable
+	XMLWriter(const XMLWriter& copy);
+	XMLWriter& operator=(const XMLWriter& copy);
+};
+
+}
+#endif